@@ -5549,9 +5549,11 @@ Target_aarch64<size, big_endian>::do_relax(
       aarch64_relobj->scan_sections_for_stubs(this, symtab, layout);
     }
 
+  // Update every stub table whose size changed, not just the first
+  // one, so that the next pass sees all of the new sizes at once.
   bool any_stub_table_changed = false;
   for (Stub_table_iterator siter = this->stub_tables_.begin();
-       siter != this->stub_tables_.end() && !any_stub_table_changed; ++siter)
+       siter != this->stub_tables_.end(); ++siter)
     {
       The_stub_table* stub_table = *siter;
       if (stub_table->update_data_size_changed_p())
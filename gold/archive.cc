@@ -26,6 +26,7 @@
 #include <cstring>
 #include <climits>
 #include <vector>
+#include <algorithm>
 #include "libiberty.h"
 #include "filenames.h"
 
@@ -40,6 +41,7 @@
 #include "archive.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -178,6 +180,14 @@ struct Archive::Archive_header
 unsigned int Archive::total_archives;
 unsigned int Archive::total_members;
 unsigned int Archive::total_members_loaded;
+unsigned int Archive::total_members_preread;
+unsigned int Archive::total_members_discarded;
+
+// When reading the symbols of archive members in advance with more
+// than one thread, we divide the members of an archive among threads
+// if there are at least this many to read.
+
+static const size_t archive_parallel_min_members = 16;
 
 // Archive methods.
 
@@ -199,7 +209,9 @@ Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
   : Library_base(task), name_(name), input_file_(input_file), armap_(),
     armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
-    members_(), is_thin_archive_(is_thin_archive), included_member_(false),
+    members_(), num_members_preread_(0), preread_files_(),
+    is_thin_archive_(is_thin_archive),
+    included_member_(false),
     nested_archives_(), dirpath_(dirpath), num_members_(0),
     included_all_members_(false)
 {
@@ -207,6 +219,70 @@ Archive::Archive(const std::string& name, Input_file* input_file,
     parameters->options().check_excluded_libs(input_file->found_name());
 }
 
+// RAII class to make sure that the file of an archive member whose
+// symbols were read in advance is locked while we use the views in
+// its Read_symbols_data.  The file is normally the archive file,
+// which is already locked by the task adding the archive symbols, but
+// it may be another Input_file opened by read_symbols_in_parallel, or
+// the archive may be being deleted by a task which does not hold it.
+
+class Archive_member_locker
+{
+ public:
+  Archive_member_locker(const Task* task, Object* obj)
+    : task_(task), obj_(obj), locked_(!obj->is_locked())
+  {
+    if (this->locked_)
+      this->obj_->lock(this->task_);
+  }
+
+  ~Archive_member_locker()
+  {
+    if (this->locked_)
+      this->obj_->unlock(this->task_);
+  }
+
+ private:
+  Archive_member_locker(const Archive_member_locker&);
+  Archive_member_locker& operator=(const Archive_member_locker&);
+
+  const Task* task_;
+  Object* obj_;
+  bool locked_;
+};
+
+// Discard any members whose symbols we read in advance but which
+// were never included in the link.
+
+Archive::~Archive()
+{
+  for (std::map<off_t, Archive_member>::iterator p = this->members_.begin();
+       p != this->members_.end();
+       ++p)
+    {
+      Object* obj = p->second.obj_;
+      if (obj == NULL)
+	continue;
+      {
+	Archive_member_locker locker(this->task_, obj);
+	delete p->second.sd_;
+      }
+      delete obj;
+      ++Archive::total_members_discarded;
+    }
+  Archive::total_members_preread += this->num_members_preread_;
+
+  // An object keeps a pointer to the Input_file it was read from, so
+  // we can only delete the extra files which no included member uses.
+  // Deleting a file closes its descriptor.
+  for (std::vector<Input_file*>::const_iterator p =
+	 this->preread_files_.begin();
+       p != this->preread_files_.end();
+       ++p)
+    if ((*p)->file().object_count() == 0)
+      delete *p;
+}
+
 // Set up the archive: read the symbol map and the extended name
 // table.
 
@@ -731,15 +807,43 @@ Archive::get_elf_object_for_member(off_t off, bool* punconfigured)
   return obj;
 }
 
-// Read the symbols from all the archive members in the link.
+// Read the symbols from all the archive members in the link.  This
+// is done when the archive is first read, before the symbols of the
+// files which precede it on the command line have been added to the
+// symbol table, so we don't yet know which members will be needed.
+// The members which turn out not to be needed are discarded when the
+// archive is deleted.
 
 void
 Archive::read_all_symbols()
 {
-  for (Archive::const_iterator p = this->begin();
-       p != this->end();
+  if (this->input_file_->options().whole_archive())
+    {
+      for (Archive::const_iterator p = this->begin();
+	   p != this->end();
+	   ++p)
+	this->read_symbols(p->off);
+      return;
+    }
+
+  // Only a member which defines a symbol in the archive map can be
+  // included, so don't bother reading any other.
+  std::vector<off_t> offsets;
+  offsets.reserve(this->armap_.size());
+  for (std::vector<Armap_entry>::const_iterator p = this->armap_.begin();
+       p != this->armap_.end();
+       ++p)
+    offsets.push_back(p->file_offset);
+  std::sort(offsets.begin(), offsets.end());
+  offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+  if (this->read_symbols_in_parallel(offsets))
+    return;
+
+  for (std::vector<off_t>::const_iterator p = offsets.begin();
+       p != offsets.end();
        ++p)
-    this->read_symbols(p->off);
+    this->read_symbols(*p);
 }
 
 // Read the symbols from an archive member in the link.  OFF is the file
@@ -756,6 +860,162 @@ Archive::read_symbols(off_t off)
   obj->read_symbols(sd);
   Archive_member member(obj, sd);
   this->members_[off] = member;
+  ++this->num_members_preread_;
+
+  // If the object is an external member of a thin archive, it was
+  // locked when it was opened.  Unlock it so that the tasks which use
+  // it can lock it.
+  if (obj->offset() == 0)
+    obj->unlock(this->task_);
+}
+
+// A member of an archive whose symbols are being read in parallel.
+
+struct Archive_preread_member
+{
+  Archive_preread_member(off_t member_off, off_t member_memoff,
+			 const std::string& member_name)
+    : off(member_off), memoff(member_memoff), name(member_name), obj(NULL),
+      sd(NULL)
+  { }
+
+  // The file offset of the member header.
+  off_t off;
+  // The file offset of the member contents.
+  off_t memoff;
+  // The name to use for the object.
+  std::string name;
+  // The object, or NULL if it could not be read.
+  Object* obj;
+  // The symbols read from the object.
+  Read_symbols_data* sd;
+};
+
+// Read the symbols of archive members in parallel.  Each piece reads
+// a contiguous range of the members through its own Input_file, since
+// a File_read may only be used by one thread at a time.
+
+class Archive_preread_work : public Parallel_work
+{
+ public:
+  Archive_preread_work(std::vector<Archive_preread_member>* members,
+		       const std::vector<Input_file*>& files, bool no_export)
+    : members_(members), files_(files), no_export_(no_export)
+  { }
+
+  void
+  run_piece(size_t i);
+
+ private:
+  std::vector<Archive_preread_member>* members_;
+  const std::vector<Input_file*>& files_;
+  bool no_export_;
+};
+
+// Read piece I.  Members which are not ELF objects for the target
+// are left alone here; if they are needed, include_member will read
+// them again and report the problem just as if we had not read them
+// in advance.
+
+void
+Archive_preread_work::run_piece(size_t i)
+{
+  Input_file* input_file = this->files_[i];
+  const size_t pieces = this->files_.size();
+  const size_t count = this->members_->size();
+  for (size_t j = i * count / pieces; j < (i + 1) * count / pieces; ++j)
+    {
+      Archive_preread_member& m((*this->members_)[j]);
+      const unsigned char* ehdr;
+      int read_size;
+      if (!is_elf_object(input_file, m.memoff, &ehdr, &read_size))
+	continue;
+      bool unconfigured;
+      Object* obj = make_elf_object(m.name, input_file, m.memoff, ehdr,
+				    read_size, &unconfigured);
+      if (obj == NULL)
+	continue;
+      obj->set_no_export(this->no_export_);
+      m.sd = new Read_symbols_data;
+      obj->read_symbols(m.sd);
+      m.obj = obj;
+    }
+}
+
+// Read the symbols from the members at OFFSETS, using all available
+// threads.
+
+bool
+Archive::read_symbols_in_parallel(const std::vector<off_t>& offsets)
+{
+  // The members of a thin archive are opened by get_file_and_offset,
+  // which we must not call from more than one thread.
+  size_t pieces = parallel_thread_count();
+  if (pieces <= 1
+      || this->is_thin_archive_
+      || offsets.size() < archive_parallel_min_members)
+    return false;
+
+  // The member headers are read through our own file, so read them
+  // all here.
+  std::vector<Archive_preread_member> members;
+  members.reserve(offsets.size());
+  for (std::vector<off_t>::const_iterator p = offsets.begin();
+       p != offsets.end();
+       ++p)
+    {
+      std::string member_name;
+      off_t nested_off;
+      if (this->read_header(*p, false, &member_name, &nested_off) == -1)
+	continue;
+      off_t memoff = *p + static_cast<off_t>(sizeof(Archive_header));
+      members.push_back(Archive_preread_member(*p, memoff,
+					       (this->input_file_->filename()
+						+ "(" + member_name + ")")));
+    }
+
+  // The first piece runs in this thread and uses our own file.  The
+  // other pieces open the file again.  We keep those files in
+  // preread_files_ so that the destructor can free them.
+  if (pieces > members.size())
+    pieces = members.size();
+  std::vector<Input_file*> files;
+  files.push_back(this->input_file_);
+  while (files.size() < pieces)
+    {
+      Input_file* input_file =
+	new Input_file(this->input_file_->input_file_argument());
+      if (!input_file->open_again(this->input_file_, this->task_))
+	{
+	  delete input_file;
+	  break;
+	}
+      files.push_back(input_file);
+    }
+
+  Archive_preread_work work(&members, files, this->no_export());
+  run_parallel_work(&work, files.size());
+
+  for (std::vector<Archive_preread_member>::const_iterator p =
+	 members.begin();
+       p != members.end();
+       ++p)
+    {
+      if (p->obj == NULL)
+	continue;
+      this->members_[p->off] = Archive_member(p->obj, p->sd);
+      ++this->num_members_preread_;
+    }
+
+  // Like the archive itself, the other files are unlocked so that the
+  // tasks which use the objects can lock them.
+  for (size_t i = 1; i < files.size(); ++i)
+    {
+      files[i]->file().unlock(this->task_);
+      this->preread_files_.push_back(files[i]);
+    }
+
+  return true;
 }
 
 // Select members from the archive and add them to the link.  We walk
@@ -991,21 +1251,32 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
 {
   ++Archive::total_members_loaded;
 
-  std::map<off_t, Archive_member>::const_iterator p = this->members_.find(off);
+  std::map<off_t, Archive_member>::iterator p = this->members_.find(off);
   if (p != this->members_.end())
     {
       Object* obj = p->second.obj_;
+      gold_assert(obj != NULL);
 
       Read_symbols_data* sd = p->second.sd_;
+      p->second.obj_ = NULL;
+      p->second.sd_ = NULL;
       if (mapfile != NULL)
         mapfile->report_include_archive_member(obj->name(), sym, why);
-      if (input_objects->add_object(obj))
-        {
-          obj->layout(symtab, layout, sd);
-          obj->add_symbols(symtab, sd, layout);
-	  this->included_member_ = true;
-        }
-      delete sd;
+      bool added = input_objects->add_object(obj);
+      {
+	Archive_member_locker locker(this->task_, obj);
+	if (added)
+	  {
+	    if (layout->incremental_inputs() != NULL)
+	      layout->incremental_inputs()->report_object(obj, 0, this, NULL);
+	    obj->layout(symtab, layout, sd);
+	    obj->add_symbols(symtab, sd, layout);
+	    this->included_member_ = true;
+	  }
+	delete sd;
+      }
+      if (!added)
+	delete obj;
       return true;
     }
 
@@ -1087,6 +1358,14 @@ Archive::print_stats()
           program_name, Archive::total_members);
   fprintf(stderr, _("%s: loaded archive members: %u\n"),
           program_name, Archive::total_members_loaded);
+  if (Archive::total_members_preread > 0)
+    {
+      fprintf(stderr, _("%s: archive members read in advance: %u\n"),
+	      program_name, Archive::total_members_preread);
+      fprintf(stderr, _("%s: archive members read in advance but not "
+			"needed: %u\n"),
+	      program_name, Archive::total_members_discarded);
+    }
 }
 
 // Add_archive_symbols methods.
@@ -165,6 +165,8 @@ class Archive : public Library_base
   Archive(const std::string& name, Input_file* input_file,
           bool is_thin_archive, Dirsearch* dirpath, Task* task);
 
+  ~Archive();
+
   // The length of the magic string at the start of an archive.
   static const int sarmag = 8;
 
@@ -286,6 +288,10 @@ class Archive : public Library_base
   static unsigned int total_members;
   // Number of archive members loaded.
   static unsigned int total_members_loaded;
+  // Number of archive members whose symbols were read in advance.
+  static unsigned int total_members_preread;
+  // Number of members read in advance which were not needed.
+  static unsigned int total_members_discarded;
 
   // Get a view into the underlying file.
   const unsigned char*
@@ -331,6 +337,12 @@ class Archive : public Library_base
   void
   read_symbols(off_t off);
 
+  // Read the symbols from the archive members at the offsets in
+  // OFFSETS, dividing them among threads.  Return false if that is
+  // not possible, in which case nothing has been read.
+  bool
+  read_symbols_in_parallel(const std::vector<off_t>& offsets);
+
   // Include all the archive members in the link.
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
@@ -395,8 +407,14 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
-  // Table of objects whose symbols have been pre-read.
+  // Table of objects whose symbols have been pre-read.  Once an
+  // object is included in the link, its entry is cleared.
   std::map<off_t, Archive_member> members_;
+  // Number of members whose symbols have been pre-read.
+  unsigned int num_members_preread_;
+  // The extra files opened by read_symbols_in_parallel.  Those which
+  // no included member uses are deleted with the archive.
+  std::vector<Input_file*> preread_files_;
   // True if this is a thin archive.
   const bool is_thin_archive_;
   // True if we have included at least one object from this archive.
@@ -12466,11 +12466,14 @@ Target_arm<big_endian>::do_relax(
 
   // Check all stub tables to see if any of them have their data sizes
   // or addresses alignments changed.  These are the only things that
-  // matter.
+  // matter.  Update every stub table that changed, not just the first
+  // one, so that the next pass sees all of the new sizes at once.
+  // Only the output sections holding those stub tables need their
+  // input section offsets adjusted.
   bool any_stub_table_changed = false;
   Unordered_set<const Output_section*> sections_needing_adjustment;
   for (Stub_table_iterator sp = this->stub_tables_.begin();
-       (sp != this->stub_tables_.end()) && !any_stub_table_changed;
+       sp != this->stub_tables_.end();
        ++sp)
     {
       if ((*sp)->update_data_size_and_addralign())
@@ -12507,8 +12510,8 @@ Target_arm<big_endian>::do_relax(
   if (!continue_relaxation)
     {
       for (Stub_table_iterator sp = this->stub_tables_.begin();
-	   (sp != this->stub_tables_.end()) && !any_stub_table_changed;
-	    ++sp)
+	   sp != this->stub_tables_.end();
+	   ++sp)
 	(*sp)->finalize_stubs();
 
       // Update output local symbol counts of objects if necessary.
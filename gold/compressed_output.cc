@@ -22,54 +22,312 @@
 
 #include "gold.h"
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "parameters.h"
 #include "options.h"
+#include "gold-threads.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
-// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
-// if it successfully compressed, false if it failed for any reason
-// (including not having zlib support in the library).  If it returns
-// true, it allocates memory for the compressed data using new, and
-// sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
-// It also writes a header before COMPRESSED_DATA: 4 bytes saying
-// "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
-// order.
+// The ways in which we can compress a section.
 
-static bool
-zlib_compress(int header_size,
-              const unsigned char* uncompressed_data,
-              unsigned long uncompressed_size,
-              unsigned char** compressed_data,
-              unsigned long* compressed_size)
+enum Compression_method
+{
+  COMPRESS_ZLIB,
+  COMPRESS_ZSTD
+};
+
+// When using threads, we compress sections in chunks of this many
+// bytes.  The chunk size does not depend on the number of threads, so
+// the output does not either.
+
+static const unsigned long compress_chunk_size = 1024 * 1024;
+
+// Return the compression level to use for METHOD.
+
+static int
+compression_level(Compression_method method)
 {
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
+  int level = parameters->options().compress_level();
+  if (level != 0)
+    return level;
+  if (method == COMPRESS_ZSTD)
+    return parameters->options().optimize() >= 1 ? 12 : 3;
+  return parameters->options().optimize() >= 1 ? 9 : 1;
+}
 
-  int compress_level;
-  if (parameters->options().optimize() >= 1)
-    compress_level = 9;
+// Compress a buffer in independent chunks, possibly in parallel.
+//
+// For zlib, each chunk is a raw deflate stream which uses the end of
+// the previous chunk as a preset dictionary.  Every chunk but the last
+// ends with a sync flush, which leaves the stream byte aligned without
+// marking the final block.  So the concatenation of the chunks, with a
+// zlib header in front and the combined Adler-32 checksum after, is a
+// single valid zlib stream.
+//
+// For zstd, each chunk is a separate frame.  A zstd stream may consist
+// of several concatenated frames.
+
+class Compress_chunks : public Parallel_work
+{
+ public:
+  Compress_chunks(Compression_method method, int level,
+		  const unsigned char* data, unsigned long size,
+		  unsigned long chunk_size)
+    : method_(method), level_(level), data_(data), size_(size),
+      chunk_size_(chunk_size),
+      chunks_(size == 0 ? 1 : (size + chunk_size - 1) / chunk_size)
+  { }
+
+  ~Compress_chunks()
+  {
+    for (size_t i = 0; i < this->chunks_.size(); ++i)
+      delete[] this->chunks_[i].data;
+  }
+
+  // The number of chunks.
+  size_t
+  chunk_count() const
+  { return this->chunks_.size(); }
+
+  // Compress chunk I.
+  void
+  run_piece(size_t i);
+
+  // Gather the compressed chunks into a buffer allocated with new,
+  // leaving HEADER_SIZE bytes in front for the caller.  Returns false
+  // if any chunk failed to compress.
+  bool
+  finish(int header_size, unsigned char** compressed_data,
+	 unsigned long* compressed_size);
+
+ private:
+  // A compressed chunk.
+  struct Chunk
+  {
+    Chunk()
+      : data(NULL), size(0), adler(0)
+    { }
+
+    // The compressed data, or NULL if compression failed.
+    unsigned char* data;
+    // The size of the compressed data.
+    unsigned long size;
+    // For zlib, the Adler-32 checksum of the uncompressed chunk.
+    unsigned long adler;
+  };
+
+  void
+  compress_zlib(const unsigned char* in, unsigned long offset,
+		unsigned long len, bool last, Chunk* chunk);
+
+#ifdef HAVE_ZSTD
+  void
+  compress_zstd(const unsigned char* in, unsigned long len, Chunk* chunk);
+#endif
+
+  // The compression method.
+  Compression_method method_;
+  // The compression level.
+  int level_;
+  // The data to compress.
+  const unsigned char* data_;
+  // The size of the data to compress.
+  unsigned long size_;
+  // The size of each chunk but the last.
+  unsigned long chunk_size_;
+  // The compressed chunks.
+  std::vector<Chunk> chunks_;
+};
+
+void
+Compress_chunks::run_piece(size_t i)
+{
+  unsigned long offset = i * this->chunk_size_;
+  unsigned long len = std::min(this->chunk_size_, this->size_ - offset);
+  const unsigned char* in = this->data_ + offset;
+  Chunk* chunk = &this->chunks_[i];
+  if (this->method_ == COMPRESS_ZLIB)
+    this->compress_zlib(in, offset, len, i + 1 == this->chunks_.size(),
+			chunk);
   else
-    compress_level = 1;
-
-  int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
-                     compressed_size,
-                     reinterpret_cast<const Bytef*>(uncompressed_data),
-                     uncompressed_size,
-                     compress_level);
-  if (rc == Z_OK)
     {
-      *compressed_size += header_size;
-      return true;
+#ifdef HAVE_ZSTD
+      this->compress_zstd(in, len, chunk);
+#else
+      gold_unreachable();
+#endif
+    }
+}
+
+// Compress LEN bytes at IN, which are at OFFSET in the buffer, as a raw
+// deflate stream.
+
+void
+Compress_chunks::compress_zlib(const unsigned char* in, unsigned long offset,
+			       unsigned long len, bool last, Chunk* chunk)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  if (deflateInit2(&strm, this->level_, Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+
+  // Let the compressor refer back into the previous chunk, as it
+  // would if it were compressing the whole buffer at once.
+  if (offset > 0)
+    {
+      unsigned long dict_len = std::min(offset, 1UL << MAX_WBITS);
+      deflateSetDictionary(&strm, const_cast<Bytef*>(in - dict_len),
+			   dict_len);
     }
+
+  // Leave room for the empty stored block written by a sync flush.
+  unsigned long bound = deflateBound(&strm, len) + 16;
+  chunk->data = new unsigned char[bound];
+
+  strm.next_in = const_cast<Bytef*>(in);
+  strm.avail_in = len;
+  strm.next_out = chunk->data;
+  strm.avail_out = bound;
+  int rc = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok;
+  if (last)
+    ok = rc == Z_STREAM_END;
   else
+    ok = rc == Z_OK && strm.avail_in == 0 && strm.avail_out > 0;
+  deflateEnd(&strm);
+
+  if (!ok)
     {
-      delete[] *compressed_data;
-      *compressed_data = NULL;
-      return false;
+      delete[] chunk->data;
+      chunk->data = NULL;
+      return;
+    }
+  chunk->size = bound - strm.avail_out;
+  chunk->adler = adler32(adler32(0L, Z_NULL, 0), in, len);
+}
+
+#ifdef HAVE_ZSTD
+
+// Compress LEN bytes at IN as a zstd frame.
+
+void
+Compress_chunks::compress_zstd(const unsigned char* in, unsigned long len,
+			       Chunk* chunk)
+{
+  size_t bound = ZSTD_compressBound(len);
+  chunk->data = new unsigned char[bound];
+  size_t rc = ZSTD_compress(chunk->data, bound, in, len, this->level_);
+  if (ZSTD_isError(rc))
+    {
+      delete[] chunk->data;
+      chunk->data = NULL;
+      return;
     }
+  chunk->size = rc;
+}
+
+#endif // defined(HAVE_ZSTD)
+
+bool
+Compress_chunks::finish(int header_size, unsigned char** compressed_data,
+			unsigned long* compressed_size)
+{
+  const bool is_zlib = this->method_ == COMPRESS_ZLIB;
+
+  // The zlib stream header and the Adler-32 trailer.
+  unsigned long size = header_size + (is_zlib ? 2 + 4 : 0);
+  for (size_t i = 0; i < this->chunks_.size(); ++i)
+    {
+      if (this->chunks_[i].data == NULL)
+	return false;
+      size += this->chunks_[i].size;
+    }
+
+  unsigned char* out = new unsigned char[size];
+  memset(out, 0, header_size);
+  unsigned char* p = out + header_size;
+
+  if (is_zlib)
+    {
+      // This is the header which deflate itself would write: deflate
+      // with a 32K window, and a hint of how hard we tried.
+      int level_flags;
+      if (this->level_ < 2)
+	level_flags = 0;
+      else if (this->level_ < 6)
+	level_flags = 1;
+      else if (this->level_ == 6)
+	level_flags = 2;
+      else
+	level_flags = 3;
+      unsigned int zhdr = (0x78 << 8) | (level_flags << 6);
+      zhdr += 31 - (zhdr % 31);
+      elfcpp::Swap_unaligned<16, true>::writeval(p, zhdr);
+      p += 2;
+    }
+
+  unsigned long adler = 0;
+  for (size_t i = 0; i < this->chunks_.size(); ++i)
+    {
+      const Chunk& chunk(this->chunks_[i]);
+      memcpy(p, chunk.data, chunk.size);
+      p += chunk.size;
+      if (i == 0)
+	adler = chunk.adler;
+      else
+	{
+	  unsigned long offset = i * this->chunk_size_;
+	  unsigned long len = std::min(this->chunk_size_,
+				       this->size_ - offset);
+	  adler = adler32_combine(adler, chunk.adler, len);
+	}
+    }
+
+  if (is_zlib)
+    {
+      elfcpp::Swap_unaligned<32, true>::writeval(p, adler);
+      p += 4;
+    }
+  gold_assert(p == out + size);
+
+  *compressed_data = out;
+  *compressed_size = size;
+  return true;
+}
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE using METHOD.
+// Returns true if it successfully compressed, false if it failed for
+// any reason.  If it returns true, it allocates memory for the
+// compressed data using new, and sets *COMPRESSED_DATA and
+// *COMPRESSED_SIZE to appropriate values.  It leaves HEADER_SIZE bytes
+// at the start of *COMPRESSED_DATA for the caller to fill in.
+
+static bool
+compress_section_data(Compression_method method,
+		      int header_size,
+		      const unsigned char* uncompressed_data,
+		      unsigned long uncompressed_size,
+		      unsigned char** compressed_data,
+		      unsigned long* compressed_size)
+{
+  int compress_level = compression_level(method);
+
+  // Without threads, compress the whole section in one chunk.
+  unsigned long chunk_size = uncompressed_size;
+  if (parameters->options().threads()
+      && uncompressed_size > compress_chunk_size)
+    chunk_size = compress_chunk_size;
+
+  Compress_chunks work(method, compress_level, uncompressed_data,
+		       uncompressed_size, chunk_size);
+  run_parallel_work(&work, work.chunk_count());
+  return work.finish(header_size, compressed_data, compressed_size);
 }
 
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
@@ -115,6 +373,25 @@ zlib_decompress(const unsigned char* compressed_data,
   return true;
 }
 
+#ifdef HAVE_ZSTD
+
+// Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, which is one or
+// more zstd frames, into a buffer UNCOMPRESSED_DATA of size
+// UNCOMPRESSED_SIZE.  Returns true if it decompressed successfully.
+
+static bool
+zstd_decompress(const unsigned char* compressed_data,
+		unsigned long compressed_size,
+		unsigned char* uncompressed_data,
+		unsigned long uncompressed_size)
+{
+  size_t rc = ZSTD_decompress(uncompressed_data, uncompressed_size,
+			      compressed_data, compressed_size);
+  return !ZSTD_isError(rc) && rc == uncompressed_size;
+}
+
+#endif // defined(HAVE_ZSTD)
+
 // Read the compression header of a compressed debug section and return
 // the uncompressed size.
 
@@ -148,20 +425,19 @@ decompress_input_section(const unsigned char* compressed_data,
   if ((sh_flags & elfcpp::SHF_COMPRESSED) != 0)
     {
       unsigned int compression_header_size;
+      elfcpp::Elf_Word ch_type;
       if (size == 32)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<32, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<32, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else if (size == 64)
@@ -170,23 +446,30 @@ decompress_input_section(const unsigned char* compressed_data,
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<64, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<64, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else
 	gold_unreachable();
 
-      return zlib_decompress(compressed_data + compression_header_size,
-			     compressed_size - compression_header_size,
-			     uncompressed_data,
-			     uncompressed_size);
+      if (ch_type == elfcpp::ELFCOMPRESS_ZLIB)
+	return zlib_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#ifdef HAVE_ZSTD
+      if (ch_type == elfcpp::ELFCOMPRESS_ZSTD)
+	return zstd_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#endif
+      return false;
     }
 
   const unsigned int zlib_header_size = 12;
@@ -230,15 +513,19 @@ Output_compressed_section::set_final_data_size()
   this->write_to_postprocessing_buffer();
 
   bool success = false;
-  enum { none, gnu_zlib, gabi_zlib } compress;
+  enum { none, gnu_zlib, gabi_zlib, gabi_zstd } compress;
   int compression_header_size = 12;
   const int size = parameters->target().get_size();
   if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
     compress = gnu_zlib;
   else if (strcmp(this->options_->compress_debug_sections(), "zlib-gabi") == 0
-	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
+	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0
+	   || strcmp(this->options_->compress_debug_sections(), "zstd") == 0)
     {
-      compress = gabi_zlib;
+      if (strcmp(this->options_->compress_debug_sections(), "zstd") == 0)
+	compress = gabi_zstd;
+      else
+	compress = gabi_zlib;
       if (size == 32)
 	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
@@ -249,14 +536,20 @@ Output_compressed_section::set_final_data_size()
   else
     compress = none;
   if (compress != none)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+    success = compress_section_data((compress == gabi_zstd
+				     ? COMPRESS_ZSTD
+				     : COMPRESS_ZLIB),
+				    compression_header_size,
+				    uncompressed_data, uncompressed_size,
+				    &this->data_, &compressed_size);
   if (success)
     {
       elfcpp::Elf_Xword flags = this->flags();
-      if (compress == gabi_zlib)
+      if (compress == gabi_zlib || compress == gabi_zstd)
 	{
+	  elfcpp::Elf_Word ch_type = (compress == gabi_zstd
+				      ? elfcpp::ELFCOMPRESS_ZSTD
+				      : elfcpp::ELFCOMPRESS_ZLIB);
 	  // Set the SHF_COMPRESSED bit.
 	  flags |= elfcpp::SHF_COMPRESSED;
 	  const bool is_big_endian = parameters->target().is_big_endian();
@@ -266,14 +559,14 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<32, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<32, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -283,14 +576,14 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<64, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<64, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -313,7 +606,8 @@ Output_compressed_section::set_final_data_size()
     }
   else
     {
-      gold_warning(_("not compressing section data: zlib error"));
+      gold_warning(_("not compressing section data: %s error"),
+		   compress == gabi_zstd ? "zstd" : "zlib");
       gold_assert(this->data_ == NULL);
       this->set_data_size(uncompressed_size);
     }
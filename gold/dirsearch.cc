@@ -23,14 +23,28 @@
 #include "gold.h"
 
 #include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <map>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <unistd.h>
+
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+
+#include "libiberty.h"
 
 #include "debug.h"
 #include "gold-threads.h"
 #include "options.h"
+#include "parameters.h"
+#include "fileread.h"
 #include "workqueue.h"
 #include "dirsearch.h"
 
@@ -49,9 +63,15 @@ class Dir_cache
   // Read the files in the directory.
   void read_files();
 
+  // Add files listed in a Dir_index, instead of reading them.
+  void add_files(const std::vector<std::string>&);
+
   // Return whether a file (a base name) is present in the directory.
   bool find(const std::string&) const;
 
+  // Append the names of the files in the directory to a vector.
+  void get_files(std::vector<std::string>*) const;
+
  private:
   // We can not copy this class.
   Dir_cache(const Dir_cache&);
@@ -84,12 +104,252 @@ Dir_cache::read_files()
 		       strerror(errno));
 }
 
+void
+Dir_cache::add_files(const std::vector<std::string>& files)
+{
+  this->files_.insert(files.begin(), files.end());
+}
+
 bool
 Dir_cache::find(const std::string& basename) const
 {
   return this->files_.find(basename) != this->files_.end();
 }
 
+void
+Dir_cache::get_files(std::vector<std::string>* files) const
+{
+  files->insert(files->end(), this->files_.begin(), this->files_.end());
+}
+
+// Return the current time in microseconds.
+
+long long
+dir_cache_now()
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+  ::gettimeofday(&tv, NULL);
+  return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#else
+  return get_run_time();
+#endif
+}
+
+// The index used by --library-path-cache.  Build systems often run
+// many links with the same -L options, and reading the same large
+// directories again for each link can be slow, particularly on a
+// network file system.  The index records the files in each directory
+// along with the directory's modification time.  If the directory has
+// not been modified since, we use the index instead of reading the
+// directory.  The index file may be shared by links with different -L
+// options; it holds every directory any of them used.
+
+class Dir_index
+{
+ public:
+  Dir_index(const char* filename)
+    : filename_(filename), entries_(), updates_()
+  { }
+
+  // Read the index file, if it exists.
+  void
+  read();
+
+  // If the index has the contents of DIRNAME, last modified at
+  // MTIME, add them to CACHE, set *USECS to the time it took to read
+  // the directory, and return true.
+  bool
+  lookup(const char* dirname, const gold::Timespec& mtime, Dir_cache* cache,
+	 long long* usecs) const;
+
+  // Record the contents of DIRNAME, which were read into CACHE in
+  // USECS microseconds.  This must be locked against other calls.
+  void
+  record(const char* dirname, const gold::Timespec& mtime, long long usecs,
+	 const Dir_cache* cache);
+
+  // Write out the index, if anything was recorded.
+  void
+  write() const;
+
+ private:
+  struct Entry
+  {
+    gold::Timespec mtime;
+    long long usecs;
+    std::vector<std::string> files;
+  };
+
+  typedef std::map<std::string, Entry> Entries;
+
+  // The index file.
+  std::string filename_;
+  // The entries read from the file.  These are not changed after
+  // they are read, so lookups need no lock.
+  Entries entries_;
+  // The entries recorded during this link.
+  Entries updates_;
+};
+
+// The first line of an index file.
+
+static const char dir_index_magic[] = "gold-library-path-cache 1\n";
+
+// Read the index.  The file holds a line for each directory giving
+// its modification time, the time it took to read, the number of files
+// and the name, followed by a line for each file.  We ignore the file
+// if it is not in this format; it will be rewritten.
+
+void
+Dir_index::read()
+{
+  FILE* f = fopen(this->filename_.c_str(), "r");
+  if (f == NULL)
+    return;
+  std::string contents;
+  char buf[8192];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof buf, f)) > 0)
+    contents.append(buf, len);
+  fclose(f);
+
+  if (contents.compare(0, sizeof dir_index_magic - 1, dir_index_magic) != 0)
+    return;
+  size_t pos = sizeof dir_index_magic - 1;
+  while (pos < contents.size())
+    {
+      size_t eol = contents.find('\n', pos);
+      if (eol == std::string::npos)
+	return;
+      std::string line(contents, pos, eol - pos);
+      pos = eol + 1;
+
+      long long seconds;
+      int nanoseconds;
+      long long usecs;
+      unsigned long count;
+      int name_start;
+      if (sscanf(line.c_str(), "%lld %d %lld %lu %n", &seconds, &nanoseconds,
+		 &usecs, &count, &name_start) != 4)
+	return;
+      std::vector<std::string> files;
+      for (unsigned long i = 0; i < count; ++i)
+	{
+	  eol = contents.find('\n', pos);
+	  if (eol == std::string::npos)
+	    return;
+	  files.push_back(std::string(contents, pos, eol - pos));
+	  pos = eol + 1;
+	}
+      Entry& entry(this->entries_[line.substr(name_start)]);
+      entry.mtime = gold::Timespec(seconds, nanoseconds);
+      entry.usecs = usecs;
+      entry.files.swap(files);
+    }
+}
+
+bool
+Dir_index::lookup(const char* dirname, const gold::Timespec& mtime,
+		  Dir_cache* cache, long long* usecs) const
+{
+  Entries::const_iterator p = this->entries_.find(dirname);
+  if (p == this->entries_.end()
+      || p->second.mtime.seconds != mtime.seconds
+      || p->second.mtime.nanoseconds != mtime.nanoseconds)
+    return false;
+  cache->add_files(p->second.files);
+  *usecs = p->second.usecs;
+  return true;
+}
+
+void
+Dir_index::record(const char* dirname, const gold::Timespec& mtime,
+		  long long usecs, const Dir_cache* cache)
+{
+  // A directory modified within the granularity of its time stamp
+  // may be modified again without changing it, so we don't record
+  // directories modified in the last few seconds.
+  if (mtime.seconds + 2 >= time(NULL))
+    return;
+
+  // The index is line based, so we can't record names with newlines.
+  if (strchr(dirname, '\n') != NULL)
+    return;
+  std::vector<std::string> files;
+  cache->get_files(&files);
+  for (size_t i = 0; i < files.size(); ++i)
+    if (files[i].find('\n') != std::string::npos)
+      return;
+
+  Entry& entry(this->updates_[dirname]);
+  entry.mtime = mtime;
+  entry.usecs = usecs;
+  entry.files.swap(files);
+}
+
+void
+Dir_index::write() const
+{
+  if (this->updates_.empty())
+    return;
+
+  // Write to a temporary file and rename it, so that a link running
+  // at the same time never sees a partial file.
+  char suffix[30];
+  snprintf(suffix, sizeof suffix, ".%ld.tmp", static_cast<long>(getpid()));
+  std::string tmpname = this->filename_ + suffix;
+  FILE* f = fopen(tmpname.c_str(), "w");
+  if (f == NULL)
+    {
+      gold::gold_warning(_("cannot write library path cache %s: %s"),
+			 tmpname.c_str(), strerror(errno));
+      return;
+    }
+
+  fputs(dir_index_magic, f);
+  Entries::const_iterator pu = this->updates_.begin();
+  Entries::const_iterator pe = this->entries_.begin();
+  while (pu != this->updates_.end() || pe != this->entries_.end())
+    {
+      const std::string* name;
+      const Entry* entry;
+      if (pe == this->entries_.end()
+	  || (pu != this->updates_.end() && pu->first <= pe->first))
+	{
+	  if (pe != this->entries_.end() && pe->first == pu->first)
+	    ++pe;
+	  name = &pu->first;
+	  entry = &pu->second;
+	  ++pu;
+	}
+      else
+	{
+	  name = &pe->first;
+	  entry = &pe->second;
+	  ++pe;
+	}
+      fprintf(f, "%lld %d %lld %lu %s\n",
+	      static_cast<long long>(entry->mtime.seconds),
+	      entry->mtime.nanoseconds, entry->usecs,
+	      static_cast<unsigned long>(entry->files.size()), name->c_str());
+      for (std::vector<std::string>::const_iterator p = entry->files.begin();
+	   p != entry->files.end();
+	   ++p)
+	fprintf(f, "%s\n", p->c_str());
+    }
+
+  bool ok = !ferror(f);
+  if (fclose(f) != 0)
+    ok = false;
+  if (!ok || ::rename(tmpname.c_str(), this->filename_.c_str()) < 0)
+    {
+      gold::gold_warning(_("cannot write library path cache %s: %s"),
+			 this->filename_.c_str(), strerror(errno));
+      ::unlink(tmpname.c_str());
+    }
+}
+
 // A mapping from directory names to caches.  A lock permits
 // concurrent update.  There is no lock for read operations--some
 // other mechanism must be used to prevent reads from conflicting with
@@ -98,8 +358,9 @@ Dir_cache::find(const std::string& basename) const
 class Dir_caches
 {
  public:
-  Dir_caches()
-    : lock_(), caches_()
+  Dir_caches(Dir_index* index)
+    : lock_(), caches_(), index_(index), index_hits_(0), index_misses_(0),
+      saved_usecs_(0)
   { }
 
   ~Dir_caches() ATTRIBUTE_UNUSED;
@@ -111,6 +372,16 @@ class Dir_caches
   // calls to Add.
   Dir_cache* lookup(const char*) const;
 
+  // Write out the index.
+  void write_index() const
+  {
+    if (this->index_ != NULL)
+      this->index_->write();
+  }
+
+  // Print statistics to stderr.
+  void print_stats() const;
+
  private:
   // We can not copy this class.
   Dir_caches(const Dir_caches&);
@@ -118,8 +389,20 @@ class Dir_caches
 
   typedef Unordered_map<const char*, Dir_cache*> Cache_hash;
 
+  // Read the contents of a directory into CACHE, using the index if
+  // there is one.
+  void read_dir(const char*, Dir_cache* cache);
+
   gold::Lock lock_;
   Cache_hash caches_;
+  // The index for --library-path-cache, or NULL.
+  Dir_index* index_;
+  // The number of directories found in the index.
+  unsigned int index_hits_;
+  // The number of directories we had to read.
+  unsigned int index_misses_;
+  // The time saved by using the index.
+  long long saved_usecs_;
 };
 
 Dir_caches::~Dir_caches()
@@ -128,6 +411,7 @@ Dir_caches::~Dir_caches()
        p != this->caches_.end();
        ++p)
     delete p->second;
+  delete this->index_;
 }
 
 void
@@ -141,7 +425,7 @@ Dir_caches::add(const char* dirname)
 
   Dir_cache* cache = new Dir_cache(dirname);
 
-  cache->read_files();
+  this->read_dir(dirname, cache);
 
   {
     gold::Hold_lock hl(this->lock_);
@@ -161,6 +445,52 @@ Dir_caches::lookup(const char* dirname) const
   return p->second;
 }
 
+void
+Dir_caches::read_dir(const char* dirname, Dir_cache* cache)
+{
+  gold::Timespec mtime;
+  if (this->index_ == NULL || !gold::get_mtime(dirname, &mtime))
+    {
+      cache->read_files();
+      return;
+    }
+
+  long long start = dir_cache_now();
+  long long usecs;
+  if (this->index_->lookup(dirname, mtime, cache, &usecs))
+    {
+      long long saved = usecs - (dir_cache_now() - start);
+      gold::Hold_lock hl(this->lock_);
+      ++this->index_hits_;
+      if (saved > 0)
+	this->saved_usecs_ += saved;
+      return;
+    }
+
+  cache->read_files();
+  usecs = dir_cache_now() - start;
+
+  gold::Hold_lock hl(this->lock_);
+  ++this->index_misses_;
+  this->index_->record(dirname, mtime, usecs, cache);
+}
+
+void
+Dir_caches::print_stats() const
+{
+  if (this->index_ == NULL)
+    return;
+  unsigned int total = this->index_hits_ + this->index_misses_;
+  fprintf(stderr, _("%s: library path cache directories found: %u of %u"
+		    " (%u%%)\n"),
+	  gold::program_name, this->index_hits_, total,
+	  total == 0 ? 0 : this->index_hits_ * 100 / total);
+  fprintf(stderr, _("%s: library path cache time saved: %lld.%06lld "
+		    "seconds\n"),
+	  gold::program_name, this->saved_usecs_ / 1000000,
+	  this->saved_usecs_ % 1000000);
+}
+
 // The caches.
 
 Dir_caches* caches;
@@ -229,7 +559,13 @@ Dirsearch::initialize(Workqueue* workqueue,
 		      const General_options::Dir_list* directories)
 {
   gold_assert(caches == NULL);
-  caches = new Dir_caches;
+  Dir_index* index = NULL;
+  if (parameters->options().library_path_cache() != NULL)
+    {
+      index = new Dir_index(parameters->options().library_path_cache());
+      index->read();
+    }
+  caches = new Dir_caches(index);
   this->directories_ = directories;
   this->token_.add_blockers(directories->size());
   for (General_options::Dir_list::const_iterator p = directories->begin();
@@ -278,6 +614,24 @@ Dirsearch::find(const std::vector<std::string>& names,
   return std::string();
 }
 
+// Write out the index for --library-path-cache.
+
+void
+Dirsearch::write_cache()
+{
+  if (caches != NULL)
+    caches->write_index();
+}
+
+// Print statistics to stderr.
+
+void
+Dirsearch::print_stats()
+{
+  if (caches != NULL)
+    caches->print_stats();
+}
+
 // Search for a file in a directory list.  This is a low-level function and
 // therefore can be used before options and parameters are set.
 
@@ -62,6 +62,15 @@ class Dirsearch
   find(const std::vector<std::string>& names, bool* is_in_sysroot,
        int* pindex, std::string *found_name) const;
 
+  // Write out the directory contents for --library-path-cache.  This
+  // should be called after all the tasks have run.
+  static void
+  write_cache();
+
+  // Print statistics to stderr.
+  static void
+  print_stats();
+
   // Return the blocker token which controls access.
   Task_token*
   token()
@@ -966,6 +966,15 @@ class Dwarf_line_info
             std::vector<std::string>* other_lines)
   { return this->do_addr2line(shndx, offset, other_lines); }
 
+  // Return a new Dwarf_line_info for the line information in OBJECT,
+  // of the right size and endianness.  If READ_SHNDX is not -1U, only
+  // the information for that section is read.  Reading all of it once
+  // is cheaper than reading it for each section of interest.  This
+  // only looks at OBJECT, which must be locked, so it may be called
+  // in parallel for different objects.
+  static Dwarf_line_info*
+  make(Object* object, unsigned int read_shndx);
+
   // A helper function for a single addr2line lookup.  It also keeps a
   // cache of the last CACHE_SIZE Dwarf_line_info objects it created;
   // set to 0 not to cache at all.  The larger CACHE_SIZE is, the more
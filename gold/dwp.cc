@@ -45,6 +45,7 @@
 #include "compressed_output.h"
 #include "stringpool.h"
 #include "dwarf_reader.h"
+#include "gold-threads.h"
 
 static void
 usage(FILE* fd, int) ATTRIBUTE_NORETURN;
@@ -108,18 +109,61 @@ class Dwo_file
 {
  public:
   Dwo_file(const char* name)
-    : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
-  { }
+    : name_(name), obj_(NULL), input_file_(NULL), machine_(0), size_(0),
+      big_endian_(false), osabi_(0), abiversion_(0), is_compressed_(),
+      sect_offsets_(), str_offset_map_(), debug_types_(), debug_str_(0),
+      debug_cu_index_(0), debug_tu_index_(0), contents_(), strings_(),
+      remapped_str_offsets_(NULL), error_()
+  {
+    for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+      this->debug_shndx_[i] = 0;
+  }
 
   ~Dwo_file();
 
+  // Return the file name.
+  const char*
+  name() const
+  { return this->name_; }
+
   // Read the input executable file and extract the list of .dwo files
   // that it references.
   void
   read_executable(File_list* files);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Reading an input file and sending its contents to the output file
+  // is done in four steps.  The first and third steps only look at
+  // this file, and may be run in parallel for different files.  The
+  // second and fourth steps update the output file, and must be run
+  // for each file in order, so that the output does not depend on the
+  // number of threads.
+
+  // Open the input file, find the debug sections, read their
+  // contents, and hash the strings.
+  void
+  prepare();
+
+  // Merge the input string table into OUTPUT_FILE.
+  void
+  add_strings(Dwp_output_file* output_file);
+
+  // Remap the .debug_str_offsets.dwo section for the output string
+  // table.
+  void
+  remap_str_offsets();
+
+  // Prepare and remap_str_offsets may run in a worker thread, so
+  // they record any error they find instead of reporting it.  Report
+  // that error, if any, and exit.  This must be called from the main
+  // thread.
+  void
+  check_error() const
+  {
+    if (!this->error_.empty())
+      gold_fatal("%s", this->error_.c_str());
+  }
+
+  // Send the rest of the contents of the input file to OUTPUT_FILE.
   void
   read(Dwp_output_file* output_file);
 
@@ -144,16 +188,35 @@ class Dwo_file
     { return i1.first < i2.first; }
   };
 
+  // The contents of a section read by prepare.
+  struct Section_contents
+  {
+    Section_contents()
+      : data(NULL), len(0), is_new(false)
+    { }
+
+    const unsigned char* data;
+    section_size_type len;
+    bool is_new;
+  };
+
+  // The length and hash code of a string in the input string table.
+  typedef std::pair<size_t, size_t> String_hash;
+
+  // Record an error to be reported by check_error.  Only the first
+  // error is kept.
+  void
+  set_error(const char* format, ...) ATTRIBUTE_PRINTF_2;
+
   // Create a Sized_relobj_dwo of the given size and endianness,
-  // and record the target info.  P is a pointer to the ELF header
-  // in memory.
+  // and save the target info.  Return NULL and record an error if
+  // the file can not be read.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object();
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -172,10 +235,23 @@ class Dwo_file
 
   // Return a view of the contents of a section, decompressed if necessary.
   // Set *PLEN to the size.  Set *IS_NEW to true if the contents need to be
-  // deleted by the caller.
+  // deleted by the caller.  If prepare has already read the section,
+  // return the saved contents.
   const unsigned char*
   section_contents(unsigned int shndx, section_size_type* plen, bool* is_new)
-  { return this->obj_->decompressed_section_contents(shndx, plen, is_new); }
+  {
+    if (shndx < this->contents_.size() && this->contents_[shndx].data != NULL)
+      {
+	*plen = this->contents_[shndx].len;
+	*is_new = false;
+	return this->contents_[shndx].data;
+      }
+    return this->obj_->decompressed_section_contents(shndx, plen, is_new);
+  }
+
+  // Read the contents of section SHNDX into contents_.
+  void
+  read_section_contents(unsigned int shndx);
 
   // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
   // and process the CU or TU sets.
@@ -198,10 +274,6 @@ class Dwo_file
   bool
   sized_verify_dwo_list(unsigned int, const File_list& files);
 
-  // Merge the input string table section into the output file.
-  void
-  add_strings(Dwp_output_file*, unsigned int);
-
   // Copy a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -232,12 +304,34 @@ class Dwo_file
   Relobj* obj_;
   // The Input_file object.
   Input_file* input_file_;
+  // The target info from the ELF header.
+  int machine_;
+  int size_;
+  bool big_endian_;
+  int osabi_;
+  int abiversion_;
   // Flags indicating which sections are compressed.
   std::vector<bool> is_compressed_;
   // Map input section index onto output section offset and size.
   std::vector<Section_bounds> sect_offsets_;
   // Map input string offsets to output string offsets.
   Str_offset_map str_offset_map_;
+  // The debug sections found by prepare, indexed by DW_SECT.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  // The .debug_types.dwo sections.
+  std::vector<unsigned int> debug_types_;
+  // The .debug_str.dwo, .debug_cu_index and .debug_tu_index sections.
+  unsigned int debug_str_;
+  unsigned int debug_cu_index_;
+  unsigned int debug_tu_index_;
+  // The contents of the sections read by prepare, indexed by shndx.
+  std::vector<Section_contents> contents_;
+  // The strings in the .debug_str.dwo section.
+  std::vector<String_hash> strings_;
+  // The .debug_str_offsets.dwo section after remap_str_offsets.
+  const unsigned char* remapped_str_offsets_;
+  // The first error found by prepare or remap_str_offsets.
+  std::string error_;
 };
 
 // An ELF input file.
@@ -463,11 +557,13 @@ class Dwp_output_file
   record_target_info(const char* name, int machine, int size, bool big_endian,
 		     int osabi, int abiversion);
 
-  // Add a string to the debug strings section.
+  // Add a string to the debug strings section.  HASH_CODE is the
+  // value returned by Stringpool::hash_string for STR.
   section_offset_type
-  add_string(const char* str, size_t len);
+  add_string(const char* str, size_t len, size_t hash_code);
 
   // Add a section to the output file, and return the new section offset.
+  // The contents are copied, so the caller keeps ownership of CONTENTS.
   section_offset_type
   add_contribution(elfcpp::DW_SECT section_id, const unsigned char* contents,
 		   section_size_type len, int align);
@@ -490,14 +586,6 @@ class Dwp_output_file
   finalize();
 
  private:
-  // Contributions to output sections.
-  struct Contribution
-  {
-    section_offset_type output_offset;
-    section_size_type size;
-    const unsigned char* contents;
-  };
-
   // Sections in the output file.
   struct Section
   {
@@ -505,10 +593,12 @@ class Dwp_output_file
     off_t offset;
     section_size_type size;
     int align;
-    std::vector<Contribution> contributions;
+    // Temporary file holding the contributions to this section
+    // until its layout is final.
+    FILE* spool;
 
     Section(const char* n, int a)
-      : name(n), offset(0), size(0), align(a), contributions()
+      : name(n), offset(0), size(0), align(a), spool(NULL)
     { }
   };
 
@@ -634,7 +724,7 @@ class Dwp_output_file
 
   // Write the contributions to an output section.
   void
-  write_contributions(const Section& sect);
+  write_contributions(Section* sect);
 
   // Write a CU or TU index section.
   template<bool big_endian>
@@ -828,6 +918,11 @@ Sized_relobj_dwo<size, big_endian>::do_section_contents(
 
 Dwo_file::~Dwo_file()
 {
+  for (unsigned int i = 0; i < this->contents_.size(); ++i)
+    if (this->contents_[i].is_new)
+      delete[] this->contents_[i].data;
+  if (this->remapped_str_offsets_ != NULL)
+    delete[] this->remapped_str_offsets_;
   if (this->obj_ != NULL)
     delete this->obj_;
   if (this->input_file_ != NULL)
@@ -840,7 +935,8 @@ Dwo_file::~Dwo_file()
 void
 Dwo_file::read_executable(File_list* files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
+  this->check_error();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -880,25 +976,23 @@ Dwo_file::read_executable(File_list* files)
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Open the input file, find the debug sections, and read their contents.
+// This only looks at this input file, so it may be run in parallel for
+// different files.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::prepare()
 {
-  this->obj_ = this->make_object(output_file);
+  this->obj_ = this->make_object();
+  if (this->obj_ == NULL)
+    return;
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
   this->sect_offsets_.resize(shnum);
 
-  typedef std::vector<unsigned int> Types_list;
-  Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
-  unsigned int debug_str = 0;
-  unsigned int debug_cu_index = 0;
-  unsigned int debug_tu_index = 0;
+  this->contents_.resize(shnum);
+  unsigned int* debug_shndx = this->debug_shndx_;
 
   // Scan the section table and collect debug sections.
   // (Section index 0 is a dummy section; skip it.)
@@ -920,7 +1014,7 @@ Dwo_file::read(Dwp_output_file* output_file)
       if (strcmp(suffix, "info.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_INFO] = i;
       else if (strcmp(suffix, "types.dwo") == 0)
-	debug_types.push_back(i);
+	this->debug_types_.push_back(i);
       else if (strcmp(suffix, "abbrev.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_ABBREV] = i;
       else if (strcmp(suffix, "line.dwo") == 0)
@@ -928,7 +1022,7 @@ Dwo_file::read(Dwp_output_file* output_file)
       else if (strcmp(suffix, "loc.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_LOC] = i;
       else if (strcmp(suffix, "str.dwo") == 0)
-	debug_str = i;
+	this->debug_str_ = i;
       else if (strcmp(suffix, "str_offsets.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_STR_OFFSETS] = i;
       else if (strcmp(suffix, "macinfo.dwo") == 0)
@@ -936,13 +1030,137 @@ Dwo_file::read(Dwp_output_file* output_file)
       else if (strcmp(suffix, "macro.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_MACRO] = i;
       else if (strcmp(suffix, "cu_index") == 0)
-	debug_cu_index = i;
+	this->debug_cu_index_ = i;
       else if (strcmp(suffix, "tu_index") == 0)
-	debug_tu_index = i;
+	this->debug_tu_index_ = i;
+    }
+
+  // Read the contents of the sections we will copy, decompressing
+  // them if necessary.  The units in a .dwo file are parsed from
+  // .debug_info.dwo and .debug_types.dwo by Unit_reader, which reads
+  // those sections itself, so we only read them here for a .dwp file.
+  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
+    if (debug_shndx[i] > 0)
+      this->read_section_contents(debug_shndx[i]);
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
+    {
+      if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
+	this->read_section_contents(debug_shndx[elfcpp::DW_SECT_INFO]);
+      for (unsigned int i = 0; i < this->debug_types_.size(); ++i)
+	this->read_section_contents(this->debug_types_[i]);
+      if (this->debug_cu_index_ > 0)
+	this->read_section_contents(this->debug_cu_index_);
+      if (this->debug_tu_index_ > 0)
+	this->read_section_contents(this->debug_tu_index_);
+    }
+
+  // Find and hash the strings in the string table.
+  if (this->debug_str_ > 0)
+    {
+      this->read_section_contents(this->debug_str_);
+      const Section_contents& str = this->contents_[this->debug_str_];
+      const char* p = reinterpret_cast<const char*>(str.data);
+      const char* pend = p + str.len;
+
+      // Check that the last string is null terminated.
+      if (str.len == 0 || pend[-1] != '\0')
+	{
+	  this->set_error(_("%s: last entry in string section '%s' "
+			    "is not null terminated"),
+			  this->name_,
+			  this->section_name(this->debug_str_).c_str());
+	  return;
+	}
+
+      while (p < pend)
+	{
+	  size_t len = strlen(p);
+	  this->strings_.push_back(std::make_pair(len,
+						  Stringpool::hash_string(p,
+									  len)));
+	  p += len + 1;
+	}
+    }
+}
+
+// Read the contents of section SHNDX, decompressing it if necessary,
+// and keep them until this file is closed.
+
+void
+Dwo_file::read_section_contents(unsigned int shndx)
+{
+  Section_contents& sc = this->contents_[shndx];
+  if (sc.data != NULL)
+    return;
+  sc.data = this->obj_->decompressed_section_contents(shndx, &sc.len,
+						      &sc.is_new);
+}
+
+// Merge the input string table into the output string table, and
+// record the new offsets in the string offset map.  This must be
+// called for each input file in order.
+
+void
+Dwo_file::add_strings(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_, this->size_,
+				  this->big_endian_, this->osabi_,
+				  this->abiversion_);
+
+  this->str_offset_map_.reserve(this->strings_.size() + 1);
+  section_offset_type i = 0;
+  section_offset_type new_offset;
+  if (this->debug_str_ > 0)
+    {
+      const char* p = reinterpret_cast<const char*>(
+	  this->contents_[this->debug_str_].data);
+      for (std::vector<String_hash>::const_iterator ps =
+	     this->strings_.begin();
+	   ps != this->strings_.end();
+	   ++ps)
+	{
+	  new_offset = output_file->add_string(p + i, ps->first, ps->second);
+	  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
+	  i += ps->first + 1;
+	}
+    }
+  new_offset = 0;
+  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
+}
+
+// Remap the string offsets in the .debug_str_offsets.dwo section for
+// the output string table.  This only looks at this input file, so it
+// may be run in parallel for different files after add_strings.
+
+void
+Dwo_file::remap_str_offsets()
+{
+  unsigned int shndx = this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS];
+  if (shndx == 0)
+    return;
+  const Section_contents& sc = this->contents_[shndx];
+  if ((sc.len & 3) != 0)
+    {
+      this->set_error(_("%s: .debug_str_offsets.dwo section size "
+			"not a multiple of 4"),
+		      this->name_);
+      return;
     }
+  this->remapped_str_offsets_ = this->remap_str_offsets(sc.data, sc.len);
+}
 
-  // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+// Send the rest of the contents of the input file to OUTPUT_FILE.
+// This must be called for each input file in order.
+
+void
+Dwo_file::read(Dwp_output_file* output_file)
+{
+  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
+  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+    debug_shndx[i] = this->debug_shndx_[i];
+  const std::vector<unsigned int>& debug_types = this->debug_types_;
+  unsigned int debug_cu_index = this->debug_cu_index_;
+  unsigned int debug_tu_index = this->debug_tu_index_;
 
   // If we found any .dwp index sections, read those and add the section
   // sets to the output file.
@@ -969,7 +1187,7 @@ Dwo_file::read(Dwp_output_file* output_file)
     this->add_unit_set(output_file, debug_shndx, false);
 
   debug_shndx[elfcpp::DW_SECT_INFO] = 0;
-  for (Types_list::const_iterator tp = debug_types.begin();
+  for (std::vector<unsigned int>::const_iterator tp = debug_types.begin();
        tp != debug_types.end();
        ++tp)
     {
@@ -985,7 +1203,7 @@ Dwo_file::read(Dwp_output_file* output_file)
 bool
 Dwo_file::verify(const File_list& files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -1020,11 +1238,32 @@ Dwo_file::verify(const File_list& files)
   return this->verify_dwo_list(debug_cu_index, files);
 }
 
+// Record an error to be reported by check_error.
+
+void
+Dwo_file::set_error(const char* format, ...)
+{
+  if (!this->error_.empty())
+    return;
+  va_list args;
+  va_start(args, format);
+  char* buf = NULL;
+  if (vasprintf(&buf, format, args) < 0)
+    this->error_ = _("out of memory");
+  else
+    {
+      this->error_ = buf;
+      free(buf);
+    }
+  va_end(args);
+}
+
 // Create a Sized_relobj_dwo of the given size and endianness,
-// and record the target info.
+// and save the target info.  Return NULL and record an error if the
+// file can not be read.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object()
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
@@ -1032,7 +1271,10 @@ Dwo_file::make_object(Dwp_output_file* output_file)
   Dirsearch dirpath;
   int index;
   if (!input_file->open(dirpath, NULL, &index))
-    gold_fatal(_("%s: can't open"), this->name_);
+    {
+      this->set_error(_("%s: can't open"), this->name_);
+      return NULL;
+    }
   
   // Check that it's an ELF file.
   off_t filesize = input_file->file().filesize();
@@ -1042,7 +1284,10 @@ Dwo_file::make_object(Dwp_output_file* output_file)
   const unsigned char* elf_header =
       input_file->file().get_view(0, 0, hdrsize, true, false);
   if (!elfcpp::Elf_recognizer::is_elf_file(elf_header, hdrsize))
-    gold_fatal(_("%s: not an ELF object file"), this->name_);
+    {
+      this->set_error(_("%s: not an ELF object file"), this->name_);
+      return NULL;
+    }
   
   // Get the size, endianness, machine, etc. info from the header,
   // make an appropriately-sized Relobj, and pass the target info
@@ -1052,21 +1297,22 @@ Dwo_file::make_object(Dwp_output_file* output_file)
   std::string error;
   if (!elfcpp::Elf_recognizer::is_valid_header(elf_header, hdrsize, &size,
 					       &big_endian, &error))
-    gold_fatal(_("%s: %s"), this->name_, error.c_str());
+    {
+      this->set_error(_("%s: %s"), this->name_, error.c_str());
+      return NULL;
+    }
 
   if (size == 32)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1075,15 +1321,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1092,23 +1336,22 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     gold_unreachable();
 }
 
-// Function template to create a Sized_relobj_dwo and record the target info.
+// Function template to create a Sized_relobj_dwo and save the target info.
 // P is a pointer to the ELF header in memory.
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+  this->machine_ = ehdr.get_e_machine();
+  this->size_ = size;
+  this->big_endian_ = big_endian;
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
   return obj;
 }
 
@@ -1236,15 +1479,6 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 	      info_contents + unit_set->sections[info_sect].offset;
 	  section_size_type unit_length = unit_set->sections[info_sect].size;
 
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
-	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
-	    }
 	  section_offset_type off =
 	      output_file->add_contribution(info_sect, unit_start,
 					    unit_length, 1);
@@ -1360,48 +1594,6 @@ Dwo_file::sized_verify_dwo_list(unsigned int shndx, const File_list& files)
   return nmissing == 0;
 }
 
-// Merge the input string table section into the output file.
-
-void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
-{
-  section_size_type len;
-  bool is_new;
-  const unsigned char* pdata = this->section_contents(debug_str, &len, &is_new);
-  const char* p = reinterpret_cast<const char*>(pdata);
-  const char* pend = p + len;
-
-  // Check that the last string is null terminated.
-  if (pend[-1] != '\0')
-    gold_fatal(_("%s: last entry in string section '%s' "
-		 "is not null terminated"),
-	       this->name_,
-	       this->section_name(debug_str).c_str());
-
-  // Count the number of strings in the section, and size the map.
-  size_t count = 0;
-  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
-    ++count;
-  this->str_offset_map_.reserve(count + 1);
-
-  // Add the strings to the output string table, and record the new offsets
-  // in the map.
-  section_offset_type i = 0;
-  section_offset_type new_offset;
-  while (p < pend)
-    {
-      size_t len = strlen(p);
-      new_offset = output_file->add_string(p, len);
-      this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-      p += len + 1;
-      i += len + 1;
-    }
-  new_offset = 0;
-  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
-    delete[] pdata;
-}
-
 // Copy a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
 // in the output section.  If copying .debug_str_offsets.dwo, remap
@@ -1416,32 +1608,33 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   if (this->sect_offsets_[shndx].size > 0)
     return this->sect_offsets_[shndx];
 
-  // Get the section contents. Upon return, if IS_NEW is true, the memory
-  // has been allocated via new; if false, the memory is part of the mapped
-  // input file, and we will need to duplicate it so that it will persist
-  // after we close the input file.
+  // Get the section contents.  Upon return, if IS_NEW is true, the memory
+  // has been allocated via new and we must free it.  The string offsets
+  // were already remapped by remap_str_offsets.
   section_size_type len;
   bool is_new;
   const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
 
-  if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
+  if (section_id == elfcpp::DW_SECT_STR_OFFSETS
+      && shndx == this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS])
+    {
+      gold_assert(!is_new && this->remapped_str_offsets_ != NULL);
+      contents = this->remapped_str_offsets_;
+    }
+  else if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
     {
       const unsigned char* remapped = this->remap_str_offsets(contents, len);
       if (is_new)
 	delete[] contents;
       contents = remapped;
-    }
-  else if (!is_new)
-    {
-      unsigned char* copy = new unsigned char[len];
-      memcpy(copy, contents, len);
-      contents = copy;
+      is_new = true;
     }
 
   // Add the contents of the input section to the output section.
-  // The output file takes ownership of the memory pointed to by CONTENTS.
   section_offset_type off = output_file->add_contribution(section_id, contents,
 							  len, 1);
+  if (is_new)
+    delete[] contents;
 
   // Store the output section bounds.
   Section_bounds bounds(off, len);
@@ -1450,7 +1643,9 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   return bounds;
 }
 
-// Remap the 
+// Remap the string offsets in CONTENTS, and return a new buffer
+// allocated with new[].
+
 const unsigned char*
 Dwo_file::remap_str_offsets(const unsigned char* contents,
 			    section_size_type len)
@@ -1582,10 +1777,10 @@ Dwp_output_file::record_target_info(const char*, int machine,
 // Add a string to the debug strings section.
 
 section_offset_type
-Dwp_output_file::add_string(const char* str, size_t len)
+Dwp_output_file::add_string(const char* str, size_t len, size_t hash_code)
 {
   Stringpool::Key key;
-  this->stringpool_.add_with_length(str, len, true, &key);
+  this->stringpool_.add_with_length_and_hash(str, len, hash_code, true, &key);
   this->have_strings_ = true;
   // We aren't supposed to call get_offset() until after
   // calling set_string_offsets(), but the offsets will
@@ -1614,9 +1809,10 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
 // Add a contribution to a section in the output file, and return the offset
 // of the contribution within the output section.  The .debug_info.dwo section
 // is expected to be the largest one, so we will write the contents of this
-// section directly to the output file as we receive contributions, allowing
-// us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// section directly to the output file as we receive contributions.  The
+// remaining contributions are appended to a temporary file for each section
+// until we finalize the layout of the output file, so that we never hold
+// more than one input file's contents in memory.
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
@@ -1676,13 +1872,30 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
     }
   else
     {
-      // Collect the contributions and keep track of the total size.
+      // Spool the contributions and keep track of the total size.
+      if (section.spool == NULL)
+	{
+	  section.spool = ::tmpfile();
+	  if (section.spool == NULL)
+	    gold_fatal(_("%s: can't create temporary file: %s"), this->name_,
+		       strerror(errno));
+	}
       if (align > section.align)
 	section.align = align;
       section_offset = align_offset(section.size, align);
+      static const unsigned char zeroes[16] = { 0 };
+      for (section_size_type pad = section_offset - section.size; pad > 0; )
+	{
+	  section_size_type n = std::min(pad, sizeof(zeroes));
+	  if (::fwrite(zeroes, 1, n, section.spool) < n)
+	    gold_fatal(_("%s: error writing section '%s'"), this->name_,
+		       section_name);
+	  pad -= n;
+	}
+      if (::fwrite(contents, 1, len, section.spool) < len)
+	gold_fatal(_("%s: error writing section '%s'"), this->name_,
+		   section_name);
       section.size = section_offset + len;
-      Contribution contrib = { section_offset, len, contents };
-      section.contributions.push_back(contrib);
     }
 
   return section_offset;
@@ -1848,7 +2061,7 @@ Dwp_output_file::finalize()
       off_t file_offset = this->next_file_offset_;
       file_offset = align_offset(file_offset, sect.align);
       sect.offset = file_offset;
-      this->write_contributions(sect);
+      this->write_contributions(&sect);
       this->next_file_offset_ = file_offset + sect.size;
     }
 
@@ -1930,16 +2143,26 @@ Dwp_output_file::finalize()
 // Write the contributions to an output section.
 
 void
-Dwp_output_file::write_contributions(const Section& sect)
+Dwp_output_file::write_contributions(Section* sect)
 {
-  for (unsigned int i = 0; i < sect.contributions.size(); ++i)
+  gold_assert(sect->spool != NULL);
+  ::rewind(sect->spool);
+  ::fseek(this->fd_, sect->offset, SEEK_SET);
+  unsigned char buf[65536];
+  section_size_type remaining = sect->size;
+  while (remaining > 0)
     {
-      const Contribution& c = sect.contributions[i];
-      ::fseek(this->fd_, sect.offset + c.output_offset, SEEK_SET);
-      if (::fwrite(c.contents, 1, c.size, this->fd_) < c.size)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
-      delete[] c.contents;
+      size_t n = std::min(remaining, sizeof(buf));
+      if (::fread(buf, 1, n, sect->spool) < n)
+	gold_fatal(_("%s: error reading temporary file for section '%s'"),
+		   this->name_, sect->name);
+      if (::fwrite(buf, 1, n, this->fd_) < n)
+	gold_fatal(_("%s: error writing section '%s'"), this->name_,
+		   sect->name);
+      remaining -= n;
     }
+  ::fclose(sect->spool);
+  sect->spool = NULL;
 }
 
 // Write a new section to the output file.
@@ -2246,9 +2469,8 @@ Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
   for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
     unit_set->sections[i] = this->sections_[i];
 
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
+  // Dwp_output_file::add_contribution copies the section contents,
+  // so we do not need to duplicate them here.
   section_offset_type off =
       this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
 					   this->buffer_at_offset(0),
@@ -2274,16 +2496,51 @@ Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
   for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
     unit_set->sections[i] = this->sections_[i];
 
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
   section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
+      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES,
+					   this->buffer_at_offset(0),
 					   tu_length, 1);
   Section_bounds bounds(off, tu_length);
   unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
   this->output_file_->add_tu_set(unit_set);
 }
 
+// Class Dwo_prepare_work opens a batch of input files and reads
+// their contents in parallel.
+
+class Dwo_prepare_work : public Parallel_work
+{
+ public:
+  Dwo_prepare_work(const std::vector<Dwo_file*>& files)
+    : files_(files)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->files_[i]->prepare(); }
+
+ private:
+  const std::vector<Dwo_file*>& files_;
+};
+
+// Class Dwo_remap_work remaps the string offsets of a batch of input
+// files in parallel, once their strings have been added to the output.
+
+class Dwo_remap_work : public Parallel_work
+{
+ public:
+  Dwo_remap_work(const std::vector<Dwo_file*>& files)
+    : files_(files)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->files_[i]->remap_str_offsets(); }
+
+ private:
+  const std::vector<Dwo_file*>& files_;
+};
+
 }; // End namespace gold
 
 using namespace gold;
@@ -2292,6 +2549,8 @@ using namespace gold;
 
 enum Dwp_options {
   VERIFY_ONLY = 0x101,
+  THREADS,
+  THREAD_COUNT,
 };
 
 struct option dwp_options[] =
@@ -2299,6 +2558,8 @@ struct option dwp_options[] =
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
     { "output", required_argument, NULL, 'o' },
+    { "threads", no_argument, NULL, THREADS },
+    { "thread-count", required_argument, NULL, THREAD_COUNT },
     { "verbose", no_argument, NULL, 'v' },
     { "verify-only", no_argument, NULL, VERIFY_ONLY },
     { "version", no_argument, NULL, 'V' },
@@ -2315,6 +2576,9 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 					   " (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("  --threads                Read input files in parallel\n"));
+  fprintf(fd, _("  --thread-count COUNT     Number of threads to use"
+					   " (implies --threads)\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  --verify-only            Verify output file against"
 					   " exec file\n"));
@@ -2363,11 +2627,11 @@ main(int argc, char** argv)
   Errors errors(program_name);
   set_parameters_errors(&errors);
 
-  // Initialize gold's global options.  We don't use these in
-  // this program, but they need to be initialized so that
-  // functions we call from libgold work properly.
-  General_options options;
-  set_parameters_options(&options);
+  // Initialize gold's global options.  We only use these in this
+  // program to control threads, but they need to be initialized so
+  // that functions we call from libgold work properly.
+  Command_line command_line;
+  set_parameters_options(&command_line.options());
 
   // In libiberty; expands @filename to the args in "filename".
   expandargv(&argc, &argv);
@@ -2397,6 +2661,25 @@ main(int argc, char** argv)
 	  case VERIFY_ONLY:
 	    verify_only = true;
 	    break;
+	  case THREADS:
+	  case THREAD_COUNT:
+	    {
+	      // Pass the option on to gold's own option parser.  We
+	      // only run threads during the final phase.  A thread count
+	      // implies --threads.
+	      const char* threads_args[1] = { "--threads" };
+	      bool no_more_options = false;
+	      command_line.process_one_option(1, threads_args, 0,
+					      &no_more_options);
+	      if (c == THREAD_COUNT)
+		{
+		  const char* count_args[2] = { "--thread-count-final",
+						optarg };
+		  command_line.process_one_option(2, count_args, 0,
+						  &no_more_options);
+		}
+	    }
+	    break;
 	  case 'V':
 	    print_version();
 	  case '?':
@@ -2436,14 +2719,48 @@ main(int argc, char** argv)
       return ok ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-  // Process each file, adding its contents to the output file.
+  // Process the files in batches, adding their contents to the output
+  // file.  Opening the files and reading their contents, and remapping
+  // their string offsets, are done in parallel for each batch, but the
+  // contents are added to the output file in the order of the input
+  // files, so that the output does not depend on the number of threads.
   Dwp_output_file output_file(output_filename.c_str());
-  for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
+  int thread_count = parallel_thread_count();
+  size_t batch_size = thread_count > 1 ? 4 * thread_count : 1;
+  File_list::const_iterator f = files.begin();
+  while (f != files.end())
     {
-      if (verbose)
-	fprintf(stderr, "%s\n", f->dwo_name.c_str());
-      Dwo_file dwo_file(f->dwo_name.c_str());
-      dwo_file.read(&output_file);
+      std::vector<Dwo_file*> batch;
+      for (; f != files.end() && batch.size() < batch_size; ++f)
+	batch.push_back(new Dwo_file(f->dwo_name.c_str()));
+
+      // Start reading all the files in the batch at once.
+      if (batch.size() > 1)
+	for (size_t i = 0; i < batch.size(); ++i)
+	  File_read::prefetch(batch[i]->name());
+
+      // Errors found by the workers are reported here, in the order
+      // of the input files, once all the workers are done.
+      Dwo_prepare_work prepare_work(batch);
+      run_parallel_work(&prepare_work, batch.size());
+
+      for (size_t i = 0; i < batch.size(); ++i)
+	{
+	  if (verbose)
+	    fprintf(stderr, "%s\n", batch[i]->name());
+	  batch[i]->check_error();
+	  batch[i]->add_strings(&output_file);
+	}
+
+      Dwo_remap_work remap_work(batch);
+      run_parallel_work(&remap_work, batch.size());
+
+      for (size_t i = 0; i < batch.size(); ++i)
+	{
+	  batch[i]->check_error();
+	  batch[i]->read(&output_file);
+	  delete batch[i];
+	}
     }
   output_file.finalize();
 
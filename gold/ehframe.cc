@@ -29,6 +29,7 @@
 #include "dwarf.h"
 #include "symtab.h"
 #include "reloc.h"
+#include "gold-threads.h"
 #include "ehframe.h"
 
 namespace gold
@@ -188,8 +189,8 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
       this->get_fde_addresses<size, big_endian>(of, &this->fde_offsets_,
 						&fde_addresses);
 
-      std::sort(fde_addresses.begin(), fde_addresses.end(),
-		Fde_address_compare<size>());
+      // With millions of FDEs the sort is worth doing in parallel.
+      parallel_sort(fde_addresses.list(), Fde_address_compare<size>());
 
       typename elfcpp::Elf_types<size>::Elf_Addr output_address;
       output_address = this->address();
@@ -525,6 +526,21 @@ operator<(const Cie& cie1, const Cie& cie2)
   return cie1.contents_ < cie2.contents_;
 }
 
+// Class Eh_frame_input_section.
+
+// Delete any CIEs and FDEs which were not handed over to an Eh_frame.
+
+Eh_frame_input_section::~Eh_frame_input_section()
+{
+  for (std::vector<Entry>::iterator p = this->entries_.begin();
+       p != this->entries_.end();
+       ++p)
+    {
+      delete p->cie;
+      delete p->fde;
+    }
+}
+
 // Class Eh_frame.
 
 Eh_frame::Eh_frame()
@@ -578,38 +594,94 @@ Eh_frame::add_ehframe_input_section(
     unsigned int reloc_shndx,
     unsigned int reloc_type)
 {
-  // Get the section contents.
-  section_size_type contents_len;
-  const unsigned char* pcontents = object->section_contents(shndx,
-							    &contents_len,
-							    false);
-  if (contents_len == 0)
-    return EH_EMPTY_SECTION;
+  // Use the entries parsed when reading the symbols, if any.
+  Eh_frame_input_section* parsed = object->parsed_eh_frame_section(shndx);
+  Eh_frame_input_section* to_delete = NULL;
+  if (parsed == NULL)
+    {
+      parsed = parse_ehframe_input_section(object, symbols, symbols_size,
+					   symbol_names, symbol_names_size,
+					   shndx, reloc_shndx, reloc_type);
+      to_delete = parsed;
+    }
 
-  // If this is the marker section for the end of the data, then
-  // return false to force it to be handled as an ordinary input
-  // section.  If we don't do this, we won't correctly handle the case
-  // of unrecognized .eh_frame sections.
-  if (contents_len == 4
-      && elfcpp::Swap<32, big_endian>::readval(pcontents) == 0)
-    return EH_END_MARKER_SECTION;
+  Eh_frame_section_disposition disposition = parsed->disposition_;
+  if (disposition == EH_UNRECOGNIZED_SECTION
+      && this->eh_frame_hdr_ != NULL)
+    this->eh_frame_hdr_->found_unrecognized_eh_frame_section();
 
-  New_cies new_cies;
-  if (!this->do_add_ehframe_input_section(object, symbols, symbols_size,
-					  symbol_names, symbol_names_size,
-					  shndx, reloc_shndx,
-					  reloc_type, pcontents,
-					  contents_len, &new_cies))
+  if (disposition != EH_OPTIMIZABLE_SECTION)
     {
-      if (this->eh_frame_hdr_ != NULL)
-	this->eh_frame_hdr_->found_unrecognized_eh_frame_section();
+      delete to_delete;
+      return disposition;
+    }
 
-      for (New_cies::iterator p = new_cies.begin();
-	   p != new_cies.end();
-	   ++p)
-	delete p->first;
+  // Merge the CIEs with the ones we have already seen, and attach the
+  // FDEs to them.  The CIE for each CIE entry is recorded in
+  // CIE_POINTERS, indexed like the entries.
+  std::vector<Eh_frame_input_section::Entry>& entries(parsed->entries_);
+  std::vector<Cie*> cie_pointers(entries.size(), NULL);
+  New_cies new_cies;
+  for (unsigned int i = 0; i < entries.size(); ++i)
+    {
+      Eh_frame_input_section::Entry& entry(entries[i]);
+      if (entry.cie != NULL)
+	{
+	  Cie* cie_pointer = NULL;
+	  if (entry.mergeable)
+	    {
+	      Cie_offsets::iterator find_cie =
+		this->cie_offsets_.find(entry.cie);
+	      if (find_cie != this->cie_offsets_.end())
+		cie_pointer = *find_cie;
+	      else
+		{
+		  // See if we already saw this CIE in this object file.
+		  for (New_cies::const_iterator pc = new_cies.begin();
+		       pc != new_cies.end();
+		       ++pc)
+		    {
+		      if (*(pc->first) == *entry.cie)
+			{
+			  cie_pointer = pc->first;
+			  break;
+			}
+		    }
+		}
+	    }
 
-      return EH_UNRECOGNIZED_SECTION;
+	  if (cie_pointer == NULL)
+	    {
+	      cie_pointer = entry.cie;
+	      new_cies.push_back(std::make_pair(cie_pointer,
+						entry.mergeable));
+	    }
+	  else
+	    {
+	      // We are deleting this CIE.  Record that in our mapping
+	      // from input sections to the output section.
+	      object->add_merge_mapping(this, shndx, entry.input_offset,
+					entry.length, -1);
+	      delete entry.cie;
+	    }
+	  entry.cie = NULL;
+	  cie_pointers[i] = cie_pointer;
+	}
+      else if (entry.fde != NULL
+	       && (entry.fde_shndx == -1U
+		   || object->is_section_included(entry.fde_shndx)))
+	{
+	  gold_assert(cie_pointers[entry.cie_index] != NULL);
+	  cie_pointers[entry.cie_index]->add_fde(entry.fde);
+	  entry.fde = NULL;
+	}
+      else
+	{
+	  // This FDE applies to a discarded function.  We can discard
+	  // this FDE.
+	  object->add_merge_mapping(this, shndx, entry.input_offset,
+				    entry.length, -1);
+	}
     }
 
   // Now that we know we are using this section, record any new CIEs
@@ -624,14 +696,65 @@ Eh_frame::add_ehframe_input_section(
 	this->unmergeable_cie_offsets_.push_back(p->first);
     }
 
+  delete to_delete;
   return EH_OPTIMIZABLE_SECTION;
 }
 
-// The bulk of the implementation of add_ehframe_input_section.
+// Parse input section SHNDX in OBJECT into CIEs and FDEs, without
+// looking at any other input section.  The arguments are as for
+// add_ehframe_input_section.
+
+template<int size, bool big_endian>
+Eh_frame_input_section*
+Eh_frame::parse_ehframe_input_section(
+    Sized_relobj_file<size, big_endian>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type)
+{
+  Eh_frame_input_section* ret = new Eh_frame_input_section(shndx);
+
+  // Get the section contents.
+  section_size_type contents_len;
+  const unsigned char* pcontents = object->section_contents(shndx,
+							    &contents_len,
+							    false);
+  if (contents_len == 0)
+    ret->disposition_ = EH_EMPTY_SECTION;
+
+  // If this is the marker section for the end of the data, then
+  // return false to force it to be handled as an ordinary input
+  // section.  If we don't do this, we won't correctly handle the case
+  // of unrecognized .eh_frame sections.
+  else if (contents_len == 4
+	   && elfcpp::Swap<32, big_endian>::readval(pcontents) == 0)
+    ret->disposition_ = EH_END_MARKER_SECTION;
+
+  else if (do_parse_ehframe_input_section(object, symbols, symbols_size,
+					  symbol_names, symbol_names_size,
+					  shndx, reloc_shndx, reloc_type,
+					  pcontents, contents_len, ret))
+    ret->disposition_ = EH_OPTIMIZABLE_SECTION;
+  else
+    {
+      // Throw away whatever we found before giving up.  A new
+      // Eh_frame_input_section is unrecognized.
+      delete ret;
+      ret = new Eh_frame_input_section(shndx);
+    }
+
+  return ret;
+}
+
+// The bulk of the implementation of parse_ehframe_input_section.
 
 template<int size, bool big_endian>
 bool
-Eh_frame::do_add_ehframe_input_section(
+Eh_frame::do_parse_ehframe_input_section(
     Sized_relobj_file<size, big_endian>* object,
     const unsigned char* symbols,
     section_size_type symbols_size,
@@ -642,7 +765,7 @@ Eh_frame::do_add_ehframe_input_section(
     unsigned int reloc_type,
     const unsigned char* pcontents,
     section_size_type contents_len,
-    New_cies* new_cies)
+    Eh_frame_input_section* parsed)
 {
   Track_relocs<size, big_endian> relocs;
 
@@ -694,17 +817,16 @@ Eh_frame::do_add_ehframe_input_section(
       if (id == 0)
 	{
 	  // CIE.
-	  if (!this->read_cie(object, shndx, symbols, symbols_size,
-			      symbol_names, symbol_names_size,
-			      pcontents, p, pentend, &relocs, &cies,
-			      new_cies))
+	  if (!read_cie(object, shndx, symbols, symbols_size,
+			symbol_names, symbol_names_size,
+			pcontents, p, pentend, &relocs, &cies, parsed))
 	    return false;
 	}
       else
 	{
 	  // FDE.
-	  if (!this->read_fde(object, shndx, symbols, symbols_size,
-			      pcontents, id, p, pentend, &relocs, &cies))
+	  if (!read_fde(object, shndx, symbols, symbols_size,
+			pcontents, id, p, pentend, &relocs, &cies, parsed))
 	    return false;
 	}
 
@@ -729,7 +851,7 @@ Eh_frame::read_cie(Sized_relobj_file<size, big_endian>* object,
 		   const unsigned char* pcieend,
 		   Track_relocs<size, big_endian>* relocs,
 		   Offsets_to_cie* cies,
-		   New_cies* new_cies)
+		   Eh_frame_input_section* parsed)
 {
   bool mergeable = true;
 
@@ -922,48 +1044,16 @@ Eh_frame::read_cie(Sized_relobj_file<size, big_endian>* object,
   if (relocs->advance(pcieend - pcontents) > 0)
     return false;
 
-  Cie cie(object, shndx, (pcie - 8) - pcontents, fde_encoding, 
-	  personality_name, pcie, pcieend - pcie);
-  Cie* cie_pointer = NULL;
-  if (mergeable)
-    {
-      Cie_offsets::iterator find_cie = this->cie_offsets_.find(&cie);
-      if (find_cie != this->cie_offsets_.end())
-	cie_pointer = *find_cie;
-      else
-	{
-	  // See if we already saw this CIE in this object file.
-	  for (New_cies::const_iterator pc = new_cies->begin();
-	       pc != new_cies->end();
-	       ++pc)
-	    {
-	      if (*(pc->first) == cie)
-		{
-		  cie_pointer = pc->first;
-		  break;
-		}
-	    }
-	}
-    }
-
-  if (cie_pointer == NULL)
-    {
-      cie_pointer = new Cie(cie);
-      new_cies->push_back(std::make_pair(cie_pointer, mergeable));
-    }
-  else
-    {
-      // We are deleting this CIE.  Record that in our mapping from
-      // input sections to the output section.  At this point we don't
-      // know for sure that we are doing a special mapping for this
-      // input section, but that's OK--if we don't do a special
-      // mapping, nobody will ever ask for the mapping we add here.
-      object->add_merge_mapping(this, shndx, (pcie - 8) - pcontents,
-                                pcieend - (pcie - 8), -1);
-    }
-
-  // Record this CIE plus the offset in the input section.
-  cies->insert(std::make_pair(pcie - pcontents, cie_pointer));
+  // Record this CIE plus the offset in the input section.  Whether
+  // it duplicates a CIE we have already seen is decided when the
+  // section is added to the Eh_frame.
+  Eh_frame_input_section::Entry entry((pcie - 8) - pcontents,
+				      pcieend - (pcie - 8));
+  entry.cie = new Cie(object, shndx, (pcie - 8) - pcontents, fde_encoding,
+		      personality_name, pcie, pcieend - pcie);
+  entry.mergeable = mergeable;
+  cies->insert(std::make_pair(pcie - pcontents, parsed->entries_.size()));
+  parsed->entries_.push_back(entry);
 
   return true;
 }
@@ -981,7 +1071,8 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
 		   const unsigned char* pfde,
 		   const unsigned char* pfdeend,
 		   Track_relocs<size, big_endian>* relocs,
-		   Offsets_to_cie* cies)
+		   Offsets_to_cie* cies,
+		   Eh_frame_input_section* parsed)
 {
   // OFFSET is the distance between the 4 bytes before PFDE to the
   // start of the CIE.  The offset we recorded for the CIE is 8 bytes
@@ -990,7 +1081,12 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   Offsets_to_cie::const_iterator pcie = cies->find(cie_offset);
   if (pcie == cies->end())
     return false;
-  Cie* cie = pcie->second;
+  unsigned int cie_index = pcie->second;
+  const Cie* cie = parsed->entries_[cie_index].cie;
+
+  Eh_frame_input_section::Entry entry((pfde - 8) - pcontents,
+				      pfdeend - (pfde - 8));
+  entry.cie_index = cie_index;
 
   int pc_size = 0;
   switch (cie->fde_encoding() & 7)
@@ -1046,8 +1142,7 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
 	{
 	  // This FDE applies to a discarded function.  We
 	  // can discard this FDE.
-	  object->add_merge_mapping(this, shndx, (pfde - 8) - pcontents,
-				    pfdeend - (pfde - 8), -1);
+	  parsed->entries_.push_back(entry);
 	  return true;
 	}
 
@@ -1066,7 +1161,8 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   relocs->advance(pfdeend - pcontents);
 
   // Find the section index for code that this FDE describes.
-  // If we have discarded the section, we can also discard the FDE.
+  // If we discard the section, we can also discard the FDE; that is
+  // checked when the section is added to the Eh_frame.
   unsigned int fde_shndx;
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
   if (symndx >= symbols_size / sym_size)
@@ -1075,10 +1171,10 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   bool is_ordinary;
   fde_shndx = object->adjust_sym_shndx(symndx, sym.get_st_shndx(),
 				       &is_ordinary);
-  bool is_discarded = (is_ordinary
-		       && fde_shndx != elfcpp::SHN_UNDEF
-		       && fde_shndx < object->shnum()
-		       && !object->is_section_included(fde_shndx));
+  if (is_ordinary
+      && fde_shndx != elfcpp::SHN_UNDEF
+      && fde_shndx < object->shnum())
+    entry.fde_shndx = fde_shndx;
 
   // Fetch the address range field from the FDE. The offset and size
   // of the field depends on the PC encoding given in the CIE, but
@@ -1101,17 +1197,11 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
       gold_unreachable();
     }
 
-  if (is_discarded || address_range == 0)
-    {
-      // This FDE applies to a discarded function.  We
-      // can discard this FDE.
-      object->add_merge_mapping(this, shndx, (pfde - 8) - pcontents,
-                                pfdeend - (pfde - 8), -1);
-      return true;
-    }
-
-  cie->add_fde(new Fde(object, shndx, (pfde - 8) - pcontents,
-		       pfde, pfdeend - pfde));
+  // If the address range is 0, we can discard this FDE.
+  if (address_range != 0)
+    entry.fde = new Fde(object, shndx, (pfde - 8) - pcontents,
+			pfde, pfdeend - pfde);
+  parsed->entries_.push_back(entry);
 
   return true;
 }
@@ -1295,6 +1385,18 @@ Eh_frame::add_ehframe_input_section<32, false>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Eh_frame_input_section*
+Eh_frame::parse_ehframe_input_section<32, false>(
+    Sized_relobj_file<32, false>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1309,6 +1411,18 @@ Eh_frame::add_ehframe_input_section<32, true>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Eh_frame_input_section*
+Eh_frame::parse_ehframe_input_section<32, true>(
+    Sized_relobj_file<32, true>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1323,6 +1437,18 @@ Eh_frame::add_ehframe_input_section<64, false>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Eh_frame_input_section*
+Eh_frame::parse_ehframe_input_section<64, false>(
+    Sized_relobj_file<64, false>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1337,6 +1463,18 @@ Eh_frame::add_ehframe_input_section<64, true>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Eh_frame_input_section*
+Eh_frame::parse_ehframe_input_section<64, true>(
+    Sized_relobj_file<64, true>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 } // End namespace gold.
@@ -37,6 +37,7 @@ template<int size, bool big_endian>
 class Track_relocs;
 
 class Eh_frame;
+class Eh_frame_input_section;
 
 // This class manages the .eh_frame_hdr section, which holds the data
 // for the PT_GNU_EH_FRAME segment.  gcc's unwind support code uses
@@ -120,18 +121,29 @@ class Eh_frame_hdr : public Output_section_data
     end()
     { return this->fde_addresses_.end(); }
 
+    // Return the underlying list, for sorting.
+    Fde_address_list*
+    list()
+    { return &this->fde_addresses_; }
+
    private:
     Fde_address_list fde_addresses_;
   };
 
-  // Compare Fde_address objects.
+  // Compare Fde_address objects.  Two FDEs for the same PC are
+  // ordered by the address of the FDE, so that the sorted table does
+  // not depend on how the sort was done.
   template<int size>
   struct Fde_address_compare
   {
     bool
     operator()(const typename Fde_addresses<size>::Fde_address& f1,
 	       const typename Fde_addresses<size>::Fde_address& f2) const
-    { return f1.first < f2.first; }
+    {
+      if (f1.first != f2.first)
+	return f1.first < f2.first;
+      return f1.second < f2.second;
+    }
   };
 
   // Return the PC to which an FDE refers.
@@ -385,7 +397,8 @@ class Eh_frame : public Output_section_data
   // is the relocation section if any (0 for none, -1U for multiple).
   // RELOC_TYPE is the type of the relocation section if any.  This
   // returns whether the section was incorporated into the .eh_frame
-  // data.
+  // data.  If OBJECT has already parsed the section, the parsed
+  // entries are used.
   template<int size, bool big_endian>
   Eh_frame_section_disposition
   add_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
@@ -396,6 +409,20 @@ class Eh_frame : public Output_section_data
 			    unsigned int shndx, unsigned int reloc_shndx,
 			    unsigned int reloc_type);
 
+  // Parse the input section SHNDX in OBJECT, with arguments as for
+  // add_ehframe_input_section, without adding anything to an
+  // Eh_frame.  This only looks at OBJECT, so it may be called while
+  // reading the symbols.  Returns a newly allocated object.
+  template<int size, bool big_endian>
+  static Eh_frame_input_section*
+  parse_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
+			      const unsigned char* symbols,
+			      section_size_type symbols_size,
+			      const unsigned char* symbol_names,
+			      section_size_type symbol_names_size,
+			      unsigned int shndx, unsigned int reloc_shndx,
+			      unsigned int reloc_type);
+
   // Add a CIE and an FDE for a PLT section, to permit unwinding
   // through a PLT.  The FDE data should start with 8 bytes of zero,
   // which will be replaced by a 4 byte PC relative reference to the
@@ -444,9 +471,10 @@ class Eh_frame : public Output_section_data
   // A list of unmergeable CIEs.
   typedef std::vector<Cie*> Unmergeable_cie_offsets;
 
-  // A mapping from offsets to CIEs.  This is used while reading an
-  // input section.
-  typedef std::map<uint64_t, Cie*> Offsets_to_cie;
+  // A mapping from offsets to the index of a CIE in the entries of
+  // an Eh_frame_input_section.  This is used while reading an input
+  // section.
+  typedef std::map<uint64_t, unsigned int> Offsets_to_cie;
 
   // A list of CIEs, and a bool indicating whether the CIE is
   // mergeable.
@@ -456,24 +484,24 @@ class Eh_frame : public Output_section_data
   static bool
   skip_leb128(const unsigned char**, const unsigned char*);
 
-  // The implementation of add_ehframe_input_section.
+  // The implementation of parse_ehframe_input_section.
   template<int size, bool big_endian>
-  bool
-  do_add_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
-			       const unsigned char* symbols,
-			       section_size_type symbols_size,
-			       const unsigned char* symbol_names,
-			       section_size_type symbol_names_size,
-			       unsigned int shndx,
-			       unsigned int reloc_shndx,
-			       unsigned int reloc_type,
-			       const unsigned char* pcontents,
-			       section_size_type contents_len,
-			       New_cies*);
+  static bool
+  do_parse_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
+				 const unsigned char* symbols,
+				 section_size_type symbols_size,
+				 const unsigned char* symbol_names,
+				 section_size_type symbol_names_size,
+				 unsigned int shndx,
+				 unsigned int reloc_shndx,
+				 unsigned int reloc_type,
+				 const unsigned char* pcontents,
+				 section_size_type contents_len,
+				 Eh_frame_input_section*);
 
   // Read a CIE.
   template<int size, bool big_endian>
-  bool
+  static bool
   read_cie(Sized_relobj_file<size, big_endian>* object,
 	   unsigned int shndx,
 	   const unsigned char* symbols,
@@ -485,11 +513,11 @@ class Eh_frame : public Output_section_data
 	   const unsigned char* pcieend,
 	   Track_relocs<size, big_endian>* relocs,
 	   Offsets_to_cie* cies,
-	   New_cies* new_cies);
+	   Eh_frame_input_section*);
 
   // Read an FDE.
   template<int size, bool big_endian>
-  bool
+  static bool
   read_fde(Sized_relobj_file<size, big_endian>* object,
 	   unsigned int shndx,
 	   const unsigned char* symbols,
@@ -499,7 +527,8 @@ class Eh_frame : public Output_section_data
 	   const unsigned char* pfde,
 	   const unsigned char* pfdeend,
 	   Track_relocs<size, big_endian>* relocs,
-	   Offsets_to_cie* cies);
+	   Offsets_to_cie* cies,
+	   Eh_frame_input_section*);
 
   // Template version of write function.
   template<int size, bool big_endian>
@@ -521,6 +550,64 @@ class Eh_frame : public Output_section_data
   section_size_type final_data_size_;
 };
 
+// This class holds the CIEs and FDEs found in an input .eh_frame
+// section, before they are merged into the Eh_frame data.  Parsing a
+// section only looks at its object, so when using threads the
+// Read_symbols task does it; the merge is then done in layout order,
+// which keeps the output independent of the thread count.
+
+class Eh_frame_input_section
+{
+ public:
+  Eh_frame_input_section(unsigned int shndx)
+    : shndx_(shndx), disposition_(Eh_frame::EH_UNRECOGNIZED_SECTION),
+      entries_()
+  { }
+
+  ~Eh_frame_input_section();
+
+  // The input section index.
+  unsigned int
+  shndx() const
+  { return this->shndx_; }
+
+ private:
+  friend class Eh_frame;
+
+  // One CIE or FDE.
+  struct Entry
+  {
+    Entry(section_offset_type off, section_size_type len)
+      : input_offset(off), length(len), cie(NULL), mergeable(false),
+	cie_index(0), fde(NULL), fde_shndx(-1U)
+    { }
+
+    // The offset of the entry in the input section, and its length
+    // including the length and ID fields.
+    section_offset_type input_offset;
+    section_size_type length;
+    // For a CIE, the CIE, and whether it may be merged with identical
+    // CIEs from other sections.  This is NULL for an FDE.
+    Cie* cie;
+    bool mergeable;
+    // For an FDE, the index of its CIE in entries_.
+    unsigned int cie_index;
+    // For an FDE, the FDE.  This is NULL if the FDE was discarded
+    // while parsing.
+    Fde* fde;
+    // For an FDE, the section in the object which the FDE describes,
+    // or -1U if it does not describe an ordinary section.
+    unsigned int fde_shndx;
+  };
+
+  // The input section index.
+  unsigned int shndx_;
+  // What to do with the section.
+  Eh_frame::Eh_frame_section_disposition disposition_;
+  // The entries in the order in which they appear in the section.
+  std::vector<Entry> entries_;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_EHFRAME_H)
@@ -124,6 +124,7 @@ static Initialize_lock file_counts_initialize_lock(&file_counts_lock);
 unsigned long long File_read::total_mapped_bytes;
 unsigned long long File_read::current_mapped_bytes;
 unsigned long long File_read::maximum_mapped_bytes;
+unsigned long long File_read::total_prefetched_bytes;
 
 // Class File_read::View.
 
@@ -856,6 +857,42 @@ File_read::print_stats()
 	  program_name, File_read::total_mapped_bytes);
   fprintf(stderr, _("%s: maximum bytes mapped for read at one time: %llu\n"),
 	  program_name, File_read::maximum_mapped_bytes);
+  if (parameters->options().prefetch_inputs())
+    fprintf(stderr, _("%s: total bytes prefetched: %llu\n"),
+	    program_name, File_read::total_prefetched_bytes);
+}
+
+// Start reading FILENAME in the background.  With a cold page cache,
+// and particularly with files on network storage, reading the inputs
+// one view at a time as the link gets to them leaves the link waiting
+// for one read after another.  Telling the kernel about all of the
+// files up front lets it issue the reads together and complete them
+// in whatever order the storage returns them; the later mmap or pread
+// of each view then finds the data in the page cache.
+
+void
+File_read::prefetch(const char* filename)
+{
+#ifdef HAVE_POSIX_FADVISE
+  int o = open_descriptor(-1, filename, O_RDONLY);
+  if (o < 0)
+    {
+      // Leave the error to whoever opens the file for real.
+      return;
+    }
+  struct stat s;
+  if (::fstat(o, &s) == 0
+      && ::posix_fadvise(o, 0, s.st_size, POSIX_FADV_WILLNEED) == 0)
+    {
+      file_counts_initialize_lock.initialize();
+      Hold_optional_lock hl(file_counts_lock);
+      File_read::total_prefetched_bytes += s.st_size;
+    }
+  release_descriptor(o, true);
+#else
+  // The reads will be done one view at a time as before.
+  (void) filename;
+#endif
 }
 
 // Class File_view.
@@ -1117,6 +1154,21 @@ Input_file::open(const Dirsearch& dirpath, const Task* task, int* pindex)
   return true;
 }
 
+// Open the file already opened by INPUT_FILE.
+
+bool
+Input_file::open_again(const Input_file* input_file, const Task* task)
+{
+  gold_assert(this->input_argument_ == input_file->input_argument_
+	      && input_file->format_ == FORMAT_ELF);
+  if (!this->file_.open(task, input_file->filename()))
+    return false;
+  this->found_name_ = input_file->found_name_;
+  this->is_in_sysroot_ = input_file->is_in_sysroot_;
+  this->format_ = FORMAT_ELF;
+  return true;
+}
+
 // Open a file for --format binary.
 
 bool
@@ -103,6 +103,11 @@ class File_read
   remove_object()
   { --this->object_count_; }
 
+  // Return the number of objects associated with a file.
+  int
+  object_count() const
+  { return this->object_count_; }
+
   // Lock the file for exclusive access within a particular Task::run
   // execution.  This routine may only be called when the workqueue
   // lock is held.
@@ -207,6 +212,13 @@ class File_read
   static void
   print_stats();
 
+  // Ask the operating system to start reading the file FILENAME into
+  // memory in the background, for --prefetch-inputs.  This does not
+  // wait for the data, and does nothing if the system has no way to
+  // do that.
+  static void
+  prefetch(const char* filename);
+
   // Return the open file descriptor (for plugins).
   int
   descriptor()
@@ -247,6 +259,9 @@ class File_read
   // --stats.
   static unsigned long long maximum_mapped_bytes;
 
+  // Total bytes of files handed to prefetch.
+  static unsigned long long total_prefetched_bytes;
+
   // A view into the file.
   class View
   {
@@ -521,6 +536,14 @@ class Input_file
   bool
   open(const Dirsearch&, const Task*, int* pindex);
 
+  // Open the file which INPUT_FILE has already opened, with a
+  // File_read of our own, so that it may be read by a different
+  // thread at the same time.  This is only for ELF format input.
+  // Return true on success.  This does not report an error if the
+  // file can not be opened.
+  bool
+  open_again(const Input_file* input_file, const Task*);
+
   // Return the name given by the user.  For -lc this will return "c".
   const char*
   name() const;
@@ -22,6 +22,10 @@
 
 
 #include "gold.h"
+
+#include <cstdio>
+
+#include "gold-threads.h"
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
@@ -29,11 +33,32 @@
 namespace gold
 {
 
+// When there are at least this many sections with references, and we
+// have more than one thread, do_transitive_closure marks sections in
+// parallel.
+
+static const size_t gc_parallel_min_sections = 1024;
+
 // Garbage collection uses a worklist style algorithm to determine the 
 // transitive closure of all referenced sections.
 void 
 Garbage_collection::do_transitive_closure()
 {
+  Timer timer;
+  if (parameters->options().stats())
+    timer.start();
+
+  // The parallel version empties the worklist, so the loop below has
+  // nothing left to do.
+  int threads = parallel_thread_count();
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+  if (threads > 1
+      && this->section_reloc_map().size() >= gc_parallel_min_sections)
+    this->do_parallel_transitive_closure(threads);
+  else
+#endif
+    threads = 1;
+
   while (!this->worklist().empty())
     {
       // Add elements from the work list to the referenced list
@@ -62,6 +87,192 @@ Garbage_collection::do_transitive_closure()
         }
     }
   this->worklist_ready();
+
+  if (parameters->options().stats())
+    {
+      this->mark_time_ = timer.get_elapsed_time();
+      this->mark_threads_ = threads;
+    }
+}
+
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+
+// The parallel transitive closure numbers the sections which have
+// references, and uses an atomic mark bit for each one.
+
+typedef Unordered_map<Section_id, unsigned int, Section_id_hash>
+  Gc_section_index;
+
+// One round of the parallel transitive closure.  The sections marked
+// in the previous round are divided among the pieces.  Each piece
+// keeps its own worklist, and marks sections reachable from its share
+// until it has done GC_MARK_ROUND_BUDGET of them; any sections it has
+// marked but not yet scanned are left for the next round, so that the
+// work is shared out again.
+
+class Gc_mark_work : public Parallel_work
+{
+ public:
+  typedef Garbage_collection::Section_ref::value_type Node;
+
+  Gc_mark_work(const std::vector<const Node*>& nodes,
+	       const Gc_section_index& index,
+	       std::vector<unsigned int>* marks,
+	       const std::vector<unsigned int>& frontier,
+	       size_t pieces)
+    : nodes_(nodes), index_(index), marks_(marks), frontier_(frontier),
+      pieces_(pieces), next_(pieces), leaves_(pieces)
+  { }
+
+  void
+  run_piece(size_t i);
+
+  // The sections marked but not scanned by piece I.
+  std::vector<unsigned int>&
+  next(size_t i)
+  { return this->next_[i]; }
+
+  // The referenced sections found by piece I which have no references
+  // of their own.  These are not numbered, and may be repeated.
+  const Garbage_collection::Worklist_type&
+  leaves(size_t i) const
+  { return this->leaves_[i]; }
+
+ private:
+  // The number of sections a piece scans in one round.
+  static const size_t gc_mark_round_budget = 4096;
+
+  const std::vector<const Node*>& nodes_;
+  const Gc_section_index& index_;
+  std::vector<unsigned int>* marks_;
+  const std::vector<unsigned int>& frontier_;
+  size_t pieces_;
+  std::vector<std::vector<unsigned int> > next_;
+  std::vector<Garbage_collection::Worklist_type> leaves_;
+};
+
+void
+Gc_mark_work::run_piece(size_t i)
+{
+  size_t start = this->frontier_.size() * i / this->pieces_;
+  size_t end = this->frontier_.size() * (i + 1) / this->pieces_;
+  std::vector<unsigned int> worklist(this->frontier_.begin() + start,
+				     this->frontier_.begin() + end);
+  std::vector<unsigned int>* next = &this->next_[i];
+  Garbage_collection::Worklist_type* leaves = &this->leaves_[i];
+  size_t scanned = 0;
+  while (!worklist.empty())
+    {
+      unsigned int n = worklist.back();
+      worklist.pop_back();
+      ++scanned;
+      const Garbage_collection::Sections_reachable& v =
+	this->nodes_[n]->second;
+      for (Garbage_collection::Sections_reachable::const_iterator p =
+	     v.begin();
+	   p != v.end();
+	   ++p)
+	{
+	  Gc_section_index::const_iterator q = this->index_.find(*p);
+	  if (q == this->index_.end())
+	    {
+	      leaves->push_back(*p);
+	      continue;
+	    }
+	  unsigned int m = q->second;
+	  if (!__sync_bool_compare_and_swap(&(*this->marks_)[m], 0, 1))
+	    continue;
+	  if (scanned < gc_mark_round_budget)
+	    worklist.push_back(m);
+	  else
+	    next->push_back(m);
+	}
+    }
+}
+
+// Do the transitive closure in parallel.  This adds the sections to
+// the referenced list in a different order, but the result is the
+// same.
+
+void
+Garbage_collection::do_parallel_transitive_closure(int threads)
+{
+  const Section_ref& refs(this->section_reloc_map());
+  std::vector<const Gc_mark_work::Node*> nodes;
+  nodes.reserve(refs.size());
+  Gc_section_index index;
+  for (Section_ref::const_iterator p = refs.begin(); p != refs.end(); ++p)
+    {
+      index[p->first] = nodes.size();
+      nodes.push_back(&*p);
+    }
+  std::vector<unsigned int> marks(nodes.size(), 0);
+
+  // Sections on the worklist which have no references need not be
+  // scanned.
+  std::vector<unsigned int> frontier;
+  for (Worklist_type::const_iterator p = this->worklist().begin();
+       p != this->worklist().end();
+       ++p)
+    {
+      Gc_section_index::const_iterator q = index.find(*p);
+      if (q == index.end())
+	this->referenced_list().insert(*p);
+      else if (marks[q->second] == 0)
+	{
+	  marks[q->second] = 1;
+	  frontier.push_back(q->second);
+	}
+    }
+  this->worklist().clear();
+
+  // Below this many sections a round runs in the calling thread.
+  const size_t min_piece_size = 256;
+  while (!frontier.empty())
+    {
+      size_t pieces = frontier.size() / min_piece_size;
+      if (pieces > static_cast<size_t>(threads))
+	pieces = threads;
+      else if (pieces == 0)
+	pieces = 1;
+      Gc_mark_work work(nodes, index, &marks, frontier, pieces);
+      run_parallel_work(&work, pieces);
+
+      frontier.clear();
+      for (size_t i = 0; i < pieces; ++i)
+	{
+	  frontier.insert(frontier.end(), work.next(i).begin(),
+			  work.next(i).end());
+	  const Worklist_type& leaves(work.leaves(i));
+	  for (Worklist_type::const_iterator p = leaves.begin();
+	       p != leaves.end();
+	       ++p)
+	    this->referenced_list().insert(*p);
+	}
+    }
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+    if (marks[i] != 0)
+      this->referenced_list().insert(nodes[i]->first);
+}
+
+#endif // defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
+// Print statistics about the transitive closure.
+
+void
+Garbage_collection::print_stats() const
+{
+  fprintf(stderr, _("%s: gc sections referenced: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(this->referenced_list_.size()));
+  fprintf(stderr,
+	  _("%s: gc mark time (%d threads): " \
+	    "(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)\n"),
+	  program_name, this->mark_threads_,
+	  this->mark_time_.user / 1000, (this->mark_time_.user % 1000) * 1000,
+	  this->mark_time_.sys / 1000, (this->mark_time_.sys % 1000) * 1000,
+	  this->mark_time_.wall / 1000, (this->mark_time_.wall % 1000) * 1000);
 }
 
 } // End namespace gold.
@@ -29,6 +29,7 @@
 #include "symtab.h"
 #include "object.h"
 #include "icf.h"
+#include "timer.h"
 
 namespace gold
 {
@@ -55,8 +56,12 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
-  { }
+  : is_worklist_ready_(false), mark_threads_(0)
+  {
+    this->mark_time_.user = 0;
+    this->mark_time_.sys = 0;
+    this->mark_time_.wall = 0;
+  }
 
   // Accessor methods for the private members.
 
@@ -83,6 +88,10 @@ class Garbage_collection
   void
   do_transitive_closure();
 
+  // Print statistics about the transitive closure to stderr.
+  void
+  print_stats() const;
+
   bool
   is_section_garbage(Relobj* obj, unsigned int shndx)
   { return (this->referenced_list().find(Section_id(obj, shndx))
@@ -111,11 +120,19 @@ class Garbage_collection
 
  private:
 
+  // Do the transitive closure using several threads.
+  void
+  do_parallel_transitive_closure(int threads);
+
   Worklist_type work_list_;
   bool is_worklist_ready_;
   Section_ref section_reloc_map_;
   Sections_reachable referenced_list_;
   Cident_section_map cident_sections_;
+  // The time taken by do_transitive_closure, if --stats.
+  Timer::TimeStats mark_time_;
+  // The number of threads used by do_transitive_closure.
+  int mark_threads_;
 };
 
 // Data to pass between successive invocations of do_layout
@@ -22,12 +22,15 @@
 
 #include "gold.h"
 
+#include <cstring>
+
 #include "gdb-index.h"
 #include "dwarf_reader.h"
 #include "dwarf.h"
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -171,6 +174,237 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// This class holds what we find when scanning the .debug_info and
+// .debug_types sections of one input object, until it is added to the
+// Gdb_index.  When using several threads, the objects are scanned in
+// parallel, and then added to the index in input order, so that the
+// result does not depend on the number of threads.
+
+class Gdb_index_scan
+{
+ public:
+  Gdb_index_scan(Relobj* object)
+    : object_(object), pending_sections_(), symbols_(NULL), symbols_size_(0),
+      comp_units_(), type_units_(), ranges_(), symbols_found_(),
+      symbol_names_(), cu_count_(0), cu_nopubnames_count_(0), tu_count_(0),
+      tu_nopubnames_count_(0), pubnames_reader_(NULL),
+      pubnames_table_(NULL), pubtypes_table_(NULL), cu_pubname_map_(),
+      cu_pubtype_map_(), stmt_list_offset_(-1)
+  { }
+
+  ~Gdb_index_scan();
+
+  // Return the object being scanned.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a .debug_info or .debug_types section to scan later.
+  void
+  add_pending_section(bool is_type_unit, const unsigned char* symbols,
+		      off_t symbols_size, unsigned int shndx,
+		      unsigned int reloc_shndx, unsigned int reloc_type);
+
+  // Scan the sections recorded by add_pending_section.
+  void
+  scan_pending_sections();
+
+  // Scan a .debug_info or .debug_types section.
+  void
+  scan(bool is_type_unit, const unsigned char* symbols, off_t symbols_size,
+       unsigned int shndx, unsigned int reloc_shndx,
+       unsigned int reloc_type);
+
+  // Add everything found so far to GDB_INDEX, and forget it.
+  void
+  add_to_index(Gdb_index* gdb_index);
+
+  // The functions below are called by Gdb_index_info_reader.  The
+  // CU and TU indexes they use are local to this object.
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    ++this->cu_count_;
+    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    ++this->tu_count_;
+    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Record that a CU or TU has no pubnames or pubtypes.
+  void
+  set_no_pubnames(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_nopubnames_count_;
+    else
+      ++this->cu_nopubnames_count_;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(int cu_index, Dwarf_range_list* ranges)
+  { this->ranges_.push_back(std::make_pair(cu_index, ranges)); }
+
+  // Add a symbol.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUs associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset) const
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return this->pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return this->pubtypes_table_; }
+
+  // Print usage statistics.
+  static void
+  print_stats();
+
+ private:
+  Gdb_index_scan(const Gdb_index_scan&);
+  Gdb_index_scan& operator=(const Gdb_index_scan&);
+
+  // A section to scan.
+  struct Pending_section
+  {
+    Pending_section(bool is_tu, unsigned int sh, unsigned int rsh,
+		    unsigned int rtype)
+      : is_type_unit(is_tu), shndx(sh), reloc_shndx(rsh), reloc_type(rtype)
+    { }
+
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  // An entry in the compilation unit list.
+  struct Comp_unit
+  {
+    Comp_unit(off_t off, off_t len)
+      : cu_offset(off), cu_length(len)
+    { }
+    off_t cu_offset;
+    off_t cu_length;
+  };
+
+  // An entry in the type unit list.
+  struct Type_unit
+  {
+    Type_unit(off_t off, off_t toff, uint64_t sig)
+      : tu_offset(off), type_offset(toff), type_signature(sig)
+    { }
+    off_t tu_offset;
+    off_t type_offset;
+    uint64_t type_signature;
+  };
+
+  // A symbol found in a CU or TU.  The name is at NAME_OFFSET in
+  // symbol_names_.
+  struct Found_symbol
+  {
+    Found_symbol(int index, size_t offset, uint8_t f)
+      : cu_index(index), name_offset(offset), flags(f)
+    { }
+    int cu_index;
+    size_t name_offset;
+    uint8_t flags;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Create a map from dies to pubnames.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+                       Gdb_index_info_reader* dwinfo,
+                       const unsigned char* symbols,
+                       off_t symbols_size);
+
+  // Wrapper for map_pubtable_to_dies.
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+                                 const unsigned char* symbols,
+                                 off_t symbols_size);
+
+  // The object being scanned.
+  Relobj* object_;
+  // Sections to scan in scan_pending_sections.
+  std::vector<Pending_section> pending_sections_;
+  // A copy of the symbol table for the pending sections.
+  unsigned char* symbols_;
+  off_t symbols_size_;
+  // What we have found.
+  std::vector<Comp_unit> comp_units_;
+  std::vector<Type_unit> type_units_;
+  std::vector<std::pair<int, Dwarf_range_list*> > ranges_;
+  std::vector<Found_symbol> symbols_found_;
+  // The names of the symbols, each terminated by a null byte.
+  std::string symbol_names_;
+  // Statistics not yet added to the totals.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
+  // The reader used to read the pubnames and pubtypes tables, which
+  // must live as long as the tables do.
+  Gdb_index_info_reader* pubnames_reader_;
+  // Tables to store the pubnames sections of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // The stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes.
+  off_t stmt_list_offset_;
+
+  // Statistics.
+  // Total number of DWARF compilation units processed.
+  static unsigned int dwarf_cu_count;
+  // Number of DWARF compilation units without pubnames/pubtypes.
+  static unsigned int dwarf_cu_nopubnames_count;
+  // Total number of DWARF type units processed.
+  static unsigned int dwarf_tu_count;
+  // Number of DWARF type units without pubnames/pubtypes.
+  static unsigned int dwarf_tu_nopubnames_count;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,19 +417,15 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
-  // Print usage statistics.
-  static void
-  print_stats();
-
  protected:
   // Visit a compilation unit.
   virtual void
@@ -285,8 +515,8 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
+  // The scan of the object.
+  Gdb_index_scan* scan_;
   // The current CU index (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
@@ -294,35 +524,15 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   // Map from DIE offset to (parent offset, name) pair,
   // for DW_AT_specification.
   Declaration_map declarations_;
-
-  // Statistics.
-  // Total number of DWARF compilation units processed.
-  static unsigned int dwarf_cu_count;
-  // Number of DWARF compilation units with pubnames/pubtypes.
-  static unsigned int dwarf_cu_nopubnames_count;
-  // Total number of DWARF type units processed.
-  static unsigned int dwarf_tu_count;
-  // Number of DWARF type units with pubnames/pubtypes.
-  static unsigned int dwarf_tu_nopubnames_count;
 };
 
-// Total number of DWARF compilation units processed.
-unsigned int Gdb_index_info_reader::dwarf_cu_count = 0;
-// Number of DWARF compilation units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_cu_nopubnames_count = 0;
-// Total number of DWARF type units processed.
-unsigned int Gdb_index_info_reader::dwarf_tu_count = 0;
-// Number of DWARF type units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_tu_nopubnames_count = 0;
-
 // Process a compilation unit and parse its child DIE.
 
 void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +543,9 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -380,10 +589,8 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			     this->object()->name().c_str());
 		return;
 	      }
-	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
-	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	    this->scan_->set_no_pubnames(die->tag()
+					 != elfcpp::DW_TAG_compile_unit);
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,7 +644,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
+	      this->scan_->add_symbol(this->cu_index_,
                                            full_name.c_str(), 0);
 	  }
 	break;
@@ -477,7 +684,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
+		this->scan_->add_symbol(this->cu_index_,
 					     full_name.c_str(), 0);
 	    }
 
@@ -825,8 +1032,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -851,8 +1057,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
@@ -877,7 +1082,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,8 +1121,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -928,10 +1132,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1143,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -964,55 +1168,163 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
-// Print usage statistics.
+// Class Gdb_index_scan.
+
+// Total number of DWARF compilation units processed.
+unsigned int Gdb_index_scan::dwarf_cu_count = 0;
+// Number of DWARF compilation units without pubnames/pubtypes.
+unsigned int Gdb_index_scan::dwarf_cu_nopubnames_count = 0;
+// Total number of DWARF type units processed.
+unsigned int Gdb_index_scan::dwarf_tu_count = 0;
+// Number of DWARF type units without pubnames/pubtypes.
+unsigned int Gdb_index_scan::dwarf_tu_nopubnames_count = 0;
+
+Gdb_index_scan::~Gdb_index_scan()
+{
+  delete[] this->symbols_;
+  delete this->pubnames_table_;
+  delete this->pubtypes_table_;
+  delete this->pubnames_reader_;
+}
+
+// Record a section to scan later.  All the sections of an object use
+// the same symbol table, so we only need to copy it once.
+
 void
-Gdb_index_info_reader::print_stats()
+Gdb_index_scan::add_pending_section(bool is_type_unit,
+				    const unsigned char* symbols,
+				    off_t symbols_size,
+				    unsigned int shndx,
+				    unsigned int reloc_shndx,
+				    unsigned int reloc_type)
 {
-  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_count);
-  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_nopubnames_count);
-  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_count);
-  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
+  if (this->pending_sections_.empty() && symbols != NULL)
+    {
+      this->symbols_ = new unsigned char[symbols_size];
+      memcpy(this->symbols_, symbols, symbols_size);
+      this->symbols_size_ = symbols_size;
+    }
+  this->pending_sections_.push_back(Pending_section(is_type_unit, shndx,
+						   reloc_shndx, reloc_type));
 }
 
-// Class Gdb_index.
+// Scan the pending sections.  The caller must have locked the object.
 
-// Construct the .gdb_index section.
+void
+Gdb_index_scan::scan_pending_sections()
+{
+  for (std::vector<Pending_section>::const_iterator p =
+	 this->pending_sections_.begin();
+       p != this->pending_sections_.end();
+       ++p)
+    this->scan(p->is_type_unit, this->symbols_, this->symbols_size_,
+	       p->shndx, p->reloc_shndx, p->reloc_type);
+  this->pending_sections_.clear();
+
+  // We are done with the object, so free what we can before the
+  // results are added to the index.
+  delete[] this->symbols_;
+  this->symbols_ = NULL;
+  delete this->pubnames_table_;
+  this->pubnames_table_ = NULL;
+  delete this->pubtypes_table_;
+  this->pubtypes_table_ = NULL;
+  delete this->pubnames_reader_;
+  this->pubnames_reader_ = NULL;
+}
 
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+// Scan a .debug_info or .debug_types input section.
+
+void
+Gdb_index_scan::scan(bool is_type_unit,
+		     const unsigned char* symbols,
+		     off_t symbols_size,
+		     unsigned int shndx,
+		     unsigned int reloc_shndx,
+		     unsigned int reloc_type)
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  Gdb_index_info_reader* dwinfo =
+    new Gdb_index_info_reader(is_type_unit, this->object_,
+			      symbols, symbols_size,
+			      shndx, reloc_shndx,
+			      reloc_type, this);
+  if (this->pubnames_reader_ == NULL)
+    {
+      this->pubnames_reader_ = dwinfo;
+      this->map_pubnames_and_types_to_dies(dwinfo, symbols, symbols_size);
+    }
+  dwinfo->parse();
+  if (dwinfo != this->pubnames_reader_)
+    delete dwinfo;
 }
 
-Gdb_index::~Gdb_index()
+// Add what we have found to GDB_INDEX.  Our CU and TU indexes count
+// from zero, so they must be adjusted by the number of units already
+// in the index.
+
+void
+Gdb_index_scan::add_to_index(Gdb_index* gdb_index)
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
+  const int cu_base = gdb_index->comp_unit_count();
+  const int tu_base = gdb_index->type_unit_count();
+
+  for (std::vector<Comp_unit>::const_iterator p = this->comp_units_.begin();
+       p != this->comp_units_.end();
+       ++p)
+    gdb_index->add_comp_unit(p->cu_offset, p->cu_length);
+  for (std::vector<Type_unit>::const_iterator p = this->type_units_.begin();
+       p != this->type_units_.end();
+       ++p)
+    gdb_index->add_type_unit(p->tu_offset, p->type_offset, p->type_signature);
+
+  for (std::vector<std::pair<int, Dwarf_range_list*> >::const_iterator p =
+	 this->ranges_.begin();
+       p != this->ranges_.end();
+       ++p)
+    {
+      int cu_index = p->first;
+      cu_index = cu_index >= 0 ? cu_base + cu_index : cu_index - tu_base;
+      gdb_index->add_address_range_list(this->object_, cu_index, p->second);
+    }
+
+  for (std::vector<Found_symbol>::const_iterator p =
+	 this->symbols_found_.begin();
+       p != this->symbols_found_.end();
+       ++p)
+    {
+      int cu_index = p->cu_index;
+      cu_index = cu_index >= 0 ? cu_base + cu_index : cu_index - tu_base;
+      gdb_index->add_symbol(cu_index,
+			    this->symbol_names_.data() + p->name_offset,
+			    p->flags);
+    }
+
+  this->comp_units_.clear();
+  this->type_units_.clear();
+  this->ranges_.clear();
+  this->symbols_found_.clear();
+  this->symbol_names_.clear();
+
+  Gdb_index_scan::dwarf_cu_count += this->cu_count_;
+  Gdb_index_scan::dwarf_cu_nopubnames_count += this->cu_nopubnames_count_;
+  Gdb_index_scan::dwarf_tu_count += this->tu_count_;
+  Gdb_index_scan::dwarf_tu_nopubnames_count += this->tu_nopubnames_count_;
+  this->cu_count_ = 0;
+  this->cu_nopubnames_count_ = 0;
+  this->tu_count_ = 0;
+  this->tu_nopubnames_count_ = 0;
 }
 
+// Add a symbol.
+
+void
+Gdb_index_scan::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+{
+  this->symbols_found_.push_back(Found_symbol(cu_index,
+					      this->symbol_names_.size(),
+					      flags));
+  this->symbol_names_.append(sym_name, strlen(sym_name) + 1);
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1332,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo,
+				     const unsigned char* symbols,
+				     off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,7 +1353,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, symbols, symbols_size))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1054,33 +1365,26 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
   return table;
 }
 
-// Wrapper for map_pubtable_to_dies
+// Wrapper for map_pubtable_to_dies.
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_scan::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+					       const unsigned char* symbols,
+					       off_t symbols_size)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = -1;
-
-  delete this->pubnames_table_;
   this->pubnames_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
-  delete this->pubtypes_table_;
+                                   symbols, symbols_size);
   this->pubtypes_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1396,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1100,7 +1404,92 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Print usage statistics.
+void
+Gdb_index_scan::print_stats()
+{
+  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
+          program_name, Gdb_index_scan::dwarf_cu_count);
+  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index_scan::dwarf_cu_nopubnames_count);
+  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
+          program_name, Gdb_index_scan::dwarf_tu_count);
+  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index_scan::dwarf_tu_nopubnames_count);
+}
+
+// Scan the objects in a group which share an input file.  Archive
+// members share a File_read, which may only be used by one thread at
+// a time, so each group is scanned by one thread.
+
+class Gdb_index_scan_work : public Parallel_work
+{
+ public:
+  Gdb_index_scan_work(const std::vector<std::vector<Gdb_index_scan*> >& groups)
+    : groups_(groups)
+  { }
+
+  void
+  run_piece(size_t i)
+  {
+    const std::vector<Gdb_index_scan*>& group(this->groups_[i]);
+    // We have no way to pass in a Task token.
+    const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+    Relobj* object = group.front()->object();
+    object->lock(dummy_task);
+    for (std::vector<Gdb_index_scan*>::const_iterator p = group.begin();
+	 p != group.end();
+	 ++p)
+      (*p)->scan_pending_sections();
+    object->unlock(dummy_task);
+  }
+
+ private:
+  const std::vector<std::vector<Gdb_index_scan*> >& groups_;
+};
+
+// Class Gdb_index.
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    current_scan_(NULL),
+    pending_scans_(),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  if (this->pending_scans_.empty())
+    delete this->current_scan_;
+  for (unsigned int i = 0; i < this->pending_scans_.size(); ++i)
+    delete this->pending_scans_[i];
+}
+
+
+// Scan a .debug_info or .debug_types input section.  When using
+// several threads, we just record the section here, and scan it in
+// set_final_data_size along with the sections of all the other
+// objects.
 
 void
 Gdb_index::scan_debug_info(bool is_type_unit,
@@ -1111,13 +1500,63 @@ Gdb_index::scan_debug_info(bool is_type_unit,
 			   unsigned int reloc_shndx,
 			   unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  const bool defer = (parallel_thread_count() > 1
+		      && !parameters->incremental());
+  if (this->current_scan_ == NULL || this->current_scan_->object() != object)
+    {
+      if (!defer)
+	delete this->current_scan_;
+      this->current_scan_ = new Gdb_index_scan(object);
+      if (defer)
+	this->pending_scans_.push_back(this->current_scan_);
+    }
+
+  if (defer)
+    this->current_scan_->add_pending_section(is_type_unit, symbols,
+					     symbols_size, shndx,
+					     reloc_shndx, reloc_type);
+  else
+    {
+      this->current_scan_->scan(is_type_unit, symbols, symbols_size, shndx,
+				reloc_shndx, reloc_type);
+      this->current_scan_->add_to_index(this);
+    }
+}
+
+// Scan the objects recorded by scan_debug_info in parallel, and add
+// what they contain to the index in input order.
+
+void
+Gdb_index::scan_pending_objects()
+{
+  std::vector<std::vector<Gdb_index_scan*> > groups;
+  Unordered_map<const File_read*, size_t> group_index;
+  for (std::vector<Gdb_index_scan*>::const_iterator p =
+	 this->pending_scans_.begin();
+       p != this->pending_scans_.end();
+       ++p)
+    {
+      const File_read* file = &(*p)->object()->input_file()->file();
+      std::pair<Unordered_map<const File_read*, size_t>::iterator, bool> ins =
+	group_index.insert(std::make_pair(file, groups.size()));
+      if (ins.second)
+	groups.push_back(std::vector<Gdb_index_scan*>());
+      groups[ins.first->second].push_back(*p);
+    }
+
+  Gdb_index_scan_work work(groups);
+  run_parallel_work(&work, groups.size());
+
+  for (std::vector<Gdb_index_scan*>::const_iterator p =
+	 this->pending_scans_.begin();
+       p != this->pending_scans_.end();
+       ++p)
+    {
+      (*p)->add_to_index(this);
+      delete *p;
+    }
+  this->pending_scans_.clear();
+  this->current_scan_ = NULL;
 }
 
 // Add a symbol.
@@ -1156,32 +1595,14 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
     cu_vec->push_back(std::make_pair(cu_index, flags));
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
-}
-
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
-
-void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
-{
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
-}
-
 // Set the size of the .gdb_index section.
 
 void
 Gdb_index::set_final_data_size()
 {
+  if (!this->pending_scans_.empty())
+    this->scan_pending_objects();
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -1353,7 +1774,7 @@ void
 Gdb_index::print_stats()
 {
   if (parameters->options().gdb_index())
-    Gdb_index_info_reader::print_stats();
+    Gdb_index_scan::print_stats();
 }
 
 } // End namespace gold.
@@ -23,6 +23,7 @@
 #include "gold.h"
 
 #include <cstring>
+#include <unistd.h>
 
 #ifdef ENABLE_THREADS
 #include <pthread.h>
@@ -447,4 +448,268 @@ Initialize_lock::do_run_once(void*)
   *this->pplock_ = new Lock();
 }
 
+// Return the number of threads to use for run_parallel_work.  We use
+// the final thread count if one was specified, as that is when most
+// of this work happens, and otherwise the number of processors.
+
+int
+parallel_thread_count()
+{
+#ifndef ENABLE_THREADS
+  return 1;
+#else
+  if (!parameters->options().threads())
+    return 1;
+  int count = parameters->options().thread_count_final();
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+  if (count == 0)
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return count > 1 ? count : 1;
+#endif
+}
+
+// Class Parallel_work_group.
+
+Parallel_work_group::Parallel_work_group(Parallel_work* work, size_t count)
+  : work_(work), count_(count), lock_(), condvar_(this->lock_), next_(0),
+    finished_(0), refs_(1)
+{
+}
+
+void
+Parallel_work_group::add_ref()
+{
+  Hold_lock hl(this->lock_);
+  ++this->refs_;
+}
+
+void
+Parallel_work_group::release()
+{
+  bool last;
+  {
+    Hold_lock hl(this->lock_);
+    gold_assert(this->refs_ > 0);
+    --this->refs_;
+    last = this->refs_ == 0;
+  }
+  if (last)
+    delete this;
+}
+
+void
+Parallel_work_group::run_pieces()
+{
+  size_t i;
+  {
+    Hold_lock hl(this->lock_);
+    if (this->next_ >= this->count_)
+      return;
+    i = this->next_;
+    ++this->next_;
+  }
+
+  while (true)
+    {
+      this->work_->run_piece(i);
+
+      Hold_lock hl(this->lock_);
+      ++this->finished_;
+      if (this->finished_ == this->count_)
+	this->condvar_.broadcast();
+      if (this->next_ >= this->count_)
+	return;
+      i = this->next_;
+      ++this->next_;
+    }
+}
+
+void
+Parallel_work_group::wait()
+{
+  Hold_lock hl(this->lock_);
+  while (this->finished_ < this->count_)
+    this->condvar_.wait();
+}
+
+// The object which finds helper threads for run_parallel_work, if
+// any.
+
+static Parallel_work_helpers* parallel_work_helpers;
+
+void
+set_parallel_work_helpers(Parallel_work_helpers* helpers)
+{
+  parallel_work_helpers = helpers;
+}
+
+#ifdef ENABLE_THREADS
+
+// Class Parallel_work_pool is a set of threads which help run the
+// pieces of a Parallel_work when there is no Workqueue to do it, as
+// in dwp.  The threads are started the first time they are needed,
+// and wait for more work until the program exits.
+
+class Parallel_work_pool : public Parallel_work_helpers
+{
+ public:
+  Parallel_work_pool(int thread_count);
+
+  void
+  add_helpers(Parallel_work_group* group, int count);
+
+  // Return the pool, starting it if necessary.
+  static Parallel_work_pool*
+  get();
+
+  // A function to pass to pthread_create.
+  static void*
+  thread_body(void*);
+
+ private:
+  Parallel_work_pool(const Parallel_work_pool&);
+  Parallel_work_pool& operator=(const Parallel_work_pool&);
+
+  // Run groups until the program exits.
+  void
+  run();
+
+  // The number of threads.
+  int thread_count_;
+  // Lock controlling groups_.
+  Lock lock_;
+  // Signalled when a group is added.
+  Condvar condvar_;
+  // The groups waiting for a helper.  A group appears once for each
+  // helper it asked for.
+  std::vector<Parallel_work_group*> groups_;
+};
+
+// A class to start the pool once.
+
+class Parallel_work_pool_once : public Once
+{
+ public:
+  Parallel_work_pool_once()
+    : pool_(NULL)
+  { }
+
+  Parallel_work_pool*
+  pool()
+  {
+    this->run_once(NULL);
+    return this->pool_;
+  }
+
+ protected:
+  void
+  do_run_once(void*)
+  { this->pool_ = new Parallel_work_pool(parallel_thread_count() - 1); }
+
+ private:
+  Parallel_work_pool* pool_;
+};
+
+static Parallel_work_pool_once parallel_work_pool_once;
+
+Parallel_work_pool*
+Parallel_work_pool::get()
+{
+  return parallel_work_pool_once.pool();
+}
+
+Parallel_work_pool::Parallel_work_pool(int thread_count)
+  : thread_count_(thread_count), lock_(), condvar_(this->lock_), groups_()
+{
+  for (int i = 0; i < thread_count; ++i)
+    {
+      pthread_t tid;
+      int err = pthread_create(&tid, NULL, &Parallel_work_pool::thread_body,
+			       reinterpret_cast<void*>(this));
+      if (err != 0)
+	gold_fatal(_("pthread_create failed: %s"), strerror(err));
+      err = pthread_detach(tid);
+      if (err != 0)
+	gold_fatal(_("pthread_detach failed: %s"), strerror(err));
+    }
+}
+
+void
+Parallel_work_pool::add_helpers(Parallel_work_group* group, int count)
+{
+  if (count > this->thread_count_)
+    count = this->thread_count_;
+  if (count <= 0)
+    return;
+
+  Hold_lock hl(this->lock_);
+  for (int i = 0; i < count; ++i)
+    {
+      group->add_ref();
+      this->groups_.push_back(group);
+    }
+  this->condvar_.broadcast();
+}
+
+void
+Parallel_work_pool::run()
+{
+  while (true)
+    {
+      Parallel_work_group* group;
+      {
+	Hold_lock hl(this->lock_);
+	while (this->groups_.empty())
+	  this->condvar_.wait();
+	group = this->groups_.front();
+	this->groups_.erase(this->groups_.begin());
+      }
+      group->run_pieces();
+      group->release();
+    }
+}
+
+extern "C"
+void*
+Parallel_work_pool::thread_body(void* arg)
+{
+  reinterpret_cast<Parallel_work_pool*>(arg)->run();
+  return NULL;
+}
+
+#endif // defined(ENABLE_THREADS)
+
+// Run all the pieces of WORK.  Other threads are asked to help, but
+// we only wait for the pieces which they actually started, so that a
+// busy thread can never hold us up.
+
+void
+run_parallel_work(Parallel_work* work, size_t count)
+{
+  size_t threads = parallel_thread_count();
+  if (threads > count)
+    threads = count;
+
+  if (threads <= 1)
+    {
+      for (size_t i = 0; i < count; ++i)
+	work->run_piece(i);
+      return;
+    }
+
+#ifndef ENABLE_THREADS
+  gold_unreachable();
+#else
+  Parallel_work_group* group = new Parallel_work_group(work, count);
+  Parallel_work_helpers* helpers = parallel_work_helpers;
+  if (helpers == NULL)
+    helpers = Parallel_work_pool::get();
+  helpers->add_helpers(group, threads - 1);
+  group->run_pieces();
+  group->wait();
+  group->release();
+#endif
+}
+
 } // End namespace gold.
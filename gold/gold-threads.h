@@ -31,6 +31,9 @@
 #ifndef GOLD_THREADS_H
 #define GOLD_THREADS_H
 
+#include <algorithm>
+#include <vector>
+
 namespace gold
 {
 
@@ -262,6 +265,202 @@ class Initialize_lock : public Once
   Lock** const pplock_;
 };
 
+// An operation which is divided into independent pieces which may be
+// run in parallel.  This is for work which must be finished before
+// the current Task can continue, and so can not simply be split into
+// separate Tasks on the Workqueue.
+
+class Parallel_work
+{
+ public:
+  virtual
+  ~Parallel_work()
+  { }
+
+  // Run piece number I.  This may be called in any thread, and may
+  // be called at the same time for different values of I.
+  virtual void
+  run_piece(size_t i) = 0;
+};
+
+// The state of a single call to run_parallel_work.  The calling
+// thread and any helper threads each take the next piece which
+// nobody has started yet, until there are none left.  A helper may
+// not get around to looking at the group until all the pieces are
+// done, so the group is reference counted, and is deleted when the
+// last thread which knows about it lets go.
+
+class Parallel_work_group
+{
+ public:
+  // The group starts with one reference, for the caller.
+  Parallel_work_group(Parallel_work* work, size_t count);
+
+  // Add a reference for a helper thread.
+  void
+  add_ref();
+
+  // Drop a reference, deleting the group if it was the last one.
+  void
+  release();
+
+  // Run pieces until there are none left to start.
+  void
+  run_pieces();
+
+  // Wait until all the pieces have finished.
+  void
+  wait();
+
+ private:
+  Parallel_work_group(const Parallel_work_group&);
+  Parallel_work_group& operator=(const Parallel_work_group&);
+
+  ~Parallel_work_group()
+  { }
+
+  // The work to do.
+  Parallel_work* work_;
+  // The number of pieces.
+  size_t count_;
+  // Lock controlling the remaining fields.
+  Lock lock_;
+  // Signalled when the last piece finishes.
+  Condvar condvar_;
+  // The next piece to run.
+  size_t next_;
+  // The number of pieces which have finished.
+  size_t finished_;
+  // The number of references.
+  int refs_;
+};
+
+// An interface for finding threads to help run a Parallel_work.  The
+// Workqueue implements this, so that the pieces run on the threads
+// it already has.
+
+class Parallel_work_helpers
+{
+ public:
+  virtual
+  ~Parallel_work_helpers()
+  { }
+
+  // Arrange for up to COUNT other threads to call run_pieces and
+  // then release on GROUP, calling add_ref for each of them.  This
+  // must not wait for those threads.
+  virtual void
+  add_helpers(Parallel_work_group* group, int count) = 0;
+};
+
+// Set the object which run_parallel_work uses to find helper threads.
+// If this is NULL, run_parallel_work uses a pool of threads of its
+// own, which is started the first time it is needed.
+
+extern void
+set_parallel_work_helpers(Parallel_work_helpers*);
+
+// Return the number of threads, including the calling thread, which
+// run_parallel_work will use.  This is 1 if we are not using threads.
+
+extern int
+parallel_thread_count();
+
+// Run pieces 0 through COUNT - 1 of WORK, and return when they have
+// all finished.  The calling thread runs pieces too.  If we are not
+// using threads, the pieces are run in order in the calling thread.
+
+extern void
+run_parallel_work(Parallel_work* work, size_t count);
+
+// Sort the vector V using COMP, dividing the work among threads with
+// run_parallel_work.  The vector is split into equal ranges which are
+// sorted separately and then merged in a fixed order, so the result
+// is always the same as that of std::stable_sort.
+
+template<typename Value, typename Compare>
+class Parallel_sort_work : public Parallel_work
+{
+ public:
+  typedef typename std::vector<Value>::iterator Iterator;
+
+  Parallel_sort_work(std::vector<Value>* from, std::vector<Value>* to,
+		     const std::vector<size_t>& bounds, Compare comp)
+    : from_(from), to_(to), bounds_(bounds), comp_(comp), width_(0)
+  { }
+
+  // Set the number of sorted ranges to merge into one.  If this is
+  // zero, each piece sorts a single range in place.
+  void
+  set_width(size_t width)
+  { this->width_ = width; }
+
+  void
+  run_piece(size_t i)
+  {
+    const size_t nranges = this->bounds_.size() - 1;
+    if (this->width_ == 0)
+      {
+	std::stable_sort(this->from_->begin() + this->bounds_[i],
+			 this->from_->begin() + this->bounds_[i + 1],
+			 this->comp_);
+	return;
+      }
+
+    // Merge ranges [START, MID) and [MID, END) of FROM_ into TO_.
+    size_t start = i * 2 * this->width_;
+    size_t mid = std::min(start + this->width_, nranges);
+    size_t end = std::min(start + 2 * this->width_, nranges);
+    Iterator b = this->from_->begin();
+    std::merge(b + this->bounds_[start], b + this->bounds_[mid],
+	       b + this->bounds_[mid], b + this->bounds_[end],
+	       this->to_->begin() + this->bounds_[start], this->comp_);
+  }
+
+ private:
+  std::vector<Value>* from_;
+  std::vector<Value>* to_;
+  const std::vector<size_t>& bounds_;
+  Compare comp_;
+  size_t width_;
+};
+
+template<typename Value, typename Compare>
+void
+parallel_sort(std::vector<Value>* v, Compare comp)
+{
+  // Below this size it is not worth starting threads.
+  const size_t min_parallel_size = 16384;
+
+  size_t nranges = parallel_thread_count();
+  if (nranges <= 1 || v->size() < min_parallel_size)
+    {
+      std::stable_sort(v->begin(), v->end(), comp);
+      return;
+    }
+
+  std::vector<size_t> bounds(nranges + 1);
+  for (size_t i = 0; i <= nranges; ++i)
+    bounds[i] = v->size() / nranges * i;
+  bounds[nranges] = v->size();
+
+  std::vector<Value> tmp(v->size());
+  Parallel_sort_work<Value, Compare> work(v, &tmp, bounds, comp);
+  run_parallel_work(&work, nranges);
+
+  std::vector<Value>* from = v;
+  std::vector<Value>* to = &tmp;
+  for (size_t width = 1; width < nranges; width *= 2)
+    {
+      Parallel_sort_work<Value, Compare> merge(from, to, bounds, comp);
+      merge.set_width(width);
+      run_parallel_work(&merge, (nranges + 2 * width - 1) / (2 * width));
+      std::swap(from, to);
+    }
+  if (from != v)
+    v->swap(*from);
+}
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_THREADS_H)
@@ -46,6 +46,7 @@
 #include "icf.h"
 #include "incremental.h"
 #include "timer.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -230,8 +231,13 @@ queue_initial_tasks(const General_options& options,
   Task_token* this_blocker = NULL;
   if (ibase == NULL)
     {
-      // Normal link.  Queue a Read_symbols task for each input file
-      // on the command line.
+      // Normal link.  If requested, start reading all the input
+      // files in the background.
+      if (options.prefetch_inputs())
+	workqueue->queue(new Prefetch_inputs(&cmdline));
+
+      // Queue a Read_symbols task for each input file on the command
+      // line.
       for (Command_line::const_iterator p = cmdline.begin();
 	   p != cmdline.end();
 	   ++p)
@@ -453,7 +459,7 @@ queue_middle_gc_tasks(const General_options& options,
       Task_token* next_blocker = new Task_token(true);
       next_blocker->add_blocker();
       workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
-				       next_blocker));
+				       next_blocker, NULL, NULL));
       this_blocker = next_blocker;
     }
 
@@ -556,11 +562,13 @@ queue_middle_tasks(const General_options& options,
   layout->finalize_eh_frame_section();
 
   /* If plugins have specified a section order, re-arrange input sections
-     according to a specified section order.  If --section-ordering-file is
-     also specified, do not do anything here.  */
+     according to a specified section order.  If --section-ordering-file or
+     --call-graph-ordering-file is also specified, do not do anything
+     here.  */
   if (parameters->options().has_plugins()
       && layout->is_section_ordering_specified()
-      && !parameters->options().section_ordering_file ())
+      && !parameters->options().section_ordering_file ()
+      && !parameters->options().call_graph_ordering_file ())
     {
       for (Layout::Section_list::const_iterator p
 	     = layout->section_list().begin();
@@ -740,6 +748,28 @@ queue_middle_tasks(const General_options& options,
       // Doing that is more complex, since we may later decide to discard
       // some of the sections, and thus change our minds about the types
       // of references made to the symbols.
+      //
+      // When running with threads, and the target supports it, the
+      // Read_relocs tasks also drop the relocations which would not
+      // change anything when scanned.  That leaves less work for the
+      // Scan_relocs tasks, which must run one at a time in input
+      // order so that GOT and PLT entries and dynamic relocations are
+      // allocated deterministically.  The prescan looks at the symbol
+      // table, so it waits for the common symbols to be allocated, and
+      // all of the prescans must finish before the first Scan_relocs
+      // task starts.
+      Task_token* symtab_blocker = NULL;
+      Task_token* prescan_blocker = NULL;
+      if (parallel_thread_count() > 1
+	  && !parameters->options().relocatable()
+	  && input_objects->number_of_relobjs() > 1
+	  && target->can_prescan_relocs())
+	{
+	  symtab_blocker = this_blocker;
+	  prescan_blocker = new Task_token(true);
+	  prescan_blocker->add_blockers(input_objects->number_of_relobjs());
+	  this_blocker = prescan_blocker;
+	}
       for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
 	   p != input_objects->relobj_end();
 	   ++p)
@@ -747,7 +777,8 @@ queue_middle_tasks(const General_options& options,
 	  Task_token* next_blocker = new Task_token(true);
 	  next_blocker->add_blocker();
 	  workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
-					   next_blocker));
+					   next_blocker, symtab_blocker,
+					   prescan_blocker));
 	  this_blocker = next_blocker;
 	}
     }
@@ -805,31 +836,40 @@ queue_final_tasks(const General_options& options,
 
   bool any_postprocessing_sections = layout->any_postprocessing_sections();
 
+  // Split the output sections into pieces, each written by a
+  // Write_sections_task.
+  size_t write_sections_count = layout->prepare_write_output_sections(of);
+
   // Use a blocker to wait until all the input sections have been
   // written out.
   Task_token* input_sections_blocker = NULL;
   if (!any_postprocessing_sections)
     {
       input_sections_blocker = new Task_token(true);
-      // Write_symbols_task, Relocate_tasks.
-      input_sections_blocker->add_blocker();
+      // Write_sections_tasks, Relocate_tasks.
+      input_sections_blocker->add_blockers(write_sections_count);
       input_sections_blocker->add_blockers(input_objects->number_of_relobjs());
     }
 
   // Use a blocker to block any objects which have to wait for the
   // output sections to complete before they can apply relocations.
   Task_token* output_sections_blocker = new Task_token(true);
-  output_sections_blocker->add_blocker();
+  output_sections_blocker->add_blockers(write_sections_count);
 
   // Use a blocker to block the final cleanup task.
   Task_token* final_blocker = new Task_token(true);
-  // Write_symbols_task, Write_sections_task, Write_data_task,
+  // Write_symbols_task, Write_sections_tasks, Write_data_task,
   // Relocate_tasks.
-  final_blocker->add_blockers(3);
+  final_blocker->add_blockers(2);
+  final_blocker->add_blockers(write_sections_count);
   final_blocker->add_blockers(input_objects->number_of_relobjs());
   if (!any_postprocessing_sections)
     final_blocker->add_blocker();
 
+  // If we can, hash the output file for a tree-style build ID as it
+  // is written.
+  layout->prepare_build_id_tree_hash(input_objects, of, workqueue);
+
   // Queue a task to write out the symbol table.
   workqueue->queue(new Write_symbols_task(layout,
 					  symtab,
@@ -839,10 +879,12 @@ queue_final_tasks(const General_options& options,
 					  of,
 					  final_blocker));
 
-  // Queue a task to write out the output sections.
-  workqueue->queue(new Write_sections_task(layout, of, output_sections_blocker,
-					   input_sections_blocker,
-					   final_blocker));
+  // Queue tasks to write out the output sections.
+  for (size_t i = 0; i < write_sections_count; ++i)
+    workqueue->queue(new Write_sections_task(layout, of, i,
+					     output_sections_blocker,
+					     input_sections_blocker,
+					     final_blocker));
 
   // Queue a task to write out everything else.
   workqueue->queue(new Write_data_task(layout, symtab, of, final_blocker));
@@ -139,6 +139,16 @@
 // applications.  Up to 6 %  text size reductions.
 
 #include "gold.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "md5.h"
+#include "gold-threads.h"
 #include "object.h"
 #include "gc.h"
 #include "icf.h"
@@ -151,6 +161,224 @@
 namespace gold
 {
 
+// An Icf_cache remembers, across links, the checksum of the contents
+// of each section which ICF considers.  When an object has not changed
+// since the last link, we can decide which of its sections are unique
+// without reading them.  The cache directory holds one file per
+// object, named for a hash of the object's name, offset, size and
+// modification time, which is how incremental linking decides that an
+// input file is unchanged.  Hashing the contents themselves would cost
+// as much as the work the cache saves.
+
+class Icf_cache
+{
+ public:
+  Icf_cache(const char* dir)
+    : dir_(dir), objects_(), hits_(0), misses_(0)
+  { }
+
+  // Look up the checksum of section SHNDX in OBJECT, which has SIZE
+  // bytes.  Return true and set *CKSUM if it is in the cache.  The
+  // object must be locked.
+  bool
+  lookup(Relobj* object, unsigned int shndx, section_size_type size,
+	 uint32_t* cksum);
+
+  // Record the checksum of section SHNDX in OBJECT.
+  void
+  record(Relobj* object, unsigned int shndx, section_size_type size,
+	 uint32_t cksum);
+
+  // Write out the entries for any objects which were not already
+  // cached.
+  void
+  write();
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
+ private:
+  struct Section_entry
+  {
+    section_size_type size;
+    uint32_t cksum;
+  };
+
+  typedef std::map<unsigned int, Section_entry> Section_entries;
+
+  struct Object_entries
+  {
+    // The name of the cache file.
+    std::string filename;
+    // Whether we added entries which are not in the file.
+    bool changed;
+    // The entries.
+    Section_entries sections;
+  };
+
+  typedef std::map<Relobj*, Object_entries> Objects;
+
+  // Return the entries for OBJECT, reading the cache file if this is
+  // the first time we have seen it.
+  Object_entries*
+  get_entries(Relobj* object);
+
+  // The cache directory.
+  std::string dir_;
+  // The entries for each object.
+  Objects objects_;
+  // The number of sections found in the cache.
+  unsigned int hits_;
+  // The number of sections not found in the cache.
+  unsigned int misses_;
+};
+
+// The first line of an ICF cache file.
+
+static const char icf_cache_magic[] = "gold-icf-cache 1";
+
+Icf_cache::Object_entries*
+Icf_cache::get_entries(Relobj* object)
+{
+  std::pair<Objects::iterator, bool> ins =
+    this->objects_.insert(std::make_pair(object, Object_entries()));
+  Object_entries* entries = &ins.first->second;
+  if (!ins.second)
+    return entries;
+
+  File_read& file(object->input_file()->file());
+  Timespec mtime = file.get_mtime();
+  char key[200];
+  snprintf(key, sizeof key, "%lld %lld %lld %lld %d",
+	   static_cast<long long>(object->offset()),
+	   static_cast<long long>(file.filesize()),
+	   static_cast<long long>(mtime.seconds),
+	   static_cast<long long>(mtime.nanoseconds),
+	   parameters->target().get_size());
+  std::string id(object->name());
+  id.push_back('\0');
+  id.append(key);
+
+  unsigned char digest[16];
+  md5_buffer(id.data(), id.length(), digest);
+  char hex[sizeof digest * 2 + 1];
+  for (size_t i = 0; i < sizeof digest; ++i)
+    snprintf(hex + i * 2, 3, "%02x", digest[i]);
+
+  entries->filename = this->dir_ + '/' + hex + ".icf";
+  entries->changed = false;
+
+  FILE* f = fopen(entries->filename.c_str(), "r");
+  if (f == NULL)
+    return entries;
+  char line[100];
+  if (fgets(line, sizeof line, f) != NULL
+      && strncmp(line, icf_cache_magic, sizeof icf_cache_magic - 1) == 0)
+    {
+      unsigned int shndx;
+      unsigned long long size;
+      unsigned int cksum;
+      while (fscanf(f, "%u %llu %x", &shndx, &size, &cksum) == 3)
+	{
+	  Section_entry entry;
+	  entry.size = size;
+	  entry.cksum = cksum;
+	  entries->sections[shndx] = entry;
+	}
+    }
+  fclose(f);
+  return entries;
+}
+
+bool
+Icf_cache::lookup(Relobj* object, unsigned int shndx, section_size_type size,
+		  uint32_t* cksum)
+{
+  Object_entries* entries = this->get_entries(object);
+  Section_entries::const_iterator p = entries->sections.find(shndx);
+  if (p == entries->sections.end() || p->second.size != size)
+    {
+      ++this->misses_;
+      return false;
+    }
+  ++this->hits_;
+  *cksum = p->second.cksum;
+  return true;
+}
+
+void
+Icf_cache::record(Relobj* object, unsigned int shndx, section_size_type size,
+		  uint32_t cksum)
+{
+  Object_entries* entries = this->get_entries(object);
+  Section_entry entry;
+  entry.size = size;
+  entry.cksum = cksum;
+  entries->sections[shndx] = entry;
+  entries->changed = true;
+}
+
+void
+Icf_cache::write()
+{
+  if (::mkdir(this->dir_.c_str(), 0777) < 0 && errno != EEXIST)
+    {
+      gold_warning(_("cannot create ICF cache directory %s: %s"),
+		   this->dir_.c_str(), strerror(errno));
+      return;
+    }
+
+  for (Objects::const_iterator p = this->objects_.begin();
+       p != this->objects_.end();
+       ++p)
+    {
+      const Object_entries& entries(p->second);
+      if (!entries.changed)
+	continue;
+
+      // Write to a temporary file and rename it, so that a link running
+      // at the same time never sees a partial file.
+      char suffix[30];
+      snprintf(suffix, sizeof suffix, ".%ld.tmp",
+	       static_cast<long>(getpid()));
+      std::string tmpname = entries.filename + suffix;
+      FILE* f = fopen(tmpname.c_str(), "w");
+      if (f == NULL)
+	{
+	  gold_warning(_("cannot write ICF cache file %s: %s"),
+		       tmpname.c_str(), strerror(errno));
+	  return;
+	}
+      fprintf(f, "%s\n", icf_cache_magic);
+      for (Section_entries::const_iterator q = entries.sections.begin();
+	   q != entries.sections.end();
+	   ++q)
+	fprintf(f, "%u %llu %08x\n", q->first,
+		static_cast<unsigned long long>(q->second.size),
+		static_cast<unsigned int>(q->second.cksum));
+      bool ok = !ferror(f);
+      if (fclose(f) != 0)
+	ok = false;
+      if (!ok || ::rename(tmpname.c_str(), entries.filename.c_str()) < 0)
+	{
+	  gold_warning(_("cannot write ICF cache file %s: %s"),
+		       entries.filename.c_str(), strerror(errno));
+	  ::unlink(tmpname.c_str());
+	  return;
+	}
+    }
+}
+
+void
+Icf_cache::print_stats() const
+{
+  fprintf(stderr, _("%s: ICF cache sections found: %u\n"),
+	  program_name, this->hits_);
+  fprintf(stderr, _("%s: ICF cache sections not found: %u\n"),
+	  program_name, this->misses_);
+}
+
 // This function determines if a section or a group of identical
 // sections has unique contents.  Such unique sections or groups can be
 // declared final and need not be processed any further.
@@ -162,11 +390,14 @@ namespace gold
 //                    that cannot be folded.   SECTION_CONTENTS are NULL
 //                    implies that this function is being called for the
 //                    first time before the first iteration of icf.
+// CACHE              : If not NULL, the cache of section checksums to
+//                      use the first time.
 
 static void
 preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
                                std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
+                               std::vector<std::string>* section_contents,
+                               Icf_cache* cache)
 {
   Unordered_map<uint32_t, unsigned int> uniq_map;
   std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
@@ -187,11 +418,18 @@ preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
           // Unfortunately we have no way to pass in a Task token.
           const Task* dummy_task = reinterpret_cast<const Task*>(-1);
           Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
+          section_size_type size = secn.first->section_size(secn.second);
+          if (cache == NULL
+              || !cache->lookup(secn.first, secn.second, size, &cksum))
+            {
+              const unsigned char* contents;
+              contents = secn.first->section_contents(secn.second,
+                                                      &plen,
+                                                      false);
+              cksum = xcrc32(contents, plen, 0xffffffff);
+              if (cache != NULL)
+                cache->record(secn.first, secn.second, size, cksum);
+            }
         }
       else
         {
@@ -266,6 +504,13 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
 // SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
 //                      sections.
+// FILE_LOCK          : If not NULL, this is being called for several
+//                      sections in parallel.  The caller has locked the
+//                      input files, and FILE_LOCK serializes access to
+//                      them.
+// ICF_TARGETS        : If not NULL, store the unique section numbers of
+//                      the sections whose kept section is recorded in
+//                      the buffer.
 
 static std::string
 get_section_contents(bool first_iteration,
@@ -274,18 +519,24 @@ get_section_contents(bool first_iteration,
                      unsigned int* num_tracked_relocs,
                      Symbol_table* symtab,
                      const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+                     std::vector<std::string>* section_contents,
+                     Lock* file_lock,
+                     std::vector<unsigned int>* icf_targets)
 {
   // Lock the object so we can read from it.  This is only called
   // single-threaded from queue_middle_tasks, so it is OK to lock.
   // Unfortunately we have no way to pass in a Task token.
   const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-  Task_lock_obj<Object> tl(dummy_task, secn.first);
+  if (file_lock == NULL)
+    secn.first->lock(dummy_task);
 
   section_size_type plen;
   const unsigned char* contents = NULL;
   if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
+    {
+      Hold_optional_lock hl(file_lock);
+      contents = secn.first->section_contents(secn.second, &plen, false);
+    }
 
   // The buffer to hold all the contents including relocs.  A checksum
   // is then computed on this buffer.
@@ -336,7 +587,10 @@ get_section_contents(bool first_iteration,
 	      loc.offset = convert_types<off_t, long long>(it_a->first
 							   + it_a->second);
 	      // Look through function descriptors
-	      parameters->target().function_location(&loc);
+	      {
+		Hold_optional_lock hl(file_lock);
+		parameters->target().function_location(&loc);
+	      }
 	      if (loc.shndx != it_v->second)
 		{
 		  it_v->second = loc.shndx;
@@ -419,6 +673,8 @@ get_section_contents(bool first_iteration,
               // Append the addend.
               icf_reloc_buffer.append(addend_str);
               icf_reloc_buffer.append("@");
+              if (icf_targets != NULL)
+                icf_targets->push_back(secn_id);
             }
           else
             {
@@ -427,6 +683,7 @@ get_section_contents(bool first_iteration,
               if (!first_iteration)
                 continue;
 
+              Hold_optional_lock hl(file_lock);
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
               // This reloc points to a merge section.  Hash the
               // contents of this section.
@@ -557,9 +814,77 @@ get_section_contents(bool first_iteration,
     }
 
   buffer.append(icf_reloc_buffer);
+
+  if (file_lock == NULL)
+    secn.first->unlock(dummy_task);
+
   return buffer;
 }
 
+// Compute the contents and checksums of a set of sections in
+// parallel, for match_sections.
+
+class Icf_contents_work : public Parallel_work
+{
+ public:
+  Icf_contents_work(unsigned int iteration_num,
+                    Symbol_table* symtab,
+                    std::vector<unsigned int>* num_tracked_relocs,
+                    const std::vector<unsigned int>& kept_section_id,
+                    const std::vector<Section_id>& id_section,
+                    std::vector<std::string>* section_contents,
+                    const std::vector<unsigned int>& todo,
+                    std::vector<std::string>* contents,
+                    std::vector<uint32_t>* cksums,
+                    std::vector<std::vector<unsigned int> >* targets)
+    : iteration_num_(iteration_num), symtab_(symtab),
+      num_tracked_relocs_(num_tracked_relocs),
+      kept_section_id_(kept_section_id), id_section_(id_section),
+      section_contents_(section_contents), todo_(todo),
+      contents_(contents), cksums_(cksums), targets_(targets), file_lock_()
+  { }
+
+  void
+  run_piece(size_t k)
+  {
+    unsigned int i = this->todo_[k];
+    bool first_iteration = this->iteration_num_ == 1;
+    std::string& contents((*this->contents_)[i]);
+    contents = get_section_contents(first_iteration, this->id_section_[i],
+                                    i,
+                                    (first_iteration
+                                     ? &(*this->num_tracked_relocs_)[i]
+                                     : NULL),
+                                    this->symtab_, this->kept_section_id_,
+                                    this->section_contents_,
+                                    &this->file_lock_,
+                                    &(*this->targets_)[i]);
+    (*this->cksums_)[i] =
+      xcrc32(reinterpret_cast<const unsigned char*>(contents.data()),
+             contents.length(), 0xffffffff);
+  }
+
+ private:
+  unsigned int iteration_num_;
+  Symbol_table* symtab_;
+  std::vector<unsigned int>* num_tracked_relocs_;
+  const std::vector<unsigned int>& kept_section_id_;
+  const std::vector<Section_id>& id_section_;
+  std::vector<std::string>* section_contents_;
+  const std::vector<unsigned int>& todo_;
+  std::vector<std::string>* contents_;
+  std::vector<uint32_t>* cksums_;
+  std::vector<std::vector<unsigned int> >* targets_;
+  // Serializes access to the input files.
+  Lock file_lock_;
+};
+
+// When there are at least this many sections to examine, and we have
+// more than one thread, match_sections computes their contents in
+// parallel.
+
+static const size_t icf_parallel_min_sections = 64;
+
 // This function computes a checksum on each section to detect and form
 // groups of identical sections.  The first iteration does this for all 
 // sections.
@@ -583,6 +908,7 @@ get_section_contents(bool first_iteration,
 //                            sections is already known to be unique.
 // SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
 //                      sections.
+// CACHE              : If not NULL, the cache of section checksums.
 
 static bool
 match_sections(unsigned int iteration_num,
@@ -591,7 +917,8 @@ match_sections(unsigned int iteration_num,
                std::vector<unsigned int>* kept_section_id,
                const std::vector<Section_id>& id_section,
                std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+               std::vector<std::string>* section_contents,
+               Icf_cache* cache)
 {
   Unordered_multimap<uint32_t, unsigned int> section_cksum;
   std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
@@ -601,11 +928,65 @@ match_sections(unsigned int iteration_num,
   if (iteration_num == 1)
     preprocess_for_unique_sections(id_section,
                                    is_secn_or_group_unique,
-                                   NULL);
+                                   NULL, cache);
   else
     preprocess_for_unique_sections(id_section,
                                    is_secn_or_group_unique,
-                                   section_contents);
+                                   section_contents, NULL);
+
+  // If we have more than one thread, compute the contents and
+  // checksums of the sections in parallel before we start.  The
+  // contents of a section record the kept section of the sections it
+  // refers to, which may change as we go through the loop below, so we
+  // remember which sections those are and recompute the contents if
+  // any of them change.  This gives the same result as computing the
+  // contents in the loop.
+  std::vector<unsigned int> todo;
+  for (unsigned int i = 0; i < id_section.size(); i++)
+    if (!(*is_secn_or_group_unique)[i]
+        && (iteration_num == 1 || (*kept_section_id)[i] == i))
+      todo.push_back(i);
+  const bool parallel = (todo.size() >= icf_parallel_min_sections
+                         && parallel_thread_count() > 1);
+  std::vector<std::string> parallel_contents;
+  std::vector<uint32_t> parallel_cksums;
+  std::vector<std::vector<unsigned int> > parallel_targets;
+  std::vector<bool> kept_section_changed;
+  if (parallel)
+    {
+      parallel_contents.resize(id_section.size());
+      parallel_cksums.resize(id_section.size());
+      parallel_targets.resize(id_section.size());
+      kept_section_changed.resize(id_section.size(), false);
+
+      // Lock the input files while the work runs.  Several objects in
+      // an archive share a file, so lock each file once.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      std::vector<Object*> locked_objects;
+      std::set<const File_read*> locked_files;
+      for (std::vector<unsigned int>::const_iterator p = todo.begin();
+           p != todo.end();
+           ++p)
+        {
+          Object* object = id_section[*p].first;
+          if (locked_files.insert(&object->input_file()->file()).second)
+            {
+              object->lock(dummy_task);
+              locked_objects.push_back(object);
+            }
+        }
+
+      Icf_contents_work work(iteration_num, symtab, num_tracked_relocs,
+                             *kept_section_id, id_section, section_contents,
+                             todo, &parallel_contents, &parallel_cksums,
+                             &parallel_targets);
+      run_parallel_work(&work, todo.size());
+
+      for (std::vector<Object*>::const_iterator p = locked_objects.begin();
+           p != locked_objects.end();
+           ++p)
+        (*p)->unlock(dummy_task);
+    }
 
   std::vector<std::string> full_section_contents;
 
@@ -618,36 +999,71 @@ match_sections(unsigned int iteration_num,
       Section_id secn = id_section[i];
       std::string this_secn_contents;
       uint32_t cksum;
-      if (iteration_num == 1)
+      if (iteration_num > 1 && (*kept_section_id)[i] != i)
         {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
+          // This section is already folded into something.  See
+          // if it should point to a different kept section.
+          unsigned int kept_section = (*kept_section_id)[i];
+          if (kept_section != (*kept_section_id)[kept_section])
+            {
+              (*kept_section_id)[i] = (*kept_section_id)[kept_section];
+              if (parallel)
+                kept_section_changed[i] = true;
+            }
+          continue;
         }
-      else
+
+      bool recompute = !parallel;
+      if (parallel)
         {
-          if ((*kept_section_id)[i] != i)
+          const std::vector<unsigned int>& targets(parallel_targets[i]);
+          for (std::vector<unsigned int>::const_iterator p = targets.begin();
+               p != targets.end();
+               ++p)
             {
-              // This section is already folded into something.  See
-              // if it should point to a different kept section.
-              unsigned int kept_section = (*kept_section_id)[i];
-              if (kept_section != (*kept_section_id)[kept_section])
+              if (kept_section_changed[*p])
                 {
-                  (*kept_section_id)[i] = (*kept_section_id)[kept_section];
+                  recompute = true;
+                  break;
                 }
-              continue;
             }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
         }
 
-      const unsigned char* this_secn_contents_array =
+      if (!recompute)
+        {
+          this_secn_contents.swap(parallel_contents[i]);
+          cksum = parallel_cksums[i];
+        }
+      else
+        {
+          if (iteration_num == 1 && !parallel)
+            {
+              unsigned int num_relocs = 0;
+              this_secn_contents = get_section_contents(true, secn, i,
+                                                        &num_relocs,
+                                                        symtab,
+                                                        (*kept_section_id),
+                                                        section_contents,
+                                                        NULL, NULL);
+              (*num_tracked_relocs)[i] = num_relocs;
+            }
+          else
+            {
+              // In the first iteration with PARALLEL, the parts of the
+              // contents which do not depend on the kept sections have
+              // already been computed.
+              this_secn_contents = get_section_contents(false, secn, i, NULL,
+                                                        symtab,
+                                                        (*kept_section_id),
+                                                        section_contents,
+                                                        NULL, NULL);
+            }
+
+          const unsigned char* this_secn_contents_array =
             reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
+          cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
+                         0xffffffff);
+        }
       size_t count = section_cksum.count(cksum);
 
       if (count == 0)
@@ -672,6 +1088,8 @@ match_sections(unsigned int iteration_num,
                          this_secn_contents.length()) != 0)
                   continue;
               (*kept_section_id)[i] = kept_section;
+              if (parallel)
+                kept_section_changed[i] = true;
               converged = false;
               break;
             }
@@ -774,13 +1192,25 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 
   bool converged = false;
 
+  Icf_cache* cache = NULL;
+  if (parameters->options().icf_cache_dir() != NULL)
+    cache = new Icf_cache(parameters->options().icf_cache_dir());
+
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
       converged = match_sections(num_iterations, symtab,
                                  &num_tracked_relocs, &this->kept_section_id_,
                                  this->id_section_, &is_secn_or_group_unique,
-                                 &section_contents);
+                                 &section_contents, cache);
+    }
+
+  if (cache != NULL)
+    {
+      cache->write();
+      if (parameters->options().stats())
+        cache->print_stats();
+      delete cache;
     }
 
   if (parameters->options().print_icf_sections())
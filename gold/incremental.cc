@@ -23,8 +23,13 @@
 #include "gold.h"
 
 #include <set>
+#include <cerrno>
 #include <cstdarg>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "libiberty.h"
+#include "md5.h"
 
 #include "elfcpp.h"
 #include "options.h"
@@ -405,6 +410,8 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
 {
   Incremental_inputs_reader<size, big_endian>& inputs = this->inputs_reader_;
 
+  this->hash_file_ = incremental_inputs->hash_file();
+
   if (!this->has_incremental_info_)
     {
       explain_no_incremental(_("no incremental data from previous build"));
@@ -506,12 +513,16 @@ Sized_incremental_binary<size, big_endian>::do_file_has_changed(
       return true;
     }
 
-  if (new_mtime.seconds > old_mtime.seconds)
-    return true;
-  if (new_mtime.seconds == old_mtime.seconds
-      && new_mtime.nanoseconds > old_mtime.nanoseconds)
-    return true;
-  return false;
+  if (new_mtime.seconds < old_mtime.seconds
+      || (new_mtime.seconds == old_mtime.seconds
+	  && new_mtime.nanoseconds <= old_mtime.nanoseconds))
+    return false;
+
+  // The file has been touched, but its contents may be the same.
+  if (this->hash_file_ != NULL
+      && this->hash_file_->file_is_unchanged(filename, old_mtime))
+    return false;
+  return true;
 }
 
 // Initialize the layout of the output file based on the existing
@@ -948,8 +959,234 @@ open_incremental_binary(Output_file* file)
   return result;
 }
 
+// Class Incremental_hash_file.
+
+// The first line of an --incremental-hash-file file.
+
+static const char incremental_hash_magic[] = "gold-incremental-hashes 1";
+
+// Get the size and modification time of FILENAME.
+
+static bool
+stat_input_file(const char* filename, off_t* size, Timespec* mtime)
+{
+  struct stat file_stat;
+  if (::stat(filename, &file_stat) < 0)
+    return false;
+  *size = file_stat.st_size;
+#ifdef HAVE_STAT_ST_MTIM
+  mtime->seconds = file_stat.st_mtim.tv_sec;
+  mtime->nanoseconds = file_stat.st_mtim.tv_nsec;
+#else
+  mtime->seconds = file_stat.st_mtime;
+  mtime->nanoseconds = 0;
+#endif
+  return true;
+}
+
+static inline bool
+same_mtime(const Timespec& a, const Timespec& b)
+{
+  return a.seconds == b.seconds && a.nanoseconds == b.nanoseconds;
+}
+
+// Read the hash file.  Each line after the first holds the size, the
+// modification time, the recorded modification time and the MD5 hash
+// of an input file, followed by its name.  A missing or malformed
+// file just leaves us with no entries.
+
+void
+Incremental_hash_file::read()
+{
+  this->have_read_ = true;
+
+  FILE* f = fopen(this->filename_.c_str(), "r");
+  if (f == NULL)
+    return;
+  char line[8192];
+  if (fgets(line, sizeof line, f) != NULL
+      && strncmp(line, incremental_hash_magic,
+		 sizeof incremental_hash_magic - 1) == 0)
+    {
+      while (fgets(line, sizeof line, f) != NULL)
+	{
+	  size_t len = strlen(line);
+	  if (len == 0 || line[len - 1] != '\n')
+	    break;
+	  line[len - 1] = '\0';
+
+	  long long size, sec, rec_sec;
+	  int nsec, rec_nsec;
+	  char hex[33];
+	  int name_offset;
+	  if (sscanf(line, "%lld %lld %d %lld %d %32s %n", &size, &sec, &nsec,
+		     &rec_sec, &rec_nsec, hex, &name_offset) != 6
+	      || strlen(hex) != 32
+	      || line[name_offset] == '\0')
+	    break;
+
+	  Entry entry;
+	  entry.size = size;
+	  entry.mtime = Timespec(sec, nsec);
+	  entry.recorded_mtime = Timespec(rec_sec, rec_nsec);
+	  for (size_t i = 0; i < sizeof entry.digest; ++i)
+	    {
+	      unsigned int byte;
+	      sscanf(hex + i * 2, "%2x", &byte);
+	      entry.digest[i] = byte;
+	    }
+	  this->entries_[line + name_offset] = entry;
+	}
+    }
+  fclose(f);
+}
+
+// Compute the MD5 hash of the contents of file NAME.
+
+bool
+Incremental_hash_file::hash_file(const char* name, unsigned char* digest)
+{
+  FILE* f = fopen(name, "rb");
+  if (f == NULL)
+    return false;
+  int ret = md5_stream(f, digest);
+  fclose(f);
+  ++this->files_hashed_;
+  return ret == 0;
+}
+
+// Return true if the contents of input file NAME have not changed
+// since the previous link.  The hash file entry only applies if the
+// previous link recorded the same modification time that the base
+// file still holds; otherwise the base file was written by some other
+// link, and the hash says nothing about its contents.
+
+bool
+Incremental_hash_file::file_is_unchanged(const char* name,
+					 const Timespec& recorded_mtime)
+{
+  if (!this->have_read_)
+    this->read();
+
+  Entries::iterator p = this->entries_.find(name);
+  if (p == this->entries_.end()
+      || !same_mtime(p->second.recorded_mtime, recorded_mtime))
+    return false;
+
+  off_t size;
+  Timespec mtime;
+  if (!stat_input_file(name, &size, &mtime) || size != p->second.size)
+    return false;
+
+  // If the file has not been touched since we hashed it, there is no
+  // need to read it again.
+  if (!same_mtime(mtime, p->second.mtime))
+    {
+      unsigned char digest[sizeof p->second.digest];
+      if (!this->hash_file(name, digest)
+	  || memcmp(digest, p->second.digest, sizeof digest) != 0)
+	return false;
+      p->second.mtime = mtime;
+    }
+
+  gold_debug(DEBUG_INCREMENTAL, "%s: contents unchanged", name);
+  ++this->files_matched_;
+  return true;
+}
+
+// Write out the hash file.  We only hash the input files which have
+// been touched since the previous entry was written.
+
+void
+Incremental_hash_file::write()
+{
+  if (!this->have_read_)
+    this->read();
+
+  // Write to a temporary file and rename it, so that a link running at
+  // the same time never sees a partial file.
+  char suffix[30];
+  snprintf(suffix, sizeof suffix, ".%ld.tmp", static_cast<long>(getpid()));
+  std::string tmpname = this->filename_ + suffix;
+  FILE* f = fopen(tmpname.c_str(), "w");
+  if (f == NULL)
+    {
+      gold_warning(_("cannot write incremental hash file %s: %s"),
+		   tmpname.c_str(), strerror(errno));
+      return;
+    }
+  fprintf(f, "%s\n", incremental_hash_magic);
+
+  std::set<std::string> seen;
+  for (Inputs::const_iterator p = this->inputs_.begin();
+       p != this->inputs_.end();
+       ++p)
+    {
+      const std::string& name(p->first);
+      if (!seen.insert(name).second)
+	continue;
+
+      Entry entry;
+      if (!stat_input_file(name.c_str(), &entry.size, &entry.mtime))
+	continue;
+      Entries::const_iterator q = this->entries_.find(name);
+      if (q != this->entries_.end()
+	  && q->second.size == entry.size
+	  && same_mtime(q->second.mtime, entry.mtime))
+	memcpy(entry.digest, q->second.digest, sizeof entry.digest);
+      else if (!this->hash_file(name.c_str(), entry.digest))
+	continue;
+
+      char hex[sizeof entry.digest * 2 + 1];
+      for (size_t i = 0; i < sizeof entry.digest; ++i)
+	snprintf(hex + i * 2, 3, "%02x", entry.digest[i]);
+      fprintf(f, "%lld %lld %d %lld %d %s %s\n",
+	      static_cast<long long>(entry.size),
+	      static_cast<long long>(entry.mtime.seconds),
+	      entry.mtime.nanoseconds,
+	      static_cast<long long>(p->second.seconds),
+	      p->second.nanoseconds,
+	      hex, name.c_str());
+    }
+
+  bool ok = !ferror(f);
+  if (fclose(f) != 0)
+    ok = false;
+  if (!ok || ::rename(tmpname.c_str(), this->filename_.c_str()) < 0)
+    {
+      gold_warning(_("cannot write incremental hash file %s: %s"),
+		   this->filename_.c_str(), strerror(errno));
+      ::unlink(tmpname.c_str());
+    }
+}
+
+// Print statistics to stderr.
+
+void
+Incremental_hash_file::print_stats() const
+{
+  fprintf(stderr, _("%s: incremental input files hashed: %u\n"),
+	  program_name, this->files_hashed_);
+  fprintf(stderr, _("%s: incremental input files with unchanged contents: "
+		    "%u\n"),
+	  program_name, this->files_matched_);
+}
+
 // Class Incremental_inputs.
 
+Incremental_inputs::Incremental_inputs()
+  : inputs_(), command_line_(), command_line_key_(0),
+    strtab_(new Stringpool()), current_object_(NULL),
+    current_object_entry_(NULL), inputs_section_(NULL),
+    symtab_section_(NULL), relocs_section_(NULL),
+    reloc_count_(0), hash_file_(NULL), reused_bytes_(0),
+    rewritten_bytes_(0)
+{
+  const char* hash_file = parameters->options().incremental_hash_file();
+  if (hash_file != NULL)
+    this->hash_file_ = new Incremental_hash_file(hash_file);
+}
+
 // Add the command line to the string table, setting
 // command_line_key_.  In incremental builds, the command line is
 // stored in .gnu_incremental_inputs so that the next linker run can
@@ -1029,6 +1266,9 @@ Incremental_inputs::report_archive_begin(Library_base* arch,
       new Incremental_archive_entry(filename_key, arg_serial, mtime);
   arch->set_incremental_info(entry);
 
+  if (this->hash_file_ != NULL)
+    this->hash_file_->add_input(arch->filename(), mtime);
+
   if (script_info != NULL)
     {
       Incremental_script_entry* script_entry = script_info->incremental_info();
@@ -1133,6 +1373,10 @@ Incremental_inputs::report_object(Object* obj, unsigned int arg_serial,
 
   this->inputs_.push_back(input_entry);
 
+  // Archive members are checked through their archive.
+  if (this->hash_file_ != NULL && arch == NULL)
+    this->hash_file_->add_input(obj->name(), mtime);
+
   if (script_info != NULL)
     {
       Incremental_script_entry* script_entry = script_info->incremental_info();
@@ -1155,6 +1399,11 @@ Incremental_inputs::report_input_section(Object* obj, unsigned int shndx,
   gold_assert(obj == this->current_object_);
   gold_assert(this->current_object_entry_ != NULL);
   this->current_object_entry_->add_input_section(shndx, key, sh_size);
+
+  if (obj->is_incremental())
+    this->reused_bytes_ += sh_size;
+  else
+    this->rewritten_bytes_ += sh_size;
 }
 
 // Record a kept COMDAT group belonging to object file OBJ.
@@ -1187,6 +1436,23 @@ Incremental_inputs::report_script(Script_info* script,
       new Incremental_script_entry(filename_key, arg_serial, script, mtime);
   this->inputs_.push_back(entry);
   script->set_incremental_info(entry);
+
+  if (this->hash_file_ != NULL)
+    this->hash_file_->add_input(script->filename(), mtime);
+}
+
+// Print statistics to stderr.
+
+void
+Incremental_inputs::print_stats() const
+{
+  fprintf(stderr, _("%s: incremental input section bytes reused: %llu\n"),
+	  program_name, static_cast<unsigned long long>(this->reused_bytes_));
+  fprintf(stderr, _("%s: incremental input section bytes rewritten: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(this->rewritten_bytes_));
+  if (this->hash_file_ != NULL)
+    this->hash_file_->print_stats();
 }
 
 // Finalize the incremental link information.  Called from
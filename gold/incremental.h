@@ -550,6 +550,78 @@ class Incremental_archive_entry : public Incremental_input_entry
   std::vector<Stringpool::Key> unused_syms_;
 };
 
+// This class keeps the content hashes of the input files in the file
+// named by --incremental-hash-file.  An input file whose timestamp is
+// newer than the one recorded in the incremental information is still
+// treated as unchanged if its contents match the hash recorded by the
+// previous link.
+
+class Incremental_hash_file
+{
+ public:
+  Incremental_hash_file(const char* filename)
+    : filename_(filename), entries_(), inputs_(), have_read_(false),
+      files_hashed_(0), files_matched_(0)
+  { }
+
+  // Return true if the contents of the input file NAME are the same
+  // as when the previous link recorded RECORDED_MTIME as its
+  // modification time in the incremental information.
+  bool
+  file_is_unchanged(const char* name, const Timespec& recorded_mtime);
+
+  // Record the input file NAME for the new hash file.  RECORDED_MTIME
+  // is the modification time written to the incremental information.
+  void
+  add_input(const std::string& name, const Timespec& recorded_mtime)
+  { this->inputs_.push_back(std::make_pair(name, recorded_mtime)); }
+
+  // Write out the hashes of the recorded input files.
+  void
+  write();
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
+ private:
+  struct Entry
+  {
+    // The size and modification time of the file when it was hashed.
+    off_t size;
+    Timespec mtime;
+    // The modification time recorded in the incremental information.
+    Timespec recorded_mtime;
+    // The MD5 hash of the file contents.
+    unsigned char digest[16];
+  };
+
+  typedef std::map<std::string, Entry> Entries;
+  typedef std::vector<std::pair<std::string, Timespec> > Inputs;
+
+  // Read the hash file written by the previous link.
+  void
+  read();
+
+  // Compute the hash of the contents of file NAME.
+  bool
+  hash_file(const char* name, unsigned char* digest);
+
+  // The name of the hash file.
+  std::string filename_;
+  // The entries, by input file name.
+  Entries entries_;
+  // The input files of this link.
+  Inputs inputs_;
+  // Whether we have read the hash file.
+  bool have_read_;
+  // The number of input files whose contents we hashed.
+  unsigned int files_hashed_;
+  // The number of input files with newer timestamps whose contents
+  // were unchanged.
+  unsigned int files_matched_;
+};
+
 // This class contains the information needed during an incremental
 // build about the inputs necessary to build the .gnu_incremental_inputs.
 
@@ -558,15 +630,13 @@ class Incremental_inputs
  public:
   typedef std::vector<Incremental_input_entry*> Input_list;
 
-  Incremental_inputs()
-    : inputs_(), command_line_(), command_line_key_(0),
-      strtab_(new Stringpool()), current_object_(NULL),
-      current_object_entry_(NULL), inputs_section_(NULL),
-      symtab_section_(NULL), relocs_section_(NULL),
-      reloc_count_(0)
-  { }
+  Incremental_inputs();
 
-  ~Incremental_inputs() { delete this->strtab_; }
+  ~Incremental_inputs()
+  {
+    delete this->strtab_;
+    delete this->hash_file_;
+  }
 
   // Record the command line.
   void
@@ -669,6 +739,15 @@ class Incremental_inputs
   unsigned int
   relocs_entsize() const;
 
+  // Return the --incremental-hash-file data, or NULL.
+  Incremental_hash_file*
+  hash_file() const
+  { return this->hash_file_; }
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
  private:
   // The list of input files.
   Input_list inputs_;
@@ -703,6 +782,14 @@ class Incremental_inputs
   // Total count of incremental relocations.  Updated during Scan_relocs
   // phase at the completion of each object file.
   unsigned int reloc_count_;
+
+  // The --incremental-hash-file data, or NULL.
+  Incremental_hash_file* hash_file_;
+
+  // The input section bytes kept from the base file, and the ones
+  // laid out again, for --stats.
+  uint64_t reused_bytes_;
+  uint64_t rewritten_bytes_;
 };
 
 // Reader class for global symbol info from an object file entry in
@@ -1342,7 +1429,7 @@ class Incremental_binary
  public:
   Incremental_binary(Output_file* output, Target* /*target*/)
     : input_args_map_(), library_map_(), script_map_(),
-      output_(output)
+      hash_file_(NULL), output_(output)
   { }
 
   virtual
@@ -1576,6 +1663,8 @@ class Incremental_binary
   std::vector<Incremental_library*> library_map_;
   // Map from an input file index to a Script_info.
   std::vector<Script_info*> script_map_;
+  // The --incremental-hash-file data, or NULL.
+  Incremental_hash_file* hash_file_;
 
  private:
   // Edited output file object.
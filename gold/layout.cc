@@ -27,6 +27,8 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <sstream>
 #include <utility>
 #include <fcntl.h>
 #include <fnmatch.h>
@@ -50,6 +52,7 @@
 #include "object.h"
 #include "reloc.h"
 #include "descriptors.h"
+#include "gold-threads.h"
 #include "plugin.h"
 #include "incremental.h"
 #include "layout.h"
@@ -279,6 +282,212 @@ class Hash_task : public Task
   Task_token* const final_blocker_;
 };
 
+// A Build_id_tree_hash computes the chunk hashes for --build-id=tree
+// while the output file is still being written.  Each chunk is hashed
+// as soon as every task which may write to it has finished, rather
+// than after the whole file is complete.  A writer is either the
+// Relocate_task for an object, or, represented by a NULL object, the
+// Write_sections_tasks.  Parts of the file which may be written by any
+// other task are only hashed once all writes are done.
+
+class Build_id_tree_hash
+{
+ public:
+  Build_id_tree_hash(Output_file* of, size_t filesize, size_t chunk_size);
+
+  // Record that the task for WRITER may write the LEN bytes at
+  // OFFSET.
+  void
+  add_writer(const Relobj* writer, off_t offset, off_t len);
+
+  // Record that the LEN bytes at OFFSET may be written by a task which
+  // we do not track.
+  void
+  add_untracked(off_t offset, off_t len);
+
+  // Finish setting up.  This queues a Hash_task for any chunk which
+  // nothing writes.
+  void
+  start(Workqueue*);
+
+  // Called when the task for WRITER has finished.
+  void
+  writer_done(Workqueue*, const Relobj* writer);
+
+  // Called when all writes to the output file are done.
+  void
+  all_writers_done(Workqueue*);
+
+  // The blocker which is unblocked as each chunk is hashed.
+  Task_token*
+  blocker() const
+  { return this->blocker_; }
+
+  // The array of chunk hashes.
+  unsigned char*
+  array_of_hashes() const
+  { return this->array_of_hashes_; }
+
+  // The size of the array of chunk hashes.
+  size_t
+  size_of_hashes() const
+  { return this->num_hashes_ * md5_size; }
+
+ private:
+  // The size of an MD5 checksum.
+  static const size_t md5_size = 16;
+
+  typedef std::vector<size_t> Chunk_list;
+  typedef std::map<const Relobj*, Chunk_list> Writer_chunks;
+
+  // Add the chunks which overlap the LEN bytes at OFFSET to CHUNKS.
+  void
+  add_chunks(off_t offset, off_t len, Chunk_list* chunks);
+
+  // Note that one of the writers of each chunk in CHUNKS is done, and
+  // queue a Hash_task for each chunk which has no more writers.
+  void
+  release_chunks(Workqueue*, const Chunk_list& chunks);
+
+  // The output file.
+  Output_file* of_;
+  // The size of the output file.
+  size_t filesize_;
+  // The size of each chunk.
+  size_t chunk_size_;
+  // The number of chunks.
+  size_t num_hashes_;
+  // The MD5 checksum of each chunk.
+  unsigned char* array_of_hashes_;
+  // Unblocked by each Hash_task.
+  Task_token* blocker_;
+  // The chunks written by each writer.
+  Writer_chunks writer_chunks_;
+  // The chunks which include bytes written by an untracked task.
+  Chunk_list untracked_chunks_;
+  // For each chunk, the number of writers which have not finished.
+  // Protected by LOCK_.
+  std::vector<unsigned int> pending_;
+  // Protects PENDING_.
+  Lock lock_;
+};
+
+Build_id_tree_hash::Build_id_tree_hash(Output_file* of, size_t filesize,
+				       size_t chunk_size)
+  : of_(of), filesize_(filesize), chunk_size_(chunk_size),
+    num_hashes_((filesize - 1) / chunk_size + 1),
+    array_of_hashes_(new unsigned char[this->num_hashes_ * md5_size]),
+    blocker_(new Task_token(true)), writer_chunks_(), untracked_chunks_(),
+    pending_(this->num_hashes_, 0), lock_()
+{
+  this->blocker_->add_blockers(this->num_hashes_);
+}
+
+void
+Build_id_tree_hash::add_chunks(off_t offset, off_t len, Chunk_list* chunks)
+{
+  if (len <= 0)
+    return;
+  size_t first = static_cast<size_t>(offset) / this->chunk_size_;
+  size_t last = static_cast<size_t>(offset + len - 1) / this->chunk_size_;
+  gold_assert(last < this->num_hashes_);
+  for (size_t i = first; i <= last; ++i)
+    if (chunks->empty() || chunks->back() != i)
+      chunks->push_back(i);
+}
+
+void
+Build_id_tree_hash::add_writer(const Relobj* writer, off_t offset, off_t len)
+{
+  this->add_chunks(offset, len, &this->writer_chunks_[writer]);
+}
+
+void
+Build_id_tree_hash::add_untracked(off_t offset, off_t len)
+{
+  this->add_chunks(offset, len, &this->untracked_chunks_);
+}
+
+void
+Build_id_tree_hash::start(Workqueue* workqueue)
+{
+  for (Writer_chunks::iterator p = this->writer_chunks_.begin();
+       p != this->writer_chunks_.end();
+       ++p)
+    {
+      Chunk_list& chunks(p->second);
+      std::sort(chunks.begin(), chunks.end());
+      chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+      for (Chunk_list::const_iterator c = chunks.begin();
+	   c != chunks.end();
+	   ++c)
+	++this->pending_[*c];
+    }
+
+  Chunk_list& untracked(this->untracked_chunks_);
+  std::sort(untracked.begin(), untracked.end());
+  untracked.erase(std::unique(untracked.begin(), untracked.end()),
+		  untracked.end());
+  for (Chunk_list::const_iterator c = untracked.begin();
+       c != untracked.end();
+       ++c)
+    ++this->pending_[*c];
+
+  for (size_t i = 0; i < this->num_hashes_; ++i)
+    {
+      if (this->pending_[i] == 0)
+	workqueue->queue(new Hash_task(this->of_, i * this->chunk_size_,
+				       std::min(this->chunk_size_,
+						(this->filesize_
+						 - i * this->chunk_size_)),
+				       this->array_of_hashes_ + i * md5_size,
+				       this->blocker_));
+    }
+}
+
+void
+Build_id_tree_hash::release_chunks(Workqueue* workqueue,
+				   const Chunk_list& chunks)
+{
+  Chunk_list ready;
+  {
+    Hold_lock hl(this->lock_);
+    for (Chunk_list::const_iterator c = chunks.begin();
+	 c != chunks.end();
+	 ++c)
+      {
+	gold_assert(this->pending_[*c] > 0);
+	--this->pending_[*c];
+	if (this->pending_[*c] == 0)
+	  ready.push_back(*c);
+      }
+  }
+
+  for (Chunk_list::const_iterator c = ready.begin(); c != ready.end(); ++c)
+    {
+      size_t offset = *c * this->chunk_size_;
+      workqueue->queue(new Hash_task(this->of_, offset,
+				     std::min(this->chunk_size_,
+					      this->filesize_ - offset),
+				     this->array_of_hashes_ + *c * md5_size,
+				     this->blocker_));
+    }
+}
+
+void
+Build_id_tree_hash::writer_done(Workqueue* workqueue, const Relobj* writer)
+{
+  Writer_chunks::const_iterator p = this->writer_chunks_.find(writer);
+  if (p != this->writer_chunks_.end())
+    this->release_chunks(workqueue, p->second);
+}
+
+void
+Build_id_tree_hash::all_writers_done(Workqueue* workqueue)
+{
+  this->release_chunks(workqueue, this->untracked_chunks_);
+}
+
 // Layout::Relaxation_debug_check methods.
 
 // Check that sections and special data are in reset states.
@@ -445,8 +654,11 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     eh_frame_hdr_section_(NULL),
     gdb_index_data_(NULL),
     build_id_note_(NULL),
+    build_id_tree_hash_(NULL),
+    write_sections_pieces_(NULL),
     debug_abbrev_(NULL),
     debug_info_(NULL),
+    debug_type_dedup_(NULL),
     group_signatures_(),
     output_file_size_(-1),
     have_added_input_section_(false),
@@ -465,6 +677,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     script_output_section_data_list_(),
     segment_states_(NULL),
     relaxation_debug_check_(NULL),
+    relaxation_stats_(),
     section_order_map_(),
     section_segment_map_(),
     input_section_position_(),
@@ -1642,6 +1855,7 @@ Layout::make_output_section(const char* name, elfcpp::Elf_Word type,
 			    Output_section_order order, bool is_relro)
 {
   Output_section* os;
+  Debug_type_dedup::Section_kind dedup_kind;
   if ((flags & elfcpp::SHF_ALLOC) == 0
       && strcmp(parameters->options().compress_debug_sections(), "none") != 0
       && is_compressible_debug_section(name))
@@ -1665,6 +1879,16 @@ Layout::make_output_section(const char* name, elfcpp::Elf_Word type,
       if (this->debug_abbrev_)
 	this->debug_info_->set_abbreviations(this->debug_abbrev_);
     }
+  else if ((flags & elfcpp::SHF_ALLOC) == 0
+	   && parameters->options().dedup_debug_types()
+	   && Debug_type_dedup::section_kind(name, &dedup_kind))
+    {
+      if (this->debug_type_dedup_ == NULL)
+	this->debug_type_dedup_ = new Debug_type_dedup();
+      os = new Output_dedup_debug_section(name, type, flags,
+					  this->debug_type_dedup_,
+					  dedup_kind);
+    }
   else
     {
       // Sometimes .init_array*, .preinit_array* and .fini_array* do
@@ -2361,7 +2585,11 @@ Layout::clean_up_after_relaxation()
       // we need to adjust the section offsets of all input sections.
       // after such a section.
       if ((*p)->section_offsets_need_adjustment())
-	(*p)->adjust_section_offsets();
+	{
+	  (*p)->adjust_section_offsets();
+	  if (!this->relaxation_stats_.empty())
+	    ++this->relaxation_stats_.back().sections_adjusted;
+	}
 
       (*p)->reset_address_and_file_offset();
     }
@@ -2396,6 +2624,19 @@ Layout::reset_relax_output()
   this->relax_output_list_.clear();
 }
 
+// Return the time elapsed between START and END.
+
+static Timer::TimeStats
+time_stats_difference(const Timer::TimeStats& end,
+		      const Timer::TimeStats& start)
+{
+  Timer::TimeStats ret;
+  ret.user = end.user - start.user;
+  ret.sys = end.sys - start.sys;
+  ret.wall = end.wall - start.wall;
+  return ret;
+}
+
 // Prepare for relaxation.
 
 void
@@ -2648,6 +2889,197 @@ Layout::read_layout_from_file()
     }
 }
 
+// Sort functions, or clusters of functions, by decreasing weight.
+// Ties keep the order in which the functions first appear in the call
+// graph file.
+
+class Call_graph_weight_compare
+{
+ public:
+  Call_graph_weight_compare(const std::vector<double>& weights)
+    : weights_(weights)
+  { }
+
+  bool
+  operator()(unsigned int i1, unsigned int i2) const
+  {
+    if (this->weights_[i1] != this->weights_[i2])
+      return this->weights_[i1] > this->weights_[i2];
+    return i1 < i2;
+  }
+
+ private:
+  const std::vector<double>& weights_;
+};
+
+// Read the call graph from the file specified with option
+// --call-graph-ordering-file.  Each line names a caller, a callee,
+// and the number of times the call was sampled, separated by white
+// space.  We group the functions into clusters so that callers and
+// their most frequent callees are next to each other, using the
+// call-chain clustering algorithm of Ottoni and Maher, "Optimizing
+// Function Placement for Large-Scale Data-Center Applications".  The
+// sizes of the functions are not known yet, so unlike that algorithm
+// we do not limit the size of a cluster.  The clusters are placed
+// hottest first.  The .text sections of functions which are not in
+// the call graph are not ordered, and so come before all of these,
+// which keeps the hot code together.
+
+void
+Layout::read_call_graph_from_file()
+{
+  const char* filename = parameters->options().call_graph_ordering_file();
+  std::ifstream in;
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --call-graph-ordering-file file %s: %s"),
+	       filename, strerror(errno));
+
+  // The functions, numbered in the order in which they first appear.
+  std::vector<std::string> names;
+  Unordered_map<std::string, unsigned int> ids;
+  // For each function, the number of calls from each of its callers.
+  std::vector<std::map<unsigned int, uint64_t> > callers;
+  // For each function, the total number of calls to and from it.
+  std::vector<double> weights;
+
+  std::string line;
+  unsigned int lineno = 0;
+  while (std::getline(in, line))
+    {
+      ++lineno;
+      // Ignore blank lines, and comments beginning with '#'.
+      size_t start = line.find_first_not_of(" \t\r");
+      if (start == std::string::npos || line[start] == '#')
+	continue;
+
+      std::istringstream fields(line);
+      std::string name[2];
+      std::string count_str;
+      char* end = NULL;
+      uint64_t count = 0;
+      if (fields >> name[0] >> name[1] >> count_str)
+	count = strtoull(count_str.c_str(), &end, 10);
+      if (end == NULL || *end != '\0' || count_str[0] < '0'
+	  || count_str[0] > '9')
+	{
+	  gold_warning(_("%s:%u: expected CALLER CALLEE COUNT"), filename,
+		     lineno);
+	  continue;
+	}
+
+      unsigned int id[2];
+      for (int i = 0; i < 2; ++i)
+	{
+	  std::pair<Unordered_map<std::string, unsigned int>::iterator, bool>
+	    ins = ids.insert(std::make_pair(name[i], names.size()));
+	  if (ins.second)
+	    {
+	      names.push_back(name[i]);
+	      callers.push_back(std::map<unsigned int, uint64_t>());
+	      weights.push_back(0);
+	    }
+	  id[i] = ins.first->second;
+	}
+
+      weights[id[0]] += count;
+      if (id[1] != id[0])
+	{
+	  weights[id[1]] += count;
+	  callers[id[1]][id[0]] += count;
+	}
+    }
+
+  const unsigned int nfuncs = names.size();
+
+  // Each function starts in a cluster of its own, numbered the same
+  // as the function.
+  std::vector<unsigned int> cluster(nfuncs);
+  std::vector<std::vector<unsigned int> > members(nfuncs);
+  for (unsigned int i = 0; i < nfuncs; ++i)
+    {
+      cluster[i] = i;
+      members[i].push_back(i);
+    }
+
+  // Visit the functions from hottest to coldest, and append the
+  // cluster of each one to the cluster of its most frequent caller.
+  std::vector<unsigned int> order(nfuncs);
+  for (unsigned int i = 0; i < nfuncs; ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), Call_graph_weight_compare(weights));
+  std::vector<double> cluster_weights(weights);
+  for (std::vector<unsigned int>::const_iterator p = order.begin();
+       p != order.end();
+       ++p)
+    {
+      const std::map<unsigned int, uint64_t>& calls(callers[*p]);
+      if (calls.empty())
+	continue;
+      std::map<unsigned int, uint64_t>::const_iterator best = calls.begin();
+      for (std::map<unsigned int, uint64_t>::const_iterator q = calls.begin();
+	   q != calls.end();
+	   ++q)
+	if (q->second > best->second)
+	  best = q;
+
+      unsigned int to = cluster[best->first];
+      unsigned int from = cluster[*p];
+      if (to == from)
+	continue;
+      for (std::vector<unsigned int>::const_iterator q =
+	     members[from].begin();
+	   q != members[from].end();
+	   ++q)
+	{
+	  cluster[*q] = to;
+	  members[to].push_back(*q);
+	}
+      members[from].clear();
+      cluster_weights[to] += cluster_weights[from];
+    }
+
+  // Place the clusters in order of decreasing weight per function.
+  std::vector<unsigned int> clusters;
+  for (unsigned int i = 0; i < nfuncs; ++i)
+    {
+      if (!members[i].empty())
+	{
+	  cluster_weights[i] /= members[i].size();
+	  clusters.push_back(i);
+	}
+    }
+  std::sort(clusters.begin(), clusters.end(),
+	    Call_graph_weight_compare(cluster_weights));
+
+  // A function may be in a .text section with one of the prefixes
+  // which gcc uses to mark hot, cold and startup code.
+  static const char* const prefixes[] =
+  {
+    ".text.",
+    ".text.hot.",
+    ".text.unlikely.",
+    ".text.startup.",
+  };
+  const int nprefixes = sizeof(prefixes) / sizeof(prefixes[0]);
+
+  this->set_section_ordering_specified();
+  unsigned int position = 1;
+  for (std::vector<unsigned int>::const_iterator p = clusters.begin();
+       p != clusters.end();
+       ++p)
+    {
+      for (std::vector<unsigned int>::const_iterator q = members[*p].begin();
+	   q != members[*p].end();
+	   ++q)
+	{
+	  for (int i = 0; i < nprefixes; ++i)
+	    this->input_section_position_[prefixes[i] + names[*q]] = position;
+	  ++position;
+	}
+    }
+}
+
 // Finalize the layout.  When this is called, we have created all the
 // output sections and all the output segments which are based on
 // input sections.  We have several things to do, and we have to do
@@ -2765,16 +3197,40 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   if (target->may_relax())
     this->prepare_for_relaxation();
 
-  // Run the relaxation loop to lay out sections.
+  // Run the relaxation loop to lay out sections.  With --stats we
+  // record the time spent in each pass.
+  Timer* timer = target->may_relax() ? parameters->timer() : NULL;
+  bool again;
   do
     {
+      Timer::TimeStats start = Timer::TimeStats();
+      if (timer != NULL)
+	{
+	  this->relaxation_stats_.push_back(Relaxation_pass_stats());
+	  start = timer->get_elapsed_time();
+	}
+
       off = this->relaxation_loop_body(pass, target, symtab, &load_seg,
 				       phdr_seg, segment_headers, file_header,
 				       &shndx);
       pass++;
+
+      if (timer != NULL)
+	{
+	  Timer::TimeStats now = timer->get_elapsed_time();
+	  this->relaxation_stats_.back().layout_time =
+	    time_stats_difference(now, start);
+	  start = now;
+	}
+
+      again = (target->may_relax()
+	       && target->relax(pass, input_objects, symtab, this, task));
+
+      if (timer != NULL)
+	this->relaxation_stats_.back().relax_time =
+	  time_stats_difference(timer->get_elapsed_time(), start);
     }
-  while (target->may_relax()
-	 && target->relax(pass, input_objects, symtab, this, task));
+  while (again);
 
   // If there is a load segment that contains the file and program headers,
   // provide a symbol __ehdr_start pointing there.
@@ -5301,6 +5757,135 @@ Layout::symtab_section_shndx() const
   return 0;
 }
 
+// The pieces into which we split the work of writing out the output
+// sections.  Each piece is written by its own Write_sections_task.
+// A piece is either all the output sections, when we are not using
+// threads, or a whole section, or the fills or a range of input
+// sections of a section which was split because it has a lot of
+// Output_section_data to write.
+
+class Write_sections_pieces
+{
+ public:
+  Write_sections_pieces(const Layout* layout, Output_file* of)
+    : layout_(layout), of_(of), pieces_(), remaining_(0), lock_()
+  { }
+
+  // Add a piece which writes all the output sections.
+  void
+  add_all_sections()
+  { this->add_piece(NULL, ALL_SECTIONS, NULL); }
+
+  // Add a piece which writes all of OS.
+  void
+  add_section(Output_section* os)
+  { this->add_piece(os, WHOLE_SECTION, NULL); }
+
+  // Add a piece which writes the fills of OS.
+  void
+  add_fills(Output_section* os)
+  { this->add_piece(os, FILLS, NULL); }
+
+  // Add a piece which writes RANGE of OS.
+  void
+  add_range(Output_section* os,
+	    const Output_section::Input_section_range& range)
+  { this->add_piece(os, RANGE, &range); }
+
+  // The number of pieces.
+  size_t
+  piece_count() const
+  { return this->pieces_.size(); }
+
+  // Write out piece I.
+  void
+  write_piece(size_t i);
+
+  // Record that a piece has been written, and return whether it was
+  // the last one.
+  bool
+  piece_done();
+
+ private:
+  enum Piece_kind
+  {
+    ALL_SECTIONS,
+    WHOLE_SECTION,
+    FILLS,
+    RANGE
+  };
+
+  struct Piece
+  {
+    Output_section* os;
+    Piece_kind kind;
+    Output_section::Input_section_range range;
+  };
+
+  void
+  add_piece(Output_section* os, Piece_kind kind,
+	    const Output_section::Input_section_range* range)
+  {
+    Piece piece;
+    piece.os = os;
+    piece.kind = kind;
+    if (range != NULL)
+      piece.range = *range;
+    else
+      {
+	piece.range.first = 0;
+	piece.range.last = 0;
+	piece.range.offset = 0;
+      }
+    this->pieces_.push_back(piece);
+    ++this->remaining_;
+  }
+
+  const Layout* layout_;
+  Output_file* of_;
+  std::vector<Piece> pieces_;
+  // The number of pieces which have not been written.  Protected by
+  // LOCK_.
+  size_t remaining_;
+  Lock lock_;
+};
+
+void
+Write_sections_pieces::write_piece(size_t i)
+{
+  Piece& piece(this->pieces_[i]);
+  switch (piece.kind)
+    {
+    case ALL_SECTIONS:
+      this->layout_->write_output_sections(this->of_);
+      break;
+    case WHOLE_SECTION:
+      piece.os->write(this->of_);
+      break;
+    case FILLS:
+      piece.os->write_fills(this->of_);
+      break;
+    case RANGE:
+      piece.os->write_input_section_range(this->of_, piece.range);
+      break;
+    default:
+      gold_unreachable();
+    }
+}
+
+bool
+Write_sections_pieces::piece_done()
+{
+  Hold_lock hl(this->lock_);
+  gold_assert(this->remaining_ > 0);
+  --this->remaining_;
+  return this->remaining_ == 0;
+}
+
+// The least amount of Output_section_data we write in one piece.
+
+static const off_t min_write_piece_size = 256 * 1024;
+
 // Write out the Output_sections.  Most won't have anything to write,
 // since most of the data will come from input sections which are
 // handled elsewhere.  But some Output_sections do have Output_data.
@@ -5317,6 +5902,84 @@ Layout::write_output_sections(Output_file* of) const
     }
 }
 
+// Split the work of writing out the Output_sections into pieces, each
+// of which is written by a Write_sections_task, and return the number
+// of pieces.  With linker scripts a few sections may hold most of the
+// Output_data.  With threads, we write different sections in
+// parallel, and split a section with a lot of Output_section_data into
+// ranges of input sections which are written in parallel.
+
+size_t
+Layout::prepare_write_output_sections(Output_file* of)
+{
+  Write_sections_pieces* pieces = new Write_sections_pieces(this, of);
+  this->write_sections_pieces_ = pieces;
+
+  size_t threads = parallel_thread_count();
+  if (threads <= 1)
+    {
+      pieces->add_all_sections();
+      return pieces->piece_count();
+    }
+
+  std::vector<off_t> sizes;
+  off_t total = 0;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      off_t size = 0;
+      if (!(*p)->after_input_sections())
+	size = (*p)->output_section_data_write_size();
+      sizes.push_back(size);
+      total += size;
+    }
+
+  // Aim for a few pieces per thread, so that the threads finish at
+  // about the same time.
+  off_t piece_size = std::max(total / static_cast<off_t>(threads * 4),
+			      min_write_piece_size);
+
+  std::vector<Output_section::Input_section_range> ranges;
+  size_t i = 0;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p, ++i)
+    {
+      if ((*p)->after_input_sections())
+	continue;
+      if (sizes[i] < 2 * piece_size)
+	{
+	  pieces->add_section(*p);
+	  continue;
+	}
+      ranges.clear();
+      (*p)->split_for_write(piece_size, &ranges);
+      pieces->add_fills(*p);
+      for (size_t j = 0; j < ranges.size(); ++j)
+	pieces->add_range(*p, ranges[j]);
+    }
+
+  // We always need at least one task.
+  if (pieces->piece_count() == 0)
+    pieces->add_all_sections();
+
+  return pieces->piece_count();
+}
+
+// Write out piece I of the Output_sections.  When the last piece is
+// done, tell the build ID hash that the Write_sections_tasks are
+// done.
+
+void
+Layout::write_output_sections_piece(Workqueue* workqueue, size_t i) const
+{
+  gold_assert(this->write_sections_pieces_ != NULL);
+  this->write_sections_pieces_->write_piece(i);
+  if (this->write_sections_pieces_->piece_done())
+    this->build_id_writer_done(workqueue, NULL);
+}
+
 // Write out data not associated with a section or the symbol table.
 
 void
@@ -5409,6 +6072,123 @@ Layout::write_sections_after_input_sections(Output_file* of)
   this->section_headers_->write(of);
 }
 
+// For a tree-style build ID, set up to hash each chunk of the output
+// file as soon as the tasks which write to it are done.  We only know
+// which tasks write which parts of the file when the file size is
+// fixed and the relocate tasks only write the input sections, so we
+// don't try with postprocessing sections, -r, --emit-relocs, or
+// incremental links.
+
+void
+Layout::prepare_build_id_tree_hash(const Input_objects* input_objects,
+				   Output_file* of, Workqueue* workqueue)
+{
+  const General_options& options(parameters->options());
+  if (this->build_id_note_ == NULL
+      || strcmp(options.build_id(), "tree") != 0
+      || options.build_id_chunk_size_for_treehash() == 0
+      || this->any_postprocessing_sections_
+      || options.relocatable()
+      || options.emit_relocs()
+      || parameters->incremental())
+    return;
+
+  const size_t filesize = (this->output_file_size_ <= 0 ? 0
+			   : static_cast<size_t>(this->output_file_size_));
+  if (filesize == 0
+      || filesize < options.build_id_min_file_size_for_treehash())
+    return;
+
+  Build_id_tree_hash* tree_hash =
+    new Build_id_tree_hash(of, filesize,
+			   options.build_id_chunk_size_for_treehash());
+
+  // The Write_sections_tasks write every output section which is not
+  // written after the input sections.  The symbol tables are also
+  // written by Write_symbols_task and Write_data_task, so we don't
+  // track them.
+  typedef std::vector<std::pair<off_t, off_t> > Extents;
+  Extents tracked;
+  Unordered_set<const Output_section*> tracked_sections;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      const Output_section* os = *p;
+      if (os->type() == elfcpp::SHT_NOBITS
+	  || os->data_size() == 0
+	  || os->after_input_sections()
+	  || os == this->symtab_section_
+	  || os == this->dynsym_section_)
+	continue;
+      tree_hash->add_writer(NULL, os->offset(), os->data_size());
+      tracked.push_back(std::make_pair(os->offset(), os->data_size()));
+      tracked_sections.insert(os);
+    }
+
+  // Everything else--the file header, segment and section headers,
+  // the symbol tables, the sections written after the input
+  // sections, and any padding--is untracked.
+  std::sort(tracked.begin(), tracked.end());
+  off_t off = 0;
+  for (Extents::const_iterator p = tracked.begin(); p != tracked.end(); ++p)
+    {
+      if (p->first > off)
+	tree_hash->add_untracked(off, p->first - off);
+      off = std::max(off, p->first + p->second);
+    }
+  if (off < static_cast<off_t>(filesize))
+    tree_hash->add_untracked(off, filesize - off);
+
+  // Each Relocate_task writes the input sections of its object.
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      std::vector<const Output_section*> sections;
+      unsigned int shnum = (*p)->shnum();
+      for (unsigned int i = 1; i < shnum; ++i)
+	{
+	  const Output_section* os = (*p)->output_section(i);
+	  if (os != NULL
+	      && tracked_sections.find(os) != tracked_sections.end())
+	    sections.push_back(os);
+	}
+      std::sort(sections.begin(), sections.end());
+      sections.erase(std::unique(sections.begin(), sections.end()),
+		     sections.end());
+      for (std::vector<const Output_section*>::const_iterator q =
+	     sections.begin();
+	   q != sections.end();
+	   ++q)
+	tree_hash->add_writer(*p, (*q)->offset(), (*q)->data_size());
+    }
+
+  tree_hash->start(workqueue);
+  this->build_id_tree_hash_ = tree_hash;
+}
+
+void
+Layout::build_id_writer_done(Workqueue* workqueue, const Relobj* object) const
+{
+  if (this->build_id_tree_hash_ != NULL)
+    this->build_id_tree_hash_->writer_done(workqueue, object);
+}
+
+Task_token*
+Layout::finish_build_id_tree_hash(Workqueue* workqueue,
+				  unsigned char** array_of_hashes,
+				  size_t* size_of_hashes) const
+{
+  Build_id_tree_hash* tree_hash = this->build_id_tree_hash_;
+  if (tree_hash == NULL)
+    return NULL;
+  tree_hash->all_writers_done(workqueue);
+  *array_of_hashes = tree_hash->array_of_hashes();
+  *size_of_hashes = tree_hash->size_of_hashes();
+  return tree_hash->blocker();
+}
+
 // If a tree-style build ID was requested, the parallel part of that computation
 // is already done, and the final hash-of-hashes is computed here.  For other
 // types of build IDs, all the work is done here.
@@ -5531,6 +6311,38 @@ Layout::print_stats() const
        p != this->section_list_.end();
        ++p)
     (*p)->print_merge_stats();
+
+  if (this->debug_type_dedup_ != NULL)
+    this->debug_type_dedup_->print_stats();
+
+  if (this->relaxation_stats_.empty())
+    return;
+
+  fprintf(stderr, _("%s: relaxation passes: %u\n"),
+	  program_name,
+	  static_cast<unsigned int>(this->relaxation_stats_.size()));
+  for (size_t i = 0; i < this->relaxation_stats_.size(); ++i)
+    {
+      const Relaxation_pass_stats& rs(this->relaxation_stats_[i]);
+      unsigned int pass = static_cast<unsigned int>(i + 1);
+      fprintf(stderr,
+	      _("%s: relaxation pass %u: output sections adjusted: %u\n"),
+	      program_name, pass, rs.sections_adjusted);
+      fprintf(stderr,
+	      _("%s: relaxation pass %u layout time: "
+		"(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)\n"),
+	      program_name, pass,
+	      rs.layout_time.user / 1000, (rs.layout_time.user % 1000) * 1000,
+	      rs.layout_time.sys / 1000, (rs.layout_time.sys % 1000) * 1000,
+	      rs.layout_time.wall / 1000, (rs.layout_time.wall % 1000) * 1000);
+      fprintf(stderr,
+	      _("%s: relaxation pass %u relax time: "
+		"(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)\n"),
+	      program_name, pass,
+	      rs.relax_time.user / 1000, (rs.relax_time.user % 1000) * 1000,
+	      rs.relax_time.sys / 1000, (rs.relax_time.sys % 1000) * 1000,
+	      rs.relax_time.wall / 1000, (rs.relax_time.wall % 1000) * 1000);
+    }
 }
 
 // Write_sections_task methods.
@@ -5558,9 +6370,9 @@ Write_sections_task::locks(Task_locker* tl)
 // Run the task--write out the data.
 
 void
-Write_sections_task::run(Workqueue*)
+Write_sections_task::run(Workqueue* workqueue)
 {
-  this->layout_->write_output_sections(this->of_);
+  this->layout_->write_output_sections_piece(workqueue, this->piece_);
 }
 
 // Write_data_task methods.
@@ -5653,13 +6465,31 @@ Write_after_input_sections_task::run(Workqueue*)
 void
 Build_id_task_runner::run(Workqueue* workqueue, const Task*)
 {
-  Task_token* post_hash_tasks_blocker = new Task_token(true);
   const Layout* layout = this->layout_;
   Output_file* of = this->of_;
-  const size_t filesize = (layout->output_file_size() <= 0 ? 0
-			   : static_cast<size_t>(layout->output_file_size()));
+
+  // If we have been hashing the output file as it was written, we
+  // only have to hash whatever is left.
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
+  Task_token* tree_hash_blocker =
+    layout->finish_build_id_tree_hash(workqueue, &array_of_hashes,
+				      &size_of_hashes);
+  if (tree_hash_blocker != NULL)
+    {
+      workqueue->queue(new Task_function(new Close_task_runner(this->options_,
+							       layout,
+							       of,
+							       array_of_hashes,
+							       size_of_hashes),
+					 tree_hash_blocker,
+					 "Task_function Close_task_runner"));
+      return;
+    }
+
+  Task_token* post_hash_tasks_blocker = new Task_token(true);
+  const size_t filesize = (layout->output_file_size() <= 0 ? 0
+			   : static_cast<size_t>(layout->output_file_size()));
 
   if (strcmp(this->options_->build_id(), "tree") == 0
       && this->options_->build_id_chunk_size_for_treehash() > 0
@@ -35,6 +35,7 @@
 #include "object.h"
 #include "dynobj.h"
 #include "stringpool.h"
+#include "timer.h"
 
 namespace gold
 {
@@ -57,8 +58,11 @@ class Output_data_dynamic;
 class Output_symtab_xindex;
 class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
+class Debug_type_dedup;
 class Eh_frame;
 class Gdb_index;
+class Build_id_tree_hash;
+class Write_sections_pieces;
 class Target;
 struct Timespec;
 
@@ -594,6 +598,12 @@ class Layout
   void
   read_layout_from_file();
 
+  // Read the call graph from the file specified with linker option
+  // --call-graph-ordering-file, and compute an order for the .text
+  // sections of the functions it names.
+  void
+  read_call_graph_from_file();
+
   // Layout an input reloc section when doing a relocatable link.  The
   // section is RELOC_SHNDX in OBJECT, with data in SHDR.
   // DATA_SECTION is the reloc section to which it refers.  RR is the
@@ -845,6 +855,17 @@ class Layout
   void
   write_output_sections(Output_file* of) const;
 
+  // Split the work of writing out the output sections into pieces,
+  // each written by a Write_sections_task, and return the number of
+  // pieces.  This must be called before any Write_sections_task is
+  // queued.
+  size_t
+  prepare_write_output_sections(Output_file* of);
+
+  // Write out piece I of the output sections.
+  void
+  write_output_sections_piece(Workqueue*, size_t i) const;
+
   // Write out data not associated with an input file or the symbol
   // table.
   void
@@ -906,6 +927,28 @@ class Layout
   void
   add_target_specific_dynamic_tag(elfcpp::DT tag, unsigned int val);
 
+  // If possible, arrange for a tree-style build ID to be computed
+  // while the output file is being written.  This must be called
+  // before any of the tasks which write the output file are queued.
+  void
+  prepare_build_id_tree_hash(const Input_objects*, Output_file*,
+			     Workqueue*);
+
+  // Record that a task which writes to the output file has finished.
+  // OBJECT is the object relocated by a Relocate_task, or NULL for
+  // the last Write_sections_task.
+  void
+  build_id_writer_done(Workqueue*, const Relobj* object) const;
+
+  // If prepare_build_id_tree_hash set up a tree-style build ID, finish
+  // hashing the output file, which has now been completely written.
+  // Return a blocker which will be unblocked when all the chunks have
+  // been hashed, and set *ARRAY_OF_HASHES and *SIZE_OF_HASHES.
+  // Otherwise return NULL.
+  Task_token*
+  finish_build_id_tree_hash(Workqueue*, unsigned char** array_of_hashes,
+			    size_t* size_of_hashes) const;
+
   // Compute and write out the build ID if needed.
   void
   write_build_id(Output_file*, unsigned char*, size_t) const;
@@ -1278,6 +1321,25 @@ class Layout
 
   typedef std::vector<Output_section_data*> Output_section_data_list;
 
+  // Statistics for one pass of the relaxation loop.  These are only
+  // collected for --stats.
+  struct Relaxation_pass_stats
+  {
+    Relaxation_pass_stats()
+      : sections_adjusted(0), layout_time(), relax_time()
+    { }
+
+    // Number of output sections whose input section offsets had to
+    // be adjusted because a relaxed input section changed size.
+    unsigned int sections_adjusted;
+    // Time spent laying out the sections and segments.
+    Timer::TimeStats layout_time;
+    // Time spent in the target relaxation hook.
+    Timer::TimeStats relax_time;
+  };
+
+  typedef std::vector<Relaxation_pass_stats> Relaxation_stats;
+
   // Debug checker class.
   class Relaxation_debug_check
   {
@@ -1382,10 +1444,17 @@ class Layout
   Gdb_index* gdb_index_data_;
   // The space for the build ID checksum if there is one.
   Output_section_data* build_id_note_;
+  // Used to hash the output file while it is written, for a
+  // tree-style build ID.
+  Build_id_tree_hash* build_id_tree_hash_;
+  // The pieces written by the Write_sections_tasks.
+  Write_sections_pieces* write_sections_pieces_;
   // The output section containing dwarf abbreviations
   Output_reduced_debug_abbrev_section* debug_abbrev_;
   // The output section containing the dwarf debug info tree
   Output_reduced_debug_info_section* debug_info_;
+  // Merges duplicate debug types for --dedup-debug-types.
+  Debug_type_dedup* debug_type_dedup_;
   // A list of group sections and their signatures.
   Group_signatures group_signatures_;
   // The size of the output file.
@@ -1428,6 +1497,8 @@ class Layout
   Segment_states* segment_states_;
   // A relaxation debug checker.  We only create one when in debugging mode.
   Relaxation_debug_check* relaxation_debug_check_;
+  // Statistics for each relaxation pass, when --stats is used.
+  Relaxation_stats relaxation_stats_;
   // Plugins specify section_ordering using this map.  This is set in
   // update_section_order in plugin.cc
   std::map<Section_id, unsigned int> section_order_map_;
@@ -1447,18 +1518,19 @@ class Layout
 };
 
 // This task handles writing out data in output sections which is not
-// part of an input section, or which requires special handling.  When
-// this is done, it unblocks both output_sections_blocker and
-// final_blocker.
+// part of an input section, or which requires special handling.  The
+// work is split into pieces by Layout::prepare_write_output_sections,
+// and there is one task for each piece.  When a task is done, it
+// unblocks both output_sections_blocker and final_blocker.
 
 class Write_sections_task : public Task
 {
  public:
-  Write_sections_task(const Layout* layout, Output_file* of,
+  Write_sections_task(const Layout* layout, Output_file* of, size_t piece,
 		      Task_token* output_sections_blocker,
 		      Task_token* input_sections_blocker,
 		      Task_token* final_blocker)
-    : layout_(layout), of_(of),
+    : layout_(layout), of_(of), piece_(piece),
       output_sections_blocker_(output_sections_blocker),
       input_sections_blocker_(input_sections_blocker),
       final_blocker_(final_blocker)
@@ -1484,6 +1556,7 @@ class Write_sections_task : public Task
 
   const Layout* layout_;
   Output_file* of_;
+  size_t piece_;
   Task_token* output_sections_blocker_;
   Task_token* input_sections_blocker_;
   Task_token* final_blocker_;
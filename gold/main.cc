@@ -234,6 +234,8 @@ main(int argc, char** argv)
 
   if (parameters->options().section_ordering_file())
     layout.read_layout_from_file();
+  else if (parameters->options().call_graph_ordering_file())
+    layout.read_call_graph_from_file();
 
   // Load plugin libraries.
   if (command_line.options().has_plugins())
@@ -251,6 +253,18 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  if (command_line.options().trace_file() != NULL)
+    workqueue.write_trace();
+
+  if (command_line.options().library_path_cache() != NULL)
+    Dirsearch::write_cache();
+
+  // Record the input file contents for the next incremental link.
+  if (layout.incremental_inputs() != NULL
+      && layout.incremental_inputs()->hash_file() != NULL
+      && errors.error_count() == 0)
+    layout.incremental_inputs()->hash_file()->write();
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -298,12 +312,18 @@ main(int argc, char** argv)
       File_read::print_stats();
       Archive::print_stats();
       Lib_group::print_stats();
+      Dirsearch::print_stats();
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
 	      program_name, static_cast<long long>(layout.output_file_size()));
       symtab.print_stats();
+      if (symtab.gc() != NULL)
+	symtab.gc()->print_stats();
       layout.print_stats();
+      if (layout.incremental_inputs() != NULL)
+	layout.incremental_inputs()->print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
+      workqueue.print_stats();
     }
 
   // Issue defined symbol report.
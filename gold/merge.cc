@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "gold-threads.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -473,6 +474,43 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
+  // When we can use several threads, just keep the section contents
+  // now.  finalize_merged_data will find and hash the strings of all
+  // the input sections in parallel, and then add them to the
+  // Stringpool in the order in which we saw them, so that the result
+  // is the same.  We hold a lasting view of the section rather than
+  // copying it.  A decompressed section is already a buffer of our
+  // own.
+  if (parallel_thread_count() > 1)
+    {
+      File_view* view = NULL;
+      if (!is_new)
+	{
+	  section_size_type view_len;
+	  view = object->lasting_section_contents(shndx, &view_len);
+	  gold_assert(view == NULL || view_len == sec_len);
+	}
+      if (is_new || view != NULL)
+	{
+	  if (is_new)
+	    {
+	      merged_strings_list->new_contents = pdata;
+	      merged_strings_list->contents = p;
+	    }
+	  else
+	    {
+	      merged_strings_list->view = view;
+	      merged_strings_list->contents =
+		reinterpret_cast<const Char_type*>(view->data());
+	    }
+	  merged_strings_list->contents_len = sec_len / sizeof(Char_type);
+
+	  if (this->keeps_input_sections())
+	    record_input_section(object, shndx);
+	  return true;
+	}
+    }
+
   // Count the number of non-null strings in the section and size the list.
   size_t count = 0;
   const Char_type* pt = p;
@@ -538,6 +576,165 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   return true;
 }
 
+// Find the strings in the contents of an input section held by LIST,
+// recording their offsets, lengths and hash codes.  This does not
+// look at the Stringpool, so it may be run for several input sections
+// at once.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::find_pending_strings(
+    Merged_strings_list* list)
+{
+  const Char_type* const pstart = list->contents;
+  const Char_type* p = pstart;
+  const Char_type* const pend = p + list->contents_len;
+
+  // If the last string is not null terminated, it runs to the end of
+  // the section; do_add_input_section has already warned about it.
+  const Char_type* pend0 = pend;
+  while (pend0 > p && pend0[-1] != 0)
+    --pend0;
+
+  Merged_strings& merged_strings(list->merged_strings);
+  Pending_strings& pending_strings(list->pending_strings);
+
+  // The index I is in bytes, not characters.  As in
+  // do_add_input_section, each string must have the same alignment
+  // as the start of the section.
+  section_size_type i = 0;
+  while (p < pend)
+    {
+      size_t len = p < pend0 ? string_length(p) : pend - p;
+      if (len != 0)
+	{
+	  ++list->count;
+	  if ((i & (this->addralign() - 1)) != 0)
+	    list->has_misaligned_strings = true;
+	}
+
+      Pending_string ps;
+      ps.length = len;
+      ps.hash_code = Stringpool_template<Char_type>::hash_string(p, len);
+      pending_strings.push_back(ps);
+      merged_strings.push_back(Merged_string(i, 0));
+
+      p += len + 1;
+      i += (len + 1) * sizeof(Char_type);
+    }
+
+  // Record the last offset in the input section so that we can
+  // compute the length of the last string.
+  merged_strings.push_back(Merged_string(i, 0));
+}
+
+// Add the strings found by find_pending_strings to the Stringpool.
+// This must be done for the input sections in order.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::add_pending_strings(Merged_strings_list* list)
+{
+  const Pending_strings& pending_strings(list->pending_strings);
+  Merged_strings& merged_strings(list->merged_strings);
+  for (size_t j = 0; j < pending_strings.size(); ++j)
+    {
+      const Char_type* s = (list->contents
+			    + merged_strings[j].offset / sizeof(Char_type));
+      Stringpool::Key key;
+      this->stringpool_.add_with_length_and_hash(s,
+						 pending_strings[j].length,
+						 pending_strings[j].hash_code,
+						 true, &key);
+      merged_strings[j].stringpool_key = key;
+    }
+
+  this->input_count_ += list->count;
+  this->input_size_ += merged_strings.back().offset;
+
+  if (list->has_misaligned_strings)
+    gold_warning(_("%s: section %s contains incorrectly aligned strings;"
+		   " the alignment of those strings won't be preserved"),
+		 list->object->name().c_str(),
+		 list->object->section_name(list->shndx).c_str());
+
+  list->release_contents();
+  Pending_strings().swap(list->pending_strings);
+}
+
+// Record the output offsets of the strings in LIST.  The
+// Input_merge_map must already have been created.  Each input section
+// has its own Input_merge_map, so this may be run for several input
+// sections at once.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::map_merged_strings(Merged_strings_list* list)
+{
+  section_offset_type last_input_offset = 0;
+  section_offset_type last_output_offset = 0;
+  Object_merge_map::Input_merge_map* input_merge_map = list->input_merge_map;
+  for (typename Merged_strings::const_iterator p =
+	 list->merged_strings.begin();
+       p != list->merged_strings.end();
+       ++p)
+    {
+      section_size_type length = p->offset - last_input_offset;
+      if (length > 0)
+	input_merge_map->add_mapping(last_input_offset, length,
+				     last_output_offset);
+      last_input_offset = p->offset;
+      if (p->stringpool_key != 0)
+	last_output_offset =
+	  this->stringpool_.get_offset_from_key(p->stringpool_key);
+    }
+}
+
+// Parallel_work which runs find_pending_strings for each input
+// section.
+
+template<typename Char_type>
+class Output_merge_string<Char_type>::Find_strings_work : public Parallel_work
+{
+ public:
+  Find_strings_work(Output_merge_string<Char_type>* merge,
+		    const Merged_strings_lists& lists)
+    : merge_(merge), lists_(lists)
+  { }
+
+  void
+  run_piece(size_t i)
+  {
+    if (this->lists_[i]->contents != NULL)
+      this->merge_->find_pending_strings(this->lists_[i]);
+  }
+
+ private:
+  Output_merge_string<Char_type>* merge_;
+  const Merged_strings_lists& lists_;
+};
+
+// Parallel_work which runs map_merged_strings for each input
+// section.
+
+template<typename Char_type>
+class Output_merge_string<Char_type>::Map_strings_work : public Parallel_work
+{
+ public:
+  Map_strings_work(Output_merge_string<Char_type>* merge,
+		   const Merged_strings_lists& lists)
+    : merge_(merge), lists_(lists)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->merge_->map_merged_strings(this->lists_[i]); }
+
+ private:
+  Output_merge_string<Char_type>* merge_;
+  const Merged_strings_lists& lists_;
+};
+
 // Finalize the mappings from the input sections to the output
 // section, and return the final data size.
 
@@ -545,37 +742,37 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
-  this->stringpool_.set_string_offsets();
-
-  for (typename Merged_strings_lists::const_iterator l =
-	 this->merged_strings_lists_.begin();
-       l != this->merged_strings_lists_.end();
+  Merged_strings_lists& lists(this->merged_strings_lists_);
+
+  // If do_add_input_section deferred the work, find and hash the
+  // strings of each input section in parallel, then add them to the
+  // Stringpool serially, in the original order.
+  Find_strings_work find_work(this, lists);
+  run_parallel_work(&find_work, lists.size());
+  for (typename Merged_strings_lists::const_iterator l = lists.begin();
+       l != lists.end();
        ++l)
     {
-      section_offset_type last_input_offset = 0;
-      section_offset_type last_output_offset = 0;
-      Relobj *object = (*l)->object;
-      Object_merge_map* merge_map = object->get_or_create_merge_map();
-      Object_merge_map::Input_merge_map* input_merge_map =
-        merge_map->get_or_make_input_merge_map(this, (*l)->shndx);
-
-      for (typename Merged_strings::const_iterator p =
-	     (*l)->merged_strings.begin();
-	   p != (*l)->merged_strings.end();
-	   ++p)
-	{
-	  section_size_type length = p->offset - last_input_offset;
-	  if (length > 0)
-	    input_merge_map->add_mapping(last_input_offset, length,
-                                         last_output_offset);
-	  last_input_offset = p->offset;
-	  if (p->stringpool_key != 0)
-	    last_output_offset =
-	        this->stringpool_.get_offset_from_key(p->stringpool_key);
-	}
-      delete *l;
+      if ((*l)->contents != NULL)
+	this->add_pending_strings(*l);
+
+      // Creating the Input_merge_map modifies the Object_merge_map,
+      // so we do it here rather than in parallel.
+      Object_merge_map* merge_map = (*l)->object->get_or_create_merge_map();
+      (*l)->input_merge_map =
+	merge_map->get_or_make_input_merge_map(this, (*l)->shndx);
     }
 
+  this->stringpool_.set_string_offsets();
+
+  Map_strings_work map_work(this, lists);
+  run_parallel_work(&map_work, lists.size());
+
+  for (typename Merged_strings_lists::const_iterator l = lists.begin();
+       l != lists.end();
+       ++l)
+    delete *l;
+
   // Save some memory.  This also ensures that this function will work
   // if called twice, as may happen if Layout::set_segment_offsets
   // finds a better alignment.
@@ -482,6 +482,18 @@ class Output_merge_string : public Output_merge_base
 
   typedef std::vector<Merged_string> Merged_strings;
 
+  // A string which has been found in an input section but not yet
+  // added to the Stringpool.
+  struct Pending_string
+  {
+    // The length of the string in characters.
+    size_t length;
+    // The Stringpool hash code of the string.
+    size_t hash_code;
+  };
+
+  typedef std::vector<Pending_string> Pending_strings;
+
   struct Merged_strings_list
   {
     // The input object where the strings were found.
@@ -490,14 +502,69 @@ class Output_merge_string : public Output_merge_base
     unsigned int shndx;
     // The list of merged strings.
     Merged_strings merged_strings;
+    // When the strings are hashed in parallel by
+    // finalize_merged_data, the section contents, and their length in
+    // characters.  Otherwise NULL.
+    const Char_type* contents;
+    size_t contents_len;
+    // The lasting view holding CONTENTS, or NULL.
+    File_view* view;
+    // If the section was compressed, the buffer holding the
+    // decompressed CONTENTS, which we must free.  Otherwise NULL.
+    const unsigned char* new_contents;
+    // When CONTENTS is not NULL, the strings found in it, in the
+    // same order as MERGED_STRINGS.
+    Pending_strings pending_strings;
+    // The number of non-empty strings, set with PENDING_STRINGS.
+    size_t count;
+    // Whether any string is misaligned, set with PENDING_STRINGS.
+    bool has_misaligned_strings;
+    // The map from input offsets to output offsets.
+    Object_merge_map::Input_merge_map* input_merge_map;
 
     Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+      : object(objecta), shndx(shndxa), merged_strings(), contents(NULL),
+	contents_len(0), view(NULL), new_contents(NULL), pending_strings(),
+	count(0), has_misaligned_strings(false), input_merge_map(NULL)
     { }
+
+    ~Merged_strings_list()
+    { this->release_contents(); }
+
+    // Give up CONTENTS.  The object is not locked when we are done
+    // with it, so the view is deleted when the object is next
+    // released.
+    void
+    release_contents()
+    {
+      if (this->view != NULL)
+	this->object->release_view_later(this->view);
+      delete[] this->new_contents;
+      this->contents = NULL;
+      this->view = NULL;
+      this->new_contents = NULL;
+    }
   };
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
+  class Find_strings_work;
+  class Map_strings_work;
+
+  // Find the strings in the contents of an input section recorded in
+  // LIST, and compute their hash codes.
+  void
+  find_pending_strings(Merged_strings_list* list);
+
+  // Add the strings found by find_pending_strings to the Stringpool.
+  void
+  add_pending_strings(Merged_strings_list* list);
+
+  // Record the output offsets of the strings in LIST in its
+  // Input_merge_map.
+  void
+  map_merged_strings(Merged_strings_list* list);
+
   // As we see the strings, we add them to a Stringpool.
   Stringpool_template<Char_type> stringpool_;
   // Map from a location in an input object to an entry in the
@@ -42,6 +42,7 @@
 #include "compressed_output.h"
 #include "incremental.h"
 #include "merge.h"
+#include "ehframe.h"
 
 namespace gold
 {
@@ -61,6 +62,8 @@ Read_symbols_data::~Read_symbols_data()
     delete this->symbols;
   if (this->symbol_names != NULL)
     delete this->symbol_names;
+  if (this->prepared_symbol_names != NULL)
+    delete this->prepared_symbol_names;
   if (this->versym != NULL)
     delete this->versym;
   if (this->verdef != NULL)
@@ -477,6 +480,7 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     kept_comdat_sections_(),
     has_eh_frame_(false),
     discarded_eh_frame_shndx_(-1U),
+    parsed_eh_frame_(NULL),
     is_deferred_layout_(false),
     deferred_layout_(),
     deferred_layout_relocs_(),
@@ -488,6 +492,7 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
 template<int size, bool big_endian>
 Sized_relobj_file<size, big_endian>::~Sized_relobj_file()
 {
+  delete this->parsed_eh_frame_;
 }
 
 // Set up an object file based on the file header.  This sets up the
@@ -850,6 +855,7 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->external_symbols_offset = 0;
   sd->symbol_names = NULL;
   sd->symbol_names_size = 0;
+  sd->prepared_symbol_names = NULL;
 
   if (this->symtab_shndx_ == 0)
     {
@@ -918,6 +924,109 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  // When using threads, we may be reading the symbols of several
+  // objects in parallel.  Take the opportunity to do the part of the
+  // symbol table work which does not depend on other objects, so
+  // that there is less to do when adding the symbols, which must be
+  // done in order.
+  if (parameters->options().threads())
+    {
+      size_t extcount = extsize / sym_size;
+      sd->prepared_symbol_names = new Prepared_symbol_names();
+      Symbol_table::prepare_relobj_symbols<size, big_endian>(
+	  fvsymtab->data() + sd->external_symbols_offset, extcount,
+	  reinterpret_cast<const char*>(fvstrtab->data()),
+	  sd->symbol_names_size, sd->prepared_symbol_names);
+
+      // Likewise parse the exception frame information, leaving only
+      // the merge with other objects for layout.
+      if (this->has_eh_frame_
+	  && !parameters->options().relocatable()
+	  && !parameters->incremental()
+	  && this->parsed_eh_frame_ == NULL)
+	this->parse_eh_frame_section(pshdrs,
+				     reinterpret_cast<const char*>(
+				       sd->section_names->data()),
+				     sd->section_names_size,
+				     fvsymtab->data(), readsize,
+				     fvstrtab->data(), sd->symbol_names_size);
+    }
+}
+
+// Parse the first GNU style .eh_frame section in the object, so that
+// the work is done by the Read_symbols task.  PSHDRS, NAMES and
+// NAMES_SIZE are the section headers and names; the rest of the
+// arguments are the symbols and symbol names, as for
+// layout_eh_frame_section.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::parse_eh_frame_section(
+    const unsigned char* pshdrs,
+    const char* names,
+    section_size_type names_size,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size)
+{
+  const unsigned int shnum = this->shnum();
+  unsigned int shndx = 0;
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      if (shdr.get_sh_name() < names_size
+	  && strcmp(names + shdr.get_sh_name(), ".eh_frame") == 0
+	  && this->check_eh_frame_flags(&shdr))
+	{
+	  shndx = i;
+	  break;
+	}
+    }
+  if (shndx == 0)
+    return;
+
+  // Find the relocation section the same way that do_layout does.
+  unsigned int reloc_shndx = 0;
+  unsigned int reloc_type = 0;
+  p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      unsigned int sh_type = shdr.get_sh_type();
+      if ((sh_type == elfcpp::SHT_REL || sh_type == elfcpp::SHT_RELA)
+	  && this->adjust_shndx(shdr.get_sh_info()) == shndx)
+	{
+	  if (reloc_shndx != 0)
+	    reloc_shndx = -1U;
+	  else
+	    {
+	      reloc_shndx = i;
+	      reloc_type = sh_type;
+	    }
+	}
+    }
+
+  this->parsed_eh_frame_ =
+    Eh_frame::parse_ehframe_input_section(this, symbols, symbols_size,
+					  symbol_names, symbol_names_size,
+					  shndx, reloc_shndx, reloc_type);
+}
+
+// Return the .eh_frame section SHNDX if it was parsed by
+// parse_eh_frame_section.
+
+template<int size, bool big_endian>
+Eh_frame_input_section*
+Sized_relobj_file<size, big_endian>::parsed_eh_frame_section(
+    unsigned int shndx) const
+{
+  if (this->parsed_eh_frame_ != NULL
+      && this->parsed_eh_frame_->shndx() == shndx)
+    return this->parsed_eh_frame_;
+  return NULL;
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -1301,6 +1410,14 @@ Sized_relobj_file<size, big_endian>::layout_eh_frame_section(
 					       reloc_shndx,
 					       reloc_type,
 					       &offset);
+
+  // We are done with the parsed section, if any.
+  if (this->parsed_eh_frame_section(shndx) != NULL)
+    {
+      delete this->parsed_eh_frame_;
+      this->parsed_eh_frame_ = NULL;
+    }
+
   this->output_sections()[shndx] = os;
   if (os == NULL || offset == -1)
     {
@@ -2024,6 +2141,7 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 			  sd->symbols->data() + sd->external_symbols_offset,
 			  symcount, this->local_symbol_count_,
 			  sym_names, sd->symbol_names_size,
+			  sd->prepared_symbol_names,
 			  &this->symbols_,
 			  &this->defined_count_);
 
@@ -2031,6 +2149,8 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   sd->symbols = NULL;
   delete sd->symbol_names;
   sd->symbol_names = NULL;
+  delete sd->prepared_symbol_names;
+  sd->prepared_symbol_names = NULL;
 }
 
 // Find out if this object, that is a member of a lib group, should be included
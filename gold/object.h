@@ -48,18 +48,46 @@ class Pluginobj;
 class Dynobj;
 class Object_merge_map;
 class Relocatable_relocs;
+class Eh_frame_input_section;
 struct Symbols_data;
 
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// The name of a global symbol in a relocatable object, split into
+// the name proper and the version, along with the Stringpool hash
+// codes of each.  This is computed by
+// Symbol_table::prepare_relobj_symbols when the symbols are read,
+// which may be done for several objects in parallel, so that symbol
+// resolution, which is done one object at a time, need not do it.
+
+struct Prepared_symbol_name
+{
+  // Length of the name, not including any version.
+  size_t namelen;
+  // Hash code of the name.
+  size_t name_hash;
+  // Offset from the start of the name to the version, or 0 if there
+  // is no version.
+  size_t ver_offset;
+  // Length of the version.
+  size_t verlen;
+  // Hash code of the version.
+  size_t ver_hash;
+  // Whether the name was written as NAME@@VERSION.
+  bool is_default_version;
+};
+
+typedef std::vector<Prepared_symbol_name> Prepared_symbol_names;
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
 {
   Read_symbols_data()
     : section_headers(NULL), section_names(NULL), symbols(NULL),
-      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL)
+      symbol_names(NULL), prepared_symbol_names(NULL), versym(NULL),
+      verdef(NULL), verneed(NULL)
   { }
 
   ~Read_symbols_data();
@@ -82,6 +110,10 @@ struct Read_symbols_data
   File_view* symbol_names;
   // Size of symbol name data in bytes.
   section_size_type symbol_names_size;
+  // The split and hashed names of the external symbols, or NULL if
+  // they have not been computed.  This is only used on relocatable
+  // objects.
+  Prepared_symbol_names* prepared_symbol_names;
 
   // Version information.  This is only used on dynamic objects.
   // Version symbol data (from SHT_GNU_versym section).
@@ -112,11 +144,14 @@ struct Symbol_location_info
 struct Section_relocs
 {
   Section_relocs()
-    : contents(NULL)
+    : contents(NULL), scan_contents(NULL), scan_reloc_count(0)
   { }
 
   ~Section_relocs()
-  { delete this->contents; }
+  {
+    delete this->contents;
+    delete[] this->scan_contents;
+  }
 
   // Index of reloc section.
   unsigned int reloc_shndx;
@@ -128,6 +163,11 @@ struct Section_relocs
   unsigned int sh_type;
   // Number of reloc entries.
   size_t reloc_count;
+  // If not NULL, the subset of the relocs which scan_relocs must
+  // still look at, as determined by prescan_relocs.
+  unsigned char* scan_contents;
+  // Number of reloc entries in SCAN_CONTENTS.
+  size_t scan_reloc_count;
   // Output section.
   Output_section* output_section;
   // Whether this section has special handling for offsets.
@@ -401,7 +441,7 @@ class Object
       is_dynamic_(is_dynamic), is_needed_(false), uses_split_stack_(false),
       has_no_split_stack_(false), no_export_(false),
       is_in_system_directory_(false), as_needed_(false), xindex_(NULL),
-      compressed_sections_(NULL)
+      compressed_sections_(NULL), views_to_release_()
   {
     if (input_file != NULL)
       {
@@ -519,14 +559,31 @@ class Object
     return this->input_file()->file().token();
   }
 
-  // Release the underlying file.
+  // Release the underlying file.  This also deletes the views passed
+  // to release_view_later.
   void
   release()
   {
     if (this->input_file_ != NULL)
-      this->input_file()->file().release();
+      {
+	for (std::vector<File_view*>::const_iterator p =
+	       this->views_to_release_.begin();
+	     p != this->views_to_release_.end();
+	     ++p)
+	  delete *p;
+	this->views_to_release_.clear();
+	this->input_file()->file().release();
+      }
   }
 
+  // Arrange for VIEW to be deleted the next time the object is
+  // released.  This is for a lasting view which is no longer needed
+  // at a point where the object is not locked, so that it can not be
+  // deleted yet.
+  void
+  release_view_later(File_view* view)
+  { this->views_to_release_.push_back(view); }
+
   // Return whether we should just read symbols from this file.
   bool
   just_symbols() const
@@ -552,6 +609,13 @@ class Object
   const unsigned char*
   section_contents(unsigned int shndx, section_size_type* plen, bool cache);
 
+  // Return a lasting view of the contents of a section, and set *PLEN
+  // to the size.  This returns NULL if the section is empty, or if
+  // the object does not support lasting views of its sections.
+  File_view*
+  lasting_section_contents(unsigned int shndx, section_size_type* plen)
+  { return this->do_lasting_section_contents(shndx, plen); }
+
   // Adjust a symbol's section index as needed.  SYMNDX is the index
   // of the symbol and SHNDX is the symbol's section from
   // get_st_shndx.  This returns the section index.  It sets
@@ -909,6 +973,15 @@ class Object
   do_section_contents(unsigned int shndx, section_size_type* plen,
 		      bool cache) = 0;
 
+  // Return a lasting view of the contents of a section.  Child
+  // classes which can provide one should override this.
+  virtual File_view*
+  do_lasting_section_contents(unsigned int, section_size_type* plen)
+  {
+    *plen = 0;
+    return NULL;
+  }
+
   // Get the size of a section--implemented by child class.
   virtual uint64_t
   do_section_size(unsigned int shndx) = 0;
@@ -1084,6 +1157,8 @@ class Object
   // For compressed debug sections, map section index to uncompressed size
   // and contents.
   Compressed_section_map* compressed_sections_;
+  // Views to delete the next time the object is released.
+  std::vector<File_view*> views_to_release_;
 };
 
 // A regular object (ET_REL).  This is an abstract base class itself.
@@ -1155,6 +1230,13 @@ class Relobj : public Object
   scan_relocs(Symbol_table* symtab, Layout* layout, Read_relocs_data* rd)
   { return this->do_scan_relocs(symtab, layout, rd); }
 
+  // Drop the relocs which scan_relocs would ignore.  This does not
+  // change the symbol table, so it may run in parallel for different
+  // objects.
+  void
+  prescan_relocs(Symbol_table* symtab, Read_relocs_data* rd)
+  { this->do_prescan_relocs(symtab, rd); }
+
   // Return the value of the local symbol whose index is SYMNDX, plus
   // ADDEND.  ADDEND is passed in so that we can correctly handle the
   // section symbol for a merge section.
@@ -1393,6 +1475,11 @@ class Relobj : public Object
   virtual void
   do_scan_relocs(Symbol_table*, Layout*, Read_relocs_data*) = 0;
 
+  // Prescan the relocs--may be implemented by child class.
+  virtual void
+  do_prescan_relocs(Symbol_table*, Read_relocs_data*)
+  { }
+
   // Return the value of a local symbol.
   virtual uint64_t
   do_local_symbol_value(unsigned int symndx, uint64_t addend) const = 0;
@@ -2326,6 +2413,11 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   bool is_deferred_layout() const
   { return this->is_deferred_layout_; }
 
+  // Return the .eh_frame section SHNDX as parsed while reading the
+  // symbols, or NULL if it was not parsed then.
+  Eh_frame_input_section*
+  parsed_eh_frame_section(unsigned int shndx) const;
+
  protected:
   typedef typename Sized_relobj<size, big_endian>::Output_sections
       Output_sections;
@@ -2411,6 +2503,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_scan_relocs(Symbol_table*, Layout*, Read_relocs_data*);
 
+  // Drop the relocs which do_scan_relocs would ignore.
+  void
+  do_prescan_relocs(Symbol_table*, Read_relocs_data*);
+
   // Count the local symbols.
   void
   do_count_local_symbols(Stringpool_template<char>*,
@@ -2457,6 +2553,17 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
     return this->get_view(loc.file_offset, *plen, true, cache);
   }
 
+  // Return a lasting view of the contents of a section.
+  File_view*
+  do_lasting_section_contents(unsigned int shndx, section_size_type* plen)
+  {
+    Object::Location loc(this->elf_file_.section_contents(shndx));
+    *plen = convert_to_section_size_type(loc.data_size);
+    if (*plen == 0)
+      return NULL;
+    return this->get_lasting_view(loc.file_offset, *plen, true, false);
+  }
+
   // Return section flags.
   uint64_t
   do_section_flags(unsigned int shndx);
@@ -2631,6 +2738,15 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
                  const typename This::Shdr& shdr, unsigned int reloc_shndx,
                  unsigned int reloc_type);
 
+  // Parse the .eh_frame section ahead of layout.
+  void
+  parse_eh_frame_section(const unsigned char* pshdrs, const char* names,
+			 section_size_type names_size,
+			 const unsigned char* symbols,
+			 section_size_type symbols_size,
+			 const unsigned char* symbol_names,
+			 section_size_type symbol_names_size);
+
   // Layout an input .eh_frame section.
   void
   layout_eh_frame_section(Layout* layout, const unsigned char* symbols_data,
@@ -2838,6 +2954,9 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   // If this object has a GNU style .eh_frame section that is discarded in
   // output, record the index here.  Otherwise it is -1U.
   unsigned int discarded_eh_frame_shndx_;
+  // The .eh_frame section parsed by parse_eh_frame_section, until it
+  // is laid out.
+  Eh_frame_input_section* parsed_eh_frame_;
   // True if the layout of this object was deferred, waiting for plugin
   // replacement files.
   bool is_deferred_layout_;
@@ -1235,6 +1235,11 @@ General_options::finalize()
   if (this->pie() && this->relocatable())
     gold_fatal(_("-pie and -r are incompatible"));
 
+  if (this->section_ordering_file() != NULL
+      && this->call_graph_ordering_file() != NULL)
+    gold_fatal(_("--section-ordering-file and --call-graph-ordering-file "
+		 "are incompatible"));
+
   if (!this->shared())
     {
       if (this->filter() != NULL)
@@ -1261,10 +1266,47 @@ General_options::finalize()
 		 "[0.0, 1.0)"),
 	       this->hash_bucket_empty_fraction());
 
+#ifndef HAVE_ZSTD
+  if (strcmp(this->compress_debug_sections(), "zstd") == 0)
+    gold_fatal(_("--compress-debug-sections=zstd is not supported; "
+		 "gold was built without zstd"));
+#endif
+
+  if (this->compress_level() != 0)
+    {
+      int max_level = (strcmp(this->compress_debug_sections(), "zstd") == 0
+		       ? 22 : 9);
+      if (this->compress_level() > max_level)
+	gold_fatal(_("--compress-level value %d out of range [1, %d]"),
+		   this->compress_level(), max_level);
+    }
+
+  if (this->dedup_debug_types())
+    {
+      if (this->strip_debug())
+	this->set_dedup_debug_types(false);
+      else if (this->strip_debug_non_line())
+	gold_fatal(_("--dedup-debug-types and --strip-debug-non-line "
+		     "are incompatible"));
+      else if (this->relocatable())
+	gold_fatal(_("--dedup-debug-types and -r are incompatible"));
+      else if (this->emit_relocs())
+	gold_fatal(_("--dedup-debug-types and --emit-relocs are incompatible"));
+      else if (strcmp(this->compress_debug_sections(), "none") != 0)
+	gold_fatal(_("--dedup-debug-types and --compress-debug-sections "
+		     "are incompatible"));
+      else if (this->gdb_index())
+	gold_fatal(_("--dedup-debug-types and --gdb-index are incompatible"));
+    }
+
   if (this->implicit_incremental_ && this->incremental_mode_ == INCREMENTAL_OFF)
     gold_fatal(_("Options --incremental-changed, --incremental-unchanged, "
 		 "--incremental-unknown require the use of --incremental"));
 
+  if (this->incremental_hash_file() != NULL
+      && this->incremental_mode_ == INCREMENTAL_OFF)
+    gold_fatal(_("--incremental-hash-file requires the use of --incremental"));
+
   // Check for options that are not compatible with incremental linking.
   // Where an option can be disabled without seriously changing the semantics
   // of the link, we turn the option off; otherwise, we issue a fatal error.
@@ -1296,6 +1338,12 @@ General_options::finalize()
 			 "incremental link"));
 	  this->set_compress_debug_sections("none");
 	}
+      if (this->dedup_debug_types())
+	{
+	  gold_warning(_("ignoring --dedup-debug-types for an "
+			 "incremental link"));
+	  this->set_dedup_debug_types(false);
+	}
     }
 
   // --rosegment-gap implies --rosegment.
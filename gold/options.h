@@ -705,8 +705,12 @@ class General_options
 
   DEFINE_enum(compress_debug_sections, options::TWO_DASHES, '\0', "none",
 	      N_("Compress .debug_* sections in the output file"),
-	      ("[none,zlib,zlib-gnu,zlib-gabi]"),
-	      {"none", "zlib", "zlib-gnu", "zlib-gabi"});
+	      ("[none,zlib,zlib-gnu,zlib-gabi,zstd]"),
+	      {"none", "zlib", "zlib-gnu", "zlib-gabi", "zstd"});
+  DEFINE_uint(compress_level, options::TWO_DASHES, '\0', 0,
+	      N_("Compression level for --compress-debug-sections "
+		 "(default depends on -O)"),
+	      N_("LEVEL"));
 
   DEFINE_bool(copy_dt_needed_entries, options::TWO_DASHES, '\0', false,
 	      N_("Not supported"),
@@ -732,6 +736,11 @@ class General_options
 		N_("Turn on debugging"),
 		N_("[all,files,script,task][,...]"));
 
+  DEFINE_bool(dedup_debug_types, options::TWO_DASHES, '\0', false,
+	      N_("Emit one copy of each debug type DIE shared by "
+		 "compilation units"),
+	      N_("Do not merge duplicate debug type DIEs (default)"));
+
   DEFINE_special(defsym, options::TWO_DASHES, '\0',
 		 N_("Define a symbol"), N_("SYMBOL=EXPRESSION"));
 
@@ -886,6 +895,11 @@ class General_options
 		   " (default is output file)"),
 		N_("FILE"));
 
+  DEFINE_string(incremental_hash_file, options::TWO_DASHES, '\0', NULL,
+		N_("Keep input file content hashes in FILE, and treat inputs"
+		   " whose contents are unchanged as unchanged"),
+		N_("FILE"));
+
   DEFINE_special(incremental_changed, options::TWO_DASHES, '\0',
 		 N_("Assume files changed"), NULL);
 
@@ -928,6 +942,10 @@ class General_options
   DEFINE_dirlist(library_path, options::TWO_DASHES, 'L',
 		 N_("Add directory to search path"), N_("DIR"));
 
+  DEFINE_string(library_path_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache the contents of search directories in FILE"),
+		N_("FILE"));
+
   DEFINE_bool(text_reorder, options::TWO_DASHES, '\0', true,
 	      N_("Enable text section reordering for GCC section names "
 		 "(default)"),
@@ -951,6 +969,9 @@ class General_options
   DEFINE_bool(mmap_output_file, options::TWO_DASHES, '\0', true,
 	      N_("Map the output file for writing (default)."),
 	      N_("Do not map the output file for writing."));
+  DEFINE_bool(mmap_output_windows, options::TWO_DASHES, '\0', false,
+	      N_("Map only the parts of the output file being written."),
+	      N_("Map the whole output file at once (default)."));
 
   DEFINE_bool(print_map, options::TWO_DASHES, 'M', false,
 	      N_("Write map file on standard output"), NULL);
@@ -1025,6 +1046,10 @@ class General_options
 		 " (default)."),
 	      N_("Use fallocate or ftruncate to reserve space."));
 
+  DEFINE_bool(prefetch_inputs, options::TWO_DASHES, '\0', false,
+	      N_("Start reading all input files at the beginning of the link"),
+	      N_("Read input files only as they are needed (default)"));
+
   DEFINE_bool(preread_archive_symbols, options::TWO_DASHES, '\0', false,
 	      N_("Preread archive symbols when multi-threaded"), NULL);
 
@@ -1069,6 +1094,11 @@ class General_options
 		N_("Layout sections in the order specified."),
 		N_("FILENAME"));
 
+  DEFINE_string(call_graph_ordering_file, options::TWO_DASHES, '\0', NULL,
+		N_("Order .text sections using the call graph in FILENAME, "
+		   "one \"CALLER CALLEE COUNT\" per line"),
+		N_("FILENAME"));
+
   DEFINE_special(section_start, options::TWO_DASHES, '\0',
 		 N_("Set address of section"), N_("SECTION=ADDRESS"));
 
@@ -1134,6 +1164,10 @@ class General_options
   DEFINE_uint(icf_iterations, options::TWO_DASHES , '\0', 0,
 	      N_("Number of iterations of ICF (default 2)"), N_("COUNT"));
 
+  DEFINE_string(icf_cache_dir, options::TWO_DASHES, '\0', NULL,
+		N_("Cache ICF section checksums in DIR to speed up relinks"),
+		N_("DIR"));
+
   DEFINE_bool(print_icf_sections, options::TWO_DASHES, '\0', false,
 	      N_("List folded identical sections on stderr"),
 	      N_("Do not list folded identical sections"));
@@ -1168,6 +1202,11 @@ class General_options
 
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
+  DEFINE_string(trace_file, options::TWO_DASHES, '\0', NULL,
+		N_("Write a Chrome trace of the tasks run to FILE; work which "
+		   "a task splits across threads is shown as "
+		   "Parallel_work_task"),
+		N_("FILE"));
 
   DEFINE_special(script, options::TWO_DASHES, 'T',
 		 N_("Read linker script"), N_("FILE"));
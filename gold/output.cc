@@ -2562,9 +2562,10 @@ Output_section::add_input_section(Layout* layout,
     {
       Input_section isecn(object, shndx, input_section_size, addralign);
       /* If section ordering is requested by specifying a ordering file,
-	 using --section-ordering-file, match the section name with
-	 a pattern.  */
-      if (parameters->options().section_ordering_file())
+	 using --section-ordering-file or --call-graph-ordering-file,
+	 match the section name with a pattern.  */
+      if (parameters->options().section_ordering_file()
+	  || parameters->options().call_graph_ordering_file())
 	{
 	  unsigned int section_order_index =
 	    layout->find_section_order_index(std::string(secname));
@@ -3724,6 +3725,20 @@ Output_section::do_write(Output_file* of)
   // If the target performs relaxation, we delay filler generation until now.
   gold_assert(!this->generate_code_fills_at_write_ || this->fills_.empty());
 
+  this->write_fills(of);
+
+  Input_section_range all;
+  all.first = 0;
+  all.last = this->input_sections_.size();
+  all.offset = this->offset() + this->first_input_offset_;
+  this->write_input_section_range(of, all);
+}
+
+// Write the fills, and the free space in an incremental link.
+
+void
+Output_section::write_fills(Output_file* of)
+{
   off_t output_section_file_offset = this->offset();
   for (Fill_list::iterator p = this->fills_.begin();
        p != this->fills_.end();
@@ -3734,23 +3749,6 @@ Output_section::do_write(Output_file* of)
 		fill_data.data(), fill_data.size());
     }
 
-  off_t off = this->offset() + this->first_input_offset_;
-  for (Input_section_list::iterator p = this->input_sections_.begin();
-       p != this->input_sections_.end();
-       ++p)
-    {
-      off_t aligned_off = align_address(off, p->addralign());
-      if (this->generate_code_fills_at_write_ && (off != aligned_off))
-	{
-	  size_t fill_len = aligned_off - off;
-	  std::string fill_data(parameters->target().code_fill(fill_len));
-	  of->write(off, fill_data.data(), fill_data.size());
-	}
-
-      p->write(of);
-      off = aligned_off + p->data_size();
-    }
-
   // For incremental links, fill in unused chunks in debug sections
   // with dummy compilation unit headers.
   if (this->free_space_fill_ != NULL)
@@ -3772,6 +3770,72 @@ Output_section::do_write(Output_file* of)
     }
 }
 
+// Write the input sections in RANGE.  Sections from input files are
+// written elsewhere, but we write the code fill in front of them if
+// the target asked for it.
+
+void
+Output_section::write_input_section_range(Output_file* of,
+					  const Input_section_range& range)
+{
+  off_t off = range.offset;
+  for (size_t i = range.first; i < range.last; ++i)
+    {
+      Input_section& is(this->input_sections_[i]);
+      off_t aligned_off = align_address(off, is.addralign());
+      if (this->generate_code_fills_at_write_ && (off != aligned_off))
+	{
+	  size_t fill_len = aligned_off - off;
+	  std::string fill_data(parameters->target().code_fill(fill_len));
+	  of->write(off, fill_data.data(), fill_data.size());
+	}
+
+      is.write(of);
+      off = aligned_off + is.data_size();
+    }
+}
+
+off_t
+Output_section::output_section_data_write_size() const
+{
+  off_t size = 0;
+  for (Input_section_list::const_iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    if (!p->is_input_section())
+      size += p->data_size();
+  return size;
+}
+
+void
+Output_section::split_for_write(off_t piece_size,
+				std::vector<Input_section_range>* ranges) const
+{
+  gold_assert(!this->requires_postprocessing());
+
+  Input_section_range range;
+  range.first = 0;
+  range.offset = this->offset() + this->first_input_offset_;
+  off_t piece = 0;
+  off_t off = range.offset;
+  size_t count = this->input_sections_.size();
+  for (size_t i = 0; i < count; ++i)
+    {
+      const Input_section& is(this->input_sections_[i]);
+      off = align_address(off, is.addralign()) + is.data_size();
+      if (!is.is_input_section())
+	piece += is.data_size();
+      if (piece >= piece_size || i + 1 == count)
+	{
+	  range.last = i + 1;
+	  ranges->push_back(range);
+	  range.first = i + 1;
+	  range.offset = off;
+	  piece = 0;
+	}
+    }
+}
+
 // If a section requires postprocessing, create the buffer to use.
 
 void
@@ -4939,6 +5003,10 @@ Output_file::Output_file(const char* name)
     base_(NULL),
     map_is_anonymous_(false),
     map_is_allocated_(false),
+    map_is_windowed_(false),
+    window_alignment_(0),
+    windows_(),
+    windows_lock_(NULL),
     is_temporary_(false)
 {
 }
@@ -5122,6 +5190,14 @@ Output_file::resize(off_t file_size)
       this->base_ = static_cast<unsigned char*>(base);
       this->file_size_ = file_size;
     }
+  else if (this->map_is_windowed_)
+    {
+      // There is nothing mapped to move; just grow the file.
+      int err = gold_fallocate(this->o_, 0, file_size);
+      if (err != 0)
+	gold_fatal(_("%s: %s"), this->name_, strerror(err));
+      this->file_size_ = file_size;
+    }
   else
     {
       this->unmap();
@@ -5202,11 +5278,106 @@ Output_file::map_no_anonymous(bool writable)
   return true;
 }
 
+// Set up to map each view of the file separately, for
+// --mmap-output-windows.  This keeps only the parts of the output
+// file which are being written in our address space, rather than the
+// whole file.  Return whether the file can be mapped that way.
+
+bool
+Output_file::map_windowed()
+{
+  const int o = this->o_;
+
+  struct stat statbuf;
+  if (o == STDOUT_FILENO || o == STDERR_FILENO
+      || ::fstat(o, &statbuf) != 0
+      || !S_ISREG(statbuf.st_mode)
+      || this->is_temporary_)
+    return false;
+
+  // Ensure that we have disk space available for the file, as in
+  // map_no_anonymous.  This also sets the size of the file, so that
+  // every view we map is within it.
+  int err = gold_fallocate(o, 0, this->file_size_);
+  if (err != 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(err));
+
+  // Make sure that the file system lets us map the file for writing.
+  void* base = ::mmap(NULL, 1, PROT_READ | PROT_WRITE, MAP_SHARED, o, 0);
+  if (base == MAP_FAILED)
+    return false;
+  ::munmap(base, 1);
+
+  off_t alignment = 0;
+#if defined(HAVE_SYSCONF) && defined(_SC_PAGESIZE)
+  alignment = ::sysconf(_SC_PAGESIZE);
+#endif
+  // Any multiple of the page size will do.
+  if (alignment <= 0)
+    alignment = 64 * 1024;
+
+  this->window_alignment_ = alignment;
+  this->windows_lock_ = new Lock();
+  this->map_is_windowed_ = true;
+  return true;
+}
+
+// Map the part of the file from START for SIZE bytes.  The mapping
+// has to start on a page boundary, so it may begin before START.
+
+unsigned char*
+Output_file::map_window(off_t start, size_t size)
+{
+  const off_t delta = start % this->window_alignment_;
+  size_t len = size + delta;
+  if (len == 0)
+    len = 1;
+  void* base = ::mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+		      this->o_, start - delta);
+  if (base == MAP_FAILED)
+    gold_fatal(_("%s: mmap: failed to map %lu bytes of output file: %s"),
+	       this->name_, static_cast<unsigned long>(len), strerror(errno));
+  {
+    Hold_lock hl(*this->windows_lock_);
+    this->windows_[base] = len;
+  }
+  return static_cast<unsigned char*>(base) + delta;
+}
+
+// Unmap VIEW, which map_window returned for START and SIZE.  The data
+// is already in the page cache, and the kernel will write it out.
+
+void
+Output_file::unmap_window(off_t start, size_t size, unsigned char* view)
+{
+  const off_t delta = start % this->window_alignment_;
+  size_t len = size + delta;
+  if (len == 0)
+    len = 1;
+  void* base = view - delta;
+  {
+    Hold_lock hl(*this->windows_lock_);
+    std::map<void*, size_t>::iterator p = this->windows_.find(base);
+    gold_assert(p != this->windows_.end() && p->second == len);
+    this->windows_.erase(p);
+  }
+  if (::munmap(base, len) < 0)
+    gold_error(_("%s: munmap: %s"), this->name_, strerror(errno));
+}
+
 // Map the file into memory.
 
 void
 Output_file::map()
 {
+  // An incremental update reads and writes the whole file through
+  // base_, so it can not use windows.
+  if (parameters->options().mmap_output_file()
+      && parameters->options().mmap_output_windows()
+      && !parameters->incremental()
+      && this->map_windowed())
+    return;
+
   if (parameters->options().mmap_output_file()
       && this->map_no_anonymous(true))
     return;
@@ -5234,6 +5405,19 @@ Output_file::unmap()
       // We've already written out the data, so there is no reason to
       // waste time unmapping or freeing the memory.
     }
+  else if (this->map_is_windowed_)
+    {
+      // Each view is normally unmapped when it is written.  Unmap
+      // any views which a caller did not give back.
+      Hold_lock hl(*this->windows_lock_);
+      for (std::map<void*, size_t>::const_iterator p =
+	     this->windows_.begin();
+	   p != this->windows_.end();
+	   ++p)
+	if (::munmap(p->first, p->second) < 0)
+	  gold_error(_("%s: munmap: %s"), this->name_, strerror(errno));
+      this->windows_.clear();
+    }
   else
     {
       if (::munmap(this->base_, this->file_size_) < 0)
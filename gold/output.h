@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <list>
+#include <map>
 #include <vector>
 
 #include "elfcpp.h"
@@ -94,13 +95,22 @@ class Output_file
   filename()
   { return this->name_; }
 
-  // We currently always use mmap which makes the view handling quite
-  // simple.  In the future we may support other approaches.
+  // We normally map the whole file, which makes the view handling
+  // quite simple.  With --mmap-output-windows, each view is a
+  // separate shared mapping of just the part of the file it covers,
+  // which is unmapped when the view is written, or when the file is
+  // closed if the view is never written.  Because all the
+  // mappings share the page cache, views which overlap see each
+  // other's changes, just as they would with a single mapping.
 
   // Write data to the output file.
   void
   write(off_t offset, const void* data, size_t len)
-  { memcpy(this->base_ + offset, data, len); }
+  {
+    unsigned char* view = this->get_output_view(offset, len);
+    memcpy(view, data, len);
+    this->write_output_view(offset, len, view);
+  }
 
   // Get a buffer to use to write to the file, given the offset into
   // the file and the size.
@@ -109,14 +119,19 @@ class Output_file
   {
     gold_assert(start >= 0
 		&& start + static_cast<off_t>(size) <= this->file_size_);
+    if (this->map_is_windowed_)
+      return this->map_window(start, size);
     return this->base_ + start;
   }
 
   // VIEW must have been returned by get_output_view.  Write the
   // buffer to the file, passing in the offset and the size.
   void
-  write_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_output_view(off_t start, size_t size, unsigned char* view)
+  {
+    if (this->map_is_windowed_)
+      this->unmap_window(start, size, view);
+  }
 
   // Get a read/write buffer.  This is used when we want to write part
   // of the file, read it in, and write it again.
@@ -126,8 +141,8 @@ class Output_file
 
   // Write a read/write buffer back to the file.
   void
-  write_input_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_input_output_view(off_t start, size_t size, unsigned char* view)
+  { this->write_output_view(start, size, view); }
 
   // Get a read buffer.  This is used when we just want to read part
   // of the file back it in.
@@ -137,8 +152,8 @@ class Output_file
 
   // Release a read bfufer.
   void
-  free_input_view(off_t, size_t, const unsigned char*)
-  { }
+  free_input_view(off_t start, size_t size, const unsigned char* view)
+  { this->write_output_view(start, size, const_cast<unsigned char*>(view)); }
 
  private:
   // Map the file into memory or, if that fails, allocate anonymous
@@ -154,6 +169,19 @@ class Output_file
   bool
   map_no_anonymous(bool);
 
+  // Arrange to map each view of the file separately.
+  bool
+  map_windowed();
+
+  // Map the part of the file from START for SIZE bytes, for
+  // --mmap-output-windows.
+  unsigned char*
+  map_window(off_t start, size_t size);
+
+  // Unmap a view returned by map_window.
+  void
+  unmap_window(off_t start, size_t size, unsigned char* view);
+
   // Unmap the file from memory (and flush to disk buffers).
   void
   unmap();
@@ -170,6 +198,17 @@ class Output_file
   bool map_is_anonymous_;
   // True if base_ was allocated using new rather than mmap.
   bool map_is_allocated_;
+  // True if base_ is not used, and each view is mapped separately.
+  bool map_is_windowed_;
+  // The alignment of the start of a window; this is the page size.
+  off_t window_alignment_;
+  // The windows which are mapped, from the start of the mapping to
+  // its length.  Protected by WINDOWS_LOCK_.
+  std::map<void*, size_t> windows_;
+  // Protects WINDOWS_, since views may be mapped and unmapped by
+  // different threads.  This is only created when map_is_windowed_
+  // is set.
+  Lock* windows_lock_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
 };
@@ -4136,6 +4175,42 @@ class Output_section : public Output_data
   input_sections()
   { return this->input_sections_; }
 
+  // A range of input sections, used to write a large section in
+  // pieces.
+  struct Input_section_range
+  {
+    // The index of the first input section in the range.
+    size_t first;
+    // The index after the last input section in the range.
+    size_t last;
+    // The file offset of the end of the input section before FIRST.
+    off_t offset;
+  };
+
+  // Return the number of bytes written by the Output_section_data
+  // objects among the input sections.  Sections from input files are
+  // written by the Relocate_task for their object, not here.
+  off_t
+  output_section_data_write_size() const;
+
+  // Divide the input sections into ranges which each write about
+  // PIECE_SIZE bytes of Output_section_data, and add them to RANGES.
+  // Calling write_input_section_range for each range and write_fills
+  // once does the same as do_write, so this may only be used for a
+  // section whose do_write is not overridden.
+  void
+  split_for_write(off_t piece_size,
+		  std::vector<Input_section_range>* ranges) const;
+
+  // Write the input sections in RANGE.
+  void
+  write_input_section_range(Output_file*, const Input_section_range&);
+
+  // Write the fills between input sections, and fill any free space
+  // left in an incremental link.
+  void
+  write_fills(Output_file*);
+
  protected:
   // Return the output section--i.e., the object itself.
   Output_section*
@@ -562,6 +562,12 @@ Plugin_manager::all_symbols_read(Workqueue* workqueue, Task* task,
        ++this->current_)
     (*this->current_)->all_symbols_read();
 
+  // The handlers may have added files from other threads, but they
+  // must have finished doing so before returning.
+  bool lock_initialized = this->initialize_lock_.initialize();
+  gold_assert(lock_initialized);
+  Hold_lock hl(*this->lock_);
+
   if (this->any_added_)
     {
       Task_token* next_blocker = new Task_token(true);
@@ -860,11 +866,20 @@ Plugin_manager::set_extra_library_path(const char* path)
   return LDPS_OK;
 }
 
-// Add a new input file.
+// Add a new input file.  This may be called by a plugin from any
+// thread while the all-symbols-read handlers are running.  We queue a
+// Read_symbols task for the file right away, so that it is read while
+// the plugin is still producing other files.  The Add_symbols tasks
+// are chained in the order in which the files were added, so that
+// symbol resolution does not depend on the timing of the threads.
 
 ld_plugin_status
 Plugin_manager::add_input_file(const char* pathname, bool is_lib)
 {
+  bool lock_initialized = this->initialize_lock_.initialize();
+  gold_assert(lock_initialized);
+  Hold_lock hl(*this->lock_);
+
   Input_file_argument file(pathname,
                            (is_lib
                             ? Input_file_argument::INPUT_FILE_TYPE_LIBRARY
@@ -1591,7 +1606,9 @@ get_symbols_v3(const void* handle, int nsyms, ld_plugin_symbol* syms)
   return plugin_obj->get_symbol_resolution_info(symtab, nsyms, syms, 3);
 }
 
-// Add a new (real) input file generated by a plugin.
+// Add a new (real) input file generated by a plugin.  Gold lets a
+// plugin call this from any of its threads while its all-symbols-read
+// handler is running; see Plugin_manager::add_input_file.
 
 static enum ld_plugin_status
 add_input_file(const char* pathname)
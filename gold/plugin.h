@@ -265,7 +265,8 @@ class Plugin_manager
   ld_plugin_status
   release_input_file(unsigned int handle);
 
-  // Add a new input file.
+  // Add a new input file.  This is thread-safe: a plugin may call
+  // it from any thread while the all-symbols-read handlers run.
   ld_plugin_status
   add_input_file(const char* pathname, bool is_lib);
 
@@ -381,6 +382,8 @@ class Plugin_manager
   // An extra directory to seach for the libraries passed by
   // add_input_library.
   std::string extra_search_path_;
+  // Lock held while claiming a file, and while adding a file for a
+  // plugin.
   Lock* lock_;
   Initialize_lock initialize_lock_;
 };
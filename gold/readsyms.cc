@@ -35,6 +35,7 @@
 #include "plugin.h"
 #include "layout.h"
 #include "incremental.h"
+#include "fileread.h"
 
 namespace gold
 {
@@ -943,4 +944,37 @@ Read_script::get_name() const
   return ret;
 }
 
+// Class Prefetch_inputs.
+
+// Prefetch every input file named on the command line.
+
+void
+Prefetch_inputs::run(Workqueue*)
+{
+  prefetch_arguments(this->cmdline_->begin(), this->cmdline_->end());
+}
+
+// Prefetch the files named by a list of input arguments, descending
+// into groups and libs.  Files found by searching the library path
+// are skipped; Read_symbols will search for them and report any
+// that are missing.
+
+template<typename Iterator>
+void
+Prefetch_inputs::prefetch_arguments(Iterator begin, Iterator end)
+{
+  for (Iterator p = begin; p != end; ++p)
+    {
+      if (p->is_file())
+	{
+	  if (!p->file().may_need_search())
+	    File_read::prefetch(p->file().name());
+	}
+      else if (p->is_lib())
+	prefetch_arguments(p->lib()->begin(), p->lib()->end());
+      else
+	prefetch_arguments(p->group()->begin(), p->group()->end());
+    }
+}
+
 } // End namespace gold.
@@ -486,6 +486,45 @@ class Read_script : public Task
   Task_token* next_blocker_;
 };
 
+// This Task starts reading all the input files named on the command
+// line, for --prefetch-inputs.  It asks the kernel to read each file
+// in the background, so that the reads of many files are in flight
+// at once rather than being issued one at a time as Read_symbols
+// gets to each file.  It does not block anything.
+
+class Prefetch_inputs : public Task
+{
+ public:
+  Prefetch_inputs(const Command_line* cmdline)
+    : cmdline_(cmdline)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Prefetch_inputs"; }
+
+ private:
+  // Prefetch the files named by the arguments in [BEGIN, END).
+  template<typename Iterator>
+  static void
+  prefetch_arguments(Iterator begin, Iterator end);
+
+  const Command_line* cmdline_;
+};
+
 } // end namespace gold
 
 #endif // !defined(GOLD_READSYMS_H)
@@ -28,7 +28,13 @@
 #include "dwarf_reader.h"
 #include "reduced_debug_output.h"
 #include "int_encoding.h"
+#include "gold-threads.h"
+#include "md5.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
 #include <vector>
 
 namespace gold
@@ -373,4 +379,2640 @@ void Output_reduced_debug_info_section::do_write(Output_file* of)
   of->write_output_view(offset, data_size, view);
 }
 
+// Debug_type_dedup methods.
+
+// The largest group of types which refer to each other that we try
+// to hash.  Hashing such a group takes time proportional to the
+// square of its size.
+
+static const size_t max_hashed_type_cycle = 256;
+
+// The largest abbreviation code we accept.  We index abbreviations
+// by code.
+
+static const uint64_t max_abbrev_code = 1 << 20;
+
+static const uint32_t no_index = -1U;
+
+// Read a ULEB128 number at *PP, which must end before END, and
+// advance *PP past it.
+
+static bool
+read_uleb(const unsigned char** pp, const unsigned char* end,
+	  uint64_t* value)
+{
+  const unsigned char* p = *pp;
+  uint64_t result = 0;
+  unsigned int shift = 0;
+  unsigned char byte;
+  do
+    {
+      if (p >= end)
+	return false;
+      byte = *p++;
+      if (shift < 64)
+	result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+    }
+  while ((byte & 0x80) != 0);
+  *pp = p;
+  *value = result;
+  return true;
+}
+
+// Skip an SLEB128 number at *PP, which must end before END.
+
+static bool
+skip_sleb(const unsigned char** pp, const unsigned char* end)
+{
+  const unsigned char* p = *pp;
+  do
+    {
+      if (p >= end)
+	return false;
+    }
+  while ((*p++ & 0x80) != 0);
+  *pp = p;
+  return true;
+}
+
+// Write VALUE at P as a ULEB128 number of exactly LEN bytes, padding
+// it if necessary.  Return false if it does not fit.
+
+static bool
+write_padded_uleb(unsigned char* p, size_t len, uint64_t value)
+{
+  for (size_t i = 0; i < len; ++i)
+    {
+      unsigned char byte = value & 0x7f;
+      value >>= 7;
+      if (i + 1 < len)
+	byte |= 0x80;
+      p[i] = byte;
+    }
+  return value == 0;
+}
+
+// Read a SIZE byte integer at P.
+
+static uint64_t
+read_sized(const unsigned char* p, unsigned int size)
+{
+  switch (size)
+    {
+    case 1:
+      return *p;
+    case 2:
+      return read_from_pointer<16>(p);
+    case 4:
+      return read_from_pointer<32>(p);
+    case 8:
+      return read_from_pointer<64>(p);
+    default:
+      gold_unreachable();
+    }
+}
+
+// Write VALUE as a SIZE byte integer at P.  Return false if it does
+// not fit.
+
+static bool
+write_sized(unsigned char* p, unsigned int size, uint64_t value)
+{
+  bool big_endian = parameters->target().is_big_endian();
+  switch (size)
+    {
+    case 1:
+      *p = value;
+      return value <= 0xff;
+    case 2:
+      if (big_endian)
+	elfcpp::Swap_unaligned<16, true>::writeval(p, value);
+      else
+	elfcpp::Swap_unaligned<16, false>::writeval(p, value);
+      return value <= 0xffff;
+    case 4:
+      if (big_endian)
+	elfcpp::Swap_unaligned<32, true>::writeval(p, value);
+      else
+	elfcpp::Swap_unaligned<32, false>::writeval(p, value);
+      return value <= 0xffffffff;
+    case 8:
+      if (big_endian)
+	elfcpp::Swap_unaligned<64, true>::writeval(p, value);
+      else
+	elfcpp::Swap_unaligned<64, false>::writeval(p, value);
+      return true;
+    default:
+      gold_unreachable();
+    }
+}
+
+// Read the value of an attribute with form FORM at *PP, which must
+// end before END, and advance *PP past it.  For a string, block or
+// expression, set *VALUE to its length and *DATA to its contents.
+// Otherwise set *VALUE to the value.  Return false if the form is not
+// supported.
+
+static bool
+read_attribute(unsigned int form, unsigned int address_size,
+	       unsigned int ref_addr_size, const unsigned char** pp,
+	       const unsigned char* end, uint64_t* value,
+	       const unsigned char** data)
+{
+  const unsigned char* p = *pp;
+  unsigned int size;
+  switch (form)
+    {
+    case elfcpp::DW_FORM_flag_present:
+      *value = 1;
+      return true;
+    case elfcpp::DW_FORM_addr:
+      size = address_size;
+      break;
+    case elfcpp::DW_FORM_ref_addr:
+      size = ref_addr_size;
+      break;
+    case elfcpp::DW_FORM_data1:
+    case elfcpp::DW_FORM_ref1:
+    case elfcpp::DW_FORM_flag:
+      size = 1;
+      break;
+    case elfcpp::DW_FORM_data2:
+    case elfcpp::DW_FORM_ref2:
+      size = 2;
+      break;
+    case elfcpp::DW_FORM_data4:
+    case elfcpp::DW_FORM_ref4:
+    case elfcpp::DW_FORM_strp:
+    case elfcpp::DW_FORM_sec_offset:
+    case elfcpp::DW_FORM_GNU_ref_alt:
+    case elfcpp::DW_FORM_GNU_strp_alt:
+      size = 4;
+      break;
+    case elfcpp::DW_FORM_data8:
+    case elfcpp::DW_FORM_ref8:
+    case elfcpp::DW_FORM_ref_sig8:
+      size = 8;
+      break;
+    case elfcpp::DW_FORM_udata:
+    case elfcpp::DW_FORM_ref_udata:
+    case elfcpp::DW_FORM_GNU_addr_index:
+    case elfcpp::DW_FORM_GNU_str_index:
+      return read_uleb(pp, end, value);
+    case elfcpp::DW_FORM_sdata:
+      *value = 0;
+      return skip_sleb(pp, end);
+    case elfcpp::DW_FORM_string:
+      {
+	const unsigned char* s = p;
+	while (p < end && *p != '\0')
+	  ++p;
+	if (p >= end)
+	  return false;
+	*data = s;
+	*value = p - s;
+	*pp = p + 1;
+	return true;
+      }
+    case elfcpp::DW_FORM_block1:
+    case elfcpp::DW_FORM_block2:
+    case elfcpp::DW_FORM_block4:
+    case elfcpp::DW_FORM_block:
+    case elfcpp::DW_FORM_exprloc:
+      {
+	uint64_t len;
+	if (form == elfcpp::DW_FORM_block1
+	    || form == elfcpp::DW_FORM_block2
+	    || form == elfcpp::DW_FORM_block4)
+	  {
+	    unsigned int len_size = (form == elfcpp::DW_FORM_block1 ? 1
+				     : form == elfcpp::DW_FORM_block2 ? 2
+				     : 4);
+	    if (p + len_size > end)
+	      return false;
+	    len = read_sized(p, len_size);
+	    p += len_size;
+	  }
+	else if (!read_uleb(&p, end, &len))
+	  return false;
+	if (len > static_cast<uint64_t>(end - p))
+	  return false;
+	*data = p;
+	*value = len;
+	*pp = p + len;
+	return true;
+      }
+    default:
+      return false;
+    }
+
+  if (size != 1 && size != 2 && size != 4 && size != 8)
+    return false;
+  if (p + size > end)
+    return false;
+  *value = read_sized(p, size);
+  *pp = p + size;
+  return true;
+}
+
+// Return whether FORM refers to a DIE in the same unit.
+
+static bool
+is_unit_ref_form(unsigned int form)
+{
+  return (form == elfcpp::DW_FORM_ref1
+	  || form == elfcpp::DW_FORM_ref2
+	  || form == elfcpp::DW_FORM_ref4
+	  || form == elfcpp::DW_FORM_ref8
+	  || form == elfcpp::DW_FORM_ref_udata);
+}
+
+// Return whether FORM is a block.
+
+static bool
+is_block_form(unsigned int form)
+{
+  return (form == elfcpp::DW_FORM_block1
+	  || form == elfcpp::DW_FORM_block2
+	  || form == elfcpp::DW_FORM_block4
+	  || form == elfcpp::DW_FORM_block);
+}
+
+// Return whether a block value of attribute ATTR is a DWARF
+// expression.
+
+static bool
+is_expression_attribute(unsigned int attr)
+{
+  switch (attr)
+    {
+    case elfcpp::DW_AT_location:
+    case elfcpp::DW_AT_byte_size:
+    case elfcpp::DW_AT_bit_size:
+    case elfcpp::DW_AT_string_length:
+    case elfcpp::DW_AT_lower_bound:
+    case elfcpp::DW_AT_return_addr:
+    case elfcpp::DW_AT_bit_stride:
+    case elfcpp::DW_AT_upper_bound:
+    case elfcpp::DW_AT_count:
+    case elfcpp::DW_AT_data_member_location:
+    case elfcpp::DW_AT_frame_base:
+    case elfcpp::DW_AT_segment:
+    case elfcpp::DW_AT_static_link:
+    case elfcpp::DW_AT_use_location:
+    case elfcpp::DW_AT_vtable_elem_location:
+    case elfcpp::DW_AT_allocated:
+    case elfcpp::DW_AT_associated:
+    case elfcpp::DW_AT_data_location:
+    case elfcpp::DW_AT_byte_stride:
+    case elfcpp::DW_AT_GNU_call_site_value:
+    case elfcpp::DW_AT_GNU_call_site_data_value:
+    case elfcpp::DW_AT_GNU_call_site_target:
+    case elfcpp::DW_AT_GNU_call_site_target_clobbered:
+      return true;
+    default:
+      return false;
+    }
+}
+
+// Return whether attribute ATTR with form FORM is an offset in
+// .debug_loc, for a unit of version VERSION.
+
+static bool
+is_loclist_attribute(unsigned int attr, unsigned int form,
+		     unsigned int version)
+{
+  if (form != elfcpp::DW_FORM_sec_offset
+      && (version >= 4 || form != elfcpp::DW_FORM_data4))
+    return false;
+  switch (attr)
+    {
+    case elfcpp::DW_AT_location:
+    case elfcpp::DW_AT_string_length:
+    case elfcpp::DW_AT_return_addr:
+    case elfcpp::DW_AT_frame_base:
+    case elfcpp::DW_AT_segment:
+    case elfcpp::DW_AT_static_link:
+    case elfcpp::DW_AT_use_location:
+    case elfcpp::DW_AT_vtable_elem_location:
+      return true;
+    case elfcpp::DW_AT_data_member_location:
+      // Before DWARF 4 this is usually a constant.
+      return form == elfcpp::DW_FORM_sec_offset;
+    default:
+      return false;
+    }
+}
+
+// Return whether TAG describes a type.  A reference to such a DIE
+// from a type we are hashing is hashed by hashing the DIE.
+
+static bool
+is_type_tag(unsigned int tag)
+{
+  switch (tag)
+    {
+    case elfcpp::DW_TAG_array_type:
+    case elfcpp::DW_TAG_class_type:
+    case elfcpp::DW_TAG_enumeration_type:
+    case elfcpp::DW_TAG_pointer_type:
+    case elfcpp::DW_TAG_reference_type:
+    case elfcpp::DW_TAG_string_type:
+    case elfcpp::DW_TAG_structure_type:
+    case elfcpp::DW_TAG_subroutine_type:
+    case elfcpp::DW_TAG_typedef:
+    case elfcpp::DW_TAG_union_type:
+    case elfcpp::DW_TAG_ptr_to_member_type:
+    case elfcpp::DW_TAG_set_type:
+    case elfcpp::DW_TAG_subrange_type:
+    case elfcpp::DW_TAG_base_type:
+    case elfcpp::DW_TAG_const_type:
+    case elfcpp::DW_TAG_file_type:
+    case elfcpp::DW_TAG_packed_type:
+    case elfcpp::DW_TAG_volatile_type:
+    case elfcpp::DW_TAG_restrict_type:
+    case elfcpp::DW_TAG_interface_type:
+    case elfcpp::DW_TAG_unspecified_type:
+    case elfcpp::DW_TAG_shared_type:
+    case elfcpp::DW_TAG_rvalue_reference_type:
+    case elfcpp::DW_TAG_atomic_type:
+      return true;
+    default:
+      return false;
+    }
+}
+
+// Return whether a DIE with TAG is a type which we may remove.  These
+// are the types large enough to be worth replacing with a reference.
+
+static bool
+is_dedup_type_tag(unsigned int tag)
+{
+  return (tag == elfcpp::DW_TAG_class_type
+	  || tag == elfcpp::DW_TAG_structure_type
+	  || tag == elfcpp::DW_TAG_union_type
+	  || tag == elfcpp::DW_TAG_enumeration_type);
+}
+
+// Return whether a type whose parent has TAG is visible outside its
+// compilation unit.
+
+static bool
+is_type_scope_tag(unsigned int tag)
+{
+  return (tag == elfcpp::DW_TAG_compile_unit
+	  || tag == elfcpp::DW_TAG_partial_unit
+	  || tag == elfcpp::DW_TAG_namespace);
+}
+
+// A reference to a DIE from an operation in a DWARF expression.
+
+struct Expr_ref
+{
+  // The offset of the operand from the start of the expression.
+  size_t operand;
+  // The size of the operand.  For a ULEB128 operand, the number of
+  // bytes it occupies.
+  unsigned int size;
+  // Whether the operand is a ULEB128 number.
+  bool is_uleb;
+  // Whether the operand is an offset from the start of the unit,
+  // rather than from the start of .debug_info.
+  bool unit_relative;
+  // The operand.
+  uint64_t value;
+};
+
+// Find the operations in the DWARF expression [P, END) which refer
+// to DIEs, and add them to REFS.  BASE is the start of the outermost
+// expression.  Return false if the expression can not be parsed.
+
+static bool
+find_expr_refs(const unsigned char* base, const unsigned char* p,
+	       const unsigned char* end, unsigned int address_size,
+	       unsigned int ref_addr_size, std::vector<Expr_ref>* refs)
+{
+  while (p < end)
+    {
+      unsigned int op = *p++;
+      unsigned int fixed = 0;
+      unsigned int ulebs = 0;
+      unsigned int slebs = 0;
+      Expr_ref ref;
+      ref.unit_relative = true;
+      ref.is_uleb = false;
+      ref.size = 0;
+      if (op >= elfcpp::DW_OP_lit0 && op <= elfcpp::DW_OP_reg31)
+	continue;
+      if (op >= elfcpp::DW_OP_breg0 && op <= elfcpp::DW_OP_breg31)
+	slebs = 1;
+      else
+	switch (op)
+	  {
+	  case elfcpp::DW_OP_deref:
+	  case elfcpp::DW_OP_dup:
+	  case elfcpp::DW_OP_drop:
+	  case elfcpp::DW_OP_over:
+	  case elfcpp::DW_OP_swap:
+	  case elfcpp::DW_OP_rot:
+	  case elfcpp::DW_OP_xderef:
+	  case elfcpp::DW_OP_abs:
+	  case elfcpp::DW_OP_and:
+	  case elfcpp::DW_OP_div:
+	  case elfcpp::DW_OP_minus:
+	  case elfcpp::DW_OP_mod:
+	  case elfcpp::DW_OP_mul:
+	  case elfcpp::DW_OP_neg:
+	  case elfcpp::DW_OP_not:
+	  case elfcpp::DW_OP_or:
+	  case elfcpp::DW_OP_plus:
+	  case elfcpp::DW_OP_shl:
+	  case elfcpp::DW_OP_shr:
+	  case elfcpp::DW_OP_shra:
+	  case elfcpp::DW_OP_xor:
+	  case elfcpp::DW_OP_eq:
+	  case elfcpp::DW_OP_ge:
+	  case elfcpp::DW_OP_gt:
+	  case elfcpp::DW_OP_le:
+	  case elfcpp::DW_OP_lt:
+	  case elfcpp::DW_OP_ne:
+	  case elfcpp::DW_OP_nop:
+	  case elfcpp::DW_OP_push_object_address:
+	  case elfcpp::DW_OP_form_tls_address:
+	  case elfcpp::DW_OP_call_frame_cfa:
+	  case elfcpp::DW_OP_stack_value:
+	  case elfcpp::DW_OP_GNU_push_tls_address:
+	  case elfcpp::DW_OP_GNU_uninit:
+	    break;
+	  case elfcpp::DW_OP_addr:
+	    fixed = address_size;
+	    break;
+	  case elfcpp::DW_OP_const1u:
+	  case elfcpp::DW_OP_const1s:
+	  case elfcpp::DW_OP_pick:
+	  case elfcpp::DW_OP_deref_size:
+	  case elfcpp::DW_OP_xderef_size:
+	    fixed = 1;
+	    break;
+	  case elfcpp::DW_OP_const2u:
+	  case elfcpp::DW_OP_const2s:
+	  case elfcpp::DW_OP_skip:
+	  case elfcpp::DW_OP_bra:
+	    fixed = 2;
+	    break;
+	  case elfcpp::DW_OP_const4u:
+	  case elfcpp::DW_OP_const4s:
+	    fixed = 4;
+	    break;
+	  case elfcpp::DW_OP_const8u:
+	  case elfcpp::DW_OP_const8s:
+	    fixed = 8;
+	    break;
+	  case elfcpp::DW_OP_constu:
+	  case elfcpp::DW_OP_plus_uconst:
+	  case elfcpp::DW_OP_regx:
+	  case elfcpp::DW_OP_piece:
+	  case elfcpp::DW_OP_GNU_addr_index:
+	  case elfcpp::DW_OP_GNU_const_index:
+	    ulebs = 1;
+	    break;
+	  case elfcpp::DW_OP_consts:
+	  case elfcpp::DW_OP_fbreg:
+	    slebs = 1;
+	    break;
+	  case elfcpp::DW_OP_bregx:
+	    ulebs = 1;
+	    slebs = 1;
+	    break;
+	  case elfcpp::DW_OP_bit_piece:
+	    ulebs = 2;
+	    break;
+	  case elfcpp::DW_OP_call2:
+	    ref.size = 2;
+	    break;
+	  case elfcpp::DW_OP_call4:
+	  case elfcpp::DW_OP_GNU_parameter_ref:
+	    ref.size = 4;
+	    break;
+	  case elfcpp::DW_OP_call_ref:
+	    ref.size = ref_addr_size;
+	    ref.unit_relative = false;
+	    break;
+	  case elfcpp::DW_OP_GNU_implicit_pointer:
+	    ref.size = ref_addr_size;
+	    ref.unit_relative = false;
+	    slebs = 1;
+	    break;
+	  case elfcpp::DW_OP_GNU_regval_type:
+	    {
+	      uint64_t reg;
+	      if (!read_uleb(&p, end, &reg))
+		return false;
+	      ref.is_uleb = true;
+	    }
+	    break;
+	  case elfcpp::DW_OP_GNU_deref_type:
+	    if (p >= end)
+	      return false;
+	    ++p;
+	    ref.is_uleb = true;
+	    break;
+	  case elfcpp::DW_OP_GNU_const_type:
+	  case elfcpp::DW_OP_GNU_convert:
+	  case elfcpp::DW_OP_GNU_reinterpret:
+	    ref.is_uleb = true;
+	    break;
+	  case elfcpp::DW_OP_implicit_value:
+	  case elfcpp::DW_OP_GNU_entry_value:
+	    {
+	      uint64_t len;
+	      if (!read_uleb(&p, end, &len)
+		  || len > static_cast<uint64_t>(end - p))
+		return false;
+	      if (op == elfcpp::DW_OP_GNU_entry_value
+		  && !find_expr_refs(base, p, p + len, address_size,
+				     ref_addr_size, refs))
+		return false;
+	      p += len;
+	    }
+	    break;
+	  default:
+	    return false;
+	  }
+
+      if (ref.size != 0 || ref.is_uleb)
+	{
+	  ref.operand = p - base;
+	  if (ref.is_uleb)
+	    {
+	      const unsigned char* start = p;
+	      if (!read_uleb(&p, end, &ref.value))
+		return false;
+	      ref.size = p - start;
+	    }
+	  else
+	    {
+	      if (ref.size > static_cast<size_t>(end - p))
+		return false;
+	      ref.value = read_sized(p, ref.size);
+	      p += ref.size;
+	    }
+	  // A type of zero means the generic type.
+	  if (!ref.is_uleb || ref.value != 0)
+	    refs->push_back(ref);
+	  if (op == elfcpp::DW_OP_GNU_const_type)
+	    {
+	      if (p >= end || *p >= static_cast<size_t>(end - p))
+		return false;
+	      p += 1 + *p;
+	    }
+	}
+
+      if (fixed > static_cast<size_t>(end - p))
+	return false;
+      p += fixed;
+      uint64_t dummy;
+      for (unsigned int i = 0; i < ulebs; ++i)
+	if (!read_uleb(&p, end, &dummy))
+	  return false;
+      for (unsigned int i = 0; i < slebs; ++i)
+	if (!skip_sleb(&p, end))
+	  return false;
+    }
+  return p == end;
+}
+
+// Find the references to DIEs in the location list at P, which must
+// end before END, and add them to REFS.  The operand offsets are
+// relative to the start of the section SECTION.  Return false if the
+// list can not be parsed.
+
+static bool
+find_loclist_refs(const unsigned char* section, const unsigned char* p,
+		  const unsigned char* end, unsigned int address_size,
+		  unsigned int ref_addr_size, std::vector<Expr_ref>* refs)
+{
+  uint64_t max_address = (address_size == 8
+			  ? static_cast<uint64_t>(-1)
+			  : 0xffffffff);
+  for (;;)
+    {
+      if (2 * address_size > static_cast<size_t>(end - p))
+	return false;
+      uint64_t begin = read_sized(p, address_size);
+      uint64_t finish = read_sized(p + address_size, address_size);
+      p += 2 * address_size;
+      if (begin == 0 && finish == 0)
+	return true;
+      if (begin == max_address)
+	continue;
+      if (end - p < 2)
+	return false;
+      size_t len = read_sized(p, 2);
+      p += 2;
+      if (len > static_cast<size_t>(end - p))
+	return false;
+      if (!find_expr_refs(section, p, p + len, address_size, ref_addr_size,
+			  refs))
+	return false;
+      p += len;
+    }
+}
+
+// Patch the references found by find_expr_refs in the copy of an
+// expression at P.  MAPPED holds the new values.  Return false if a
+// new value does not fit.
+
+static bool
+patch_expr_refs(unsigned char* p, const std::vector<Expr_ref>& refs,
+		const std::vector<uint64_t>& mapped)
+{
+  for (size_t i = 0; i < refs.size(); ++i)
+    {
+      unsigned char* op = p + refs[i].operand;
+      if (refs[i].is_uleb)
+	{
+	  if (!write_padded_uleb(op, refs[i].size, mapped[i]))
+	    return false;
+	}
+      else if (!write_sized(op, refs[i].size, mapped[i]))
+	return false;
+    }
+  return true;
+}
+
+// An abbreviation.
+
+struct Debug_type_dedup::Abbrev
+{
+  uint64_t code;
+  unsigned int tag;
+  bool has_children;
+  // The attributes and their forms.
+  std::vector<std::pair<unsigned int, unsigned int> > attributes;
+};
+
+// An abbreviation table.
+
+struct Debug_type_dedup::Abbrev_table
+{
+  Abbrev_table(uint64_t off)
+    : offset(off), end(0), max_code(0), ok(false)
+  { }
+
+  // Return the abbreviation with code CODE, or NULL.
+  const Abbrev*
+  find(uint64_t code) const
+  {
+    if (code >= this->by_code.size() || this->by_code[code] == no_index)
+      return NULL;
+    return &this->abbrevs[this->by_code[code]];
+  }
+
+  // The offset of the table in .debug_abbrev.
+  uint64_t offset;
+  // The offset of the zero which ends the table.
+  uint64_t end;
+  // The largest code in the table.
+  uint64_t max_code;
+  // The abbreviations.
+  std::vector<Abbrev> abbrevs;
+  // Indexes into abbrevs by code.
+  std::vector<uint32_t> by_code;
+  // Whether we could parse the table.
+  bool ok;
+};
+
+// A DIE.
+
+struct Debug_type_dedup::Die
+{
+  // The offset of the DIE from the start of the unit.
+  uint32_t offset;
+  // The index of the first DIE which is not a child of this one.
+  uint32_t subtree_end;
+  // The index in Unit::roots of the type which contains this DIE,
+  // or no_index.
+  uint32_t root;
+  // The abbreviation.
+  const Abbrev* abbrev;
+  // Whether the children of this DIE end with a null entry.
+  bool has_null;
+  // Whether this DIE has an expression which refers to a DIE.
+  bool has_expr_refs;
+};
+
+// A type which we may remove.
+
+struct Debug_type_dedup::Root
+{
+  // The index of the DIE.
+  uint32_t die;
+  // Whether we could hash the type.
+  bool hashable;
+  // Whether we are removing this copy of the type.
+  bool removed;
+  // The hash of the type.
+  unsigned char digest[16];
+  // If we are removing this type, the unit and DIE index of the
+  // copy we keep.
+  uint32_t canonical_unit;
+  uint32_t canonical_die;
+};
+
+// An open DIE with children, while parsing a unit: the index of the
+// DIE, the type containing it, and whether types in it are visible
+// outside the unit.
+
+struct Debug_type_dedup::Parse_frame
+{
+  uint32_t die;
+  uint32_t root;
+  bool type_scope;
+};
+
+// A unit in .debug_info.
+
+struct Debug_type_dedup::Unit
+{
+  Unit()
+    : offset(0), size(0), version(0), address_size(0), abbrev_offset(0),
+      abbrevs(NULL), end_of_dies(0), new_size(0), new_offset(0),
+      new_abbrev_offset(0)
+  { }
+
+  // The size of a DW_FORM_ref_addr value.
+  unsigned int
+  ref_addr_size() const
+  { return this->version == 2 ? this->address_size : 4; }
+
+  // Return the index of the DIE at OFFSET from the start of the unit,
+  // or no_index.
+  uint32_t
+  die_at(uint64_t die_offset) const;
+
+  // Return whether DIE number I is being removed.
+  bool
+  is_removed(uint32_t i) const
+  {
+    uint32_t root = this->dies[i].root;
+    return root != no_index && this->roots[root].removed;
+  }
+
+  // Return the digest of file number I, or NULL.
+  const unsigned char*
+  file_digest(uint64_t i) const
+  {
+    if (i >= this->file_digests.size() / 16)
+      return NULL;
+    return &this->file_digests[i * 16];
+  }
+
+  // The offset in .debug_info, and the size including the length.
+  uint64_t offset;
+  uint64_t size;
+  unsigned int version;
+  unsigned int address_size;
+  uint64_t abbrev_offset;
+  const Abbrev_table* abbrevs;
+  // The DIEs, in order.
+  std::vector<Die> dies;
+  // The types we may remove.
+  std::vector<Root> roots;
+  // The unit relative offset after the last DIE.  Anything after
+  // this is padding.
+  uint64_t end_of_dies;
+  // Hashes of the file names in the line table, 16 bytes each,
+  // indexed by file number.
+  std::vector<unsigned char> file_digests;
+  // Unit relative references to DIEs from expressions: the index of
+  // the DIE with the expression, and the offset it refers to.
+  std::vector<std::pair<uint32_t, uint64_t> > expr_refs;
+  // Location lists: the offset in .debug_loc and the index of the
+  // DIE which refers to it.
+  std::vector<std::pair<uint64_t, uint32_t> > loc_lists;
+  // The new offset of each DIE from the start of the unit.  For a
+  // DIE being removed, this is the offset of whatever follows it.
+  std::vector<uint32_t> new_offsets;
+  // The new size of the unit, including the length.
+  uint64_t new_size;
+  // The new offset of the unit in .debug_info.
+  uint64_t new_offset;
+  // The abbreviations we add for DIEs whose references we change to
+  // DW_FORM_ref_addr: each is an existing abbreviation and the
+  // indexes of the attributes we change.  The code of variant I is
+  // the largest code in the table plus I + 1.
+  std::vector<std::pair<const Abbrev*, std::vector<uint32_t> > > variants;
+  std::map<std::pair<uint64_t, std::vector<uint32_t> >, uint64_t>
+    variant_codes;
+  // If not empty, a new abbreviation table for this unit.
+  Buffer new_abbrev_table;
+  uint64_t new_abbrev_offset;
+  // If not empty, the reason we failed.
+  std::string error;
+};
+
+uint32_t
+Debug_type_dedup::Unit::die_at(uint64_t die_offset) const
+{
+  size_t lo = 0;
+  size_t hi = this->dies.size();
+  while (lo < hi)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+      if (this->dies[mid].offset < die_offset)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo < this->dies.size() && this->dies[lo].offset == die_offset)
+    return lo;
+  return no_index;
+}
+
+// Hash the types in a unit.  Each type is hashed by hashing its DIE
+// and all its children.  A reference to another type is hashed by
+// using the hash of that type.  Types which refer to each other in a
+// cycle are hashed together: each one is hashed by walking the types
+// in the cycle in a fixed order, starting from that type, so that two
+// copies of a type get the same hash only if everything they refer
+// to is the same.
+
+class Debug_type_dedup::Hasher
+{
+ public:
+  Hasher(Unit* unit, const unsigned char* info)
+    : unit_(unit), info_(info), node_of_die_(unit->dies.size(), no_index),
+      counter_(0)
+  { }
+
+  // Hash the types in Unit::roots.
+  void
+  hash_roots();
+
+ private:
+  // A DIE which we hash on its own.
+  struct Node
+  {
+    Node(uint32_t d)
+      : die(d), index(0), lowlink(0), scc(no_index), visit(no_index),
+	visited(false), on_stack(false), hashable(true)
+    { memset(this->digest, 0, sizeof this->digest); }
+
+    uint32_t die;
+    // Used to find the strongly connected components.
+    uint32_t index;
+    uint32_t lowlink;
+    // The component this node is in.
+    uint32_t scc;
+    // The order in which the node was reached while hashing its
+    // component.
+    uint32_t visit;
+    bool visited;
+    bool on_stack;
+    bool hashable;
+    unsigned char digest[16];
+    // The nodes this one refers to.
+    std::vector<uint32_t> succs;
+  };
+
+  // Return the DIE which is hashed to hash a reference to DIE I.
+  uint32_t
+  hash_root(uint32_t i) const;
+
+  // Return the node for DIE I, creating it if needed.
+  uint32_t
+  node_for(uint32_t i);
+
+  // Read the attributes of DIE I, calling VISITOR for each one.
+  template<typename Visitor>
+  bool
+  walk_attributes(uint32_t i, Visitor* visitor);
+
+  // Find the nodes that node N refers to.
+  void
+  find_succs(uint32_t n);
+
+  // Find the components starting from node N, hashing each one.
+  void
+  find_components(uint32_t n);
+
+  // Hash a component.
+  void
+  hash_component(const std::vector<uint32_t>& members, uint32_t scc);
+
+  // Append node N to BUF for hashing.
+  void
+  serialize(uint32_t n, std::string* buf, uint32_t* visits);
+
+  class Succs_visitor;
+  class Serialize_visitor;
+
+  Unit* unit_;
+  const unsigned char* info_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> node_of_die_;
+  std::vector<uint32_t> stack_;
+  uint32_t counter_;
+};
+
+uint32_t
+Debug_type_dedup::Hasher::hash_root(uint32_t i) const
+{
+  const Die& die(this->unit_->dies[i]);
+  if (die.root != no_index)
+    return this->unit_->roots[die.root].die;
+  if (is_type_tag(die.abbrev->tag))
+    return i;
+  return no_index;
+}
+
+uint32_t
+Debug_type_dedup::Hasher::node_for(uint32_t i)
+{
+  if (this->node_of_die_[i] == no_index)
+    {
+      this->node_of_die_[i] = this->nodes_.size();
+      this->nodes_.push_back(Node(i));
+    }
+  return this->node_of_die_[i];
+}
+
+// Call VISITOR->visit(ATTR, FORM, VALUE, DATA) for each attribute of
+// DIE I.  Return false if the DIE can not be read; this has already
+// been checked when the unit was parsed.
+
+template<typename Visitor>
+bool
+Debug_type_dedup::Hasher::walk_attributes(uint32_t i, Visitor* visitor)
+{
+  const Unit* unit = this->unit_;
+  const Die& die(unit->dies[i]);
+  const unsigned char* p = this->info_ + unit->offset + die.offset;
+  const unsigned char* end = this->info_ + unit->offset + unit->size;
+  uint64_t code;
+  if (!read_uleb(&p, end, &code))
+    return false;
+  const Abbrev* abbrev = die.abbrev;
+  for (size_t j = 0; j < abbrev->attributes.size(); ++j)
+    {
+      unsigned int attr = abbrev->attributes[j].first;
+      unsigned int form = abbrev->attributes[j].second;
+      uint64_t value;
+      const unsigned char* data = NULL;
+      if (!read_attribute(form, unit->address_size, unit->ref_addr_size(),
+			  &p, end, &value, &data))
+	return false;
+      if (!visitor->visit(attr, form, value, data))
+	return false;
+    }
+  return true;
+}
+
+// Collect the nodes referred to by a node.
+
+class Debug_type_dedup::Hasher::Succs_visitor
+{
+ public:
+  Succs_visitor(Hasher* hasher, uint32_t start, uint32_t end)
+    : hasher_(hasher), start_(start), end_(end)
+  { }
+
+  // Return false if the type can not be hashed.
+  bool
+  visit(unsigned int attr, unsigned int form, uint64_t value,
+	const unsigned char*)
+  {
+    const Unit* unit = this->hasher_->unit_;
+    if (form == elfcpp::DW_FORM_ref_addr
+	|| form == elfcpp::DW_FORM_GNU_addr_index
+	|| form == elfcpp::DW_FORM_GNU_str_index)
+      return false;
+    if ((attr == elfcpp::DW_AT_decl_file || attr == elfcpp::DW_AT_call_file)
+	&& !is_unit_ref_form(form)
+	&& value != 0
+	&& unit->file_digest(value) == NULL)
+      return false;
+    if (!is_unit_ref_form(form) || attr == elfcpp::DW_AT_sibling)
+      return true;
+    uint32_t t = unit->die_at(value);
+    if (t == no_index)
+      return false;
+    if (t >= this->start_ && t < this->end_)
+      return true;
+    uint32_t root = this->hasher_->hash_root(t);
+    if (root == no_index)
+      return false;
+    this->succs_.push_back(this->hasher_->node_for(root));
+    return true;
+  }
+
+  std::vector<uint32_t>*
+  succs()
+  { return &this->succs_; }
+
+ private:
+  Hasher* hasher_;
+  uint32_t start_;
+  uint32_t end_;
+  std::vector<uint32_t> succs_;
+};
+
+void
+Debug_type_dedup::Hasher::find_succs(uint32_t n)
+{
+  uint32_t start = this->nodes_[n].die;
+  uint32_t end = this->unit_->dies[start].subtree_end;
+  Succs_visitor visitor(this, start, end);
+  bool hashable = true;
+  for (uint32_t i = start; i < end && hashable; ++i)
+    {
+      if (this->unit_->dies[i].has_expr_refs
+	  || !this->walk_attributes(i, &visitor))
+	hashable = false;
+    }
+  // Note that node_for may have reallocated nodes_.
+  Node* node = &this->nodes_[n];
+  node->hashable = hashable;
+  if (hashable)
+    {
+      std::vector<uint32_t>* succs = visitor.succs();
+      std::sort(succs->begin(), succs->end());
+      succs->erase(std::unique(succs->begin(), succs->end()), succs->end());
+      node->succs.swap(*succs);
+    }
+}
+
+// Find the strongly connected components reachable from node N,
+// using Tarjan's algorithm without recursion.  Each component is
+// found after every component it refers to, so it can be hashed
+// right away.
+
+void
+Debug_type_dedup::Hasher::find_components(uint32_t n)
+{
+  std::vector<std::pair<uint32_t, size_t> > work;
+
+  this->nodes_[n].visited = true;
+  this->nodes_[n].index = this->nodes_[n].lowlink = this->counter_++;
+  this->nodes_[n].on_stack = true;
+  this->stack_.push_back(n);
+  this->find_succs(n);
+  work.push_back(std::make_pair(n, 0));
+
+  while (!work.empty())
+    {
+      uint32_t v = work.back().first;
+      size_t next = work.back().second;
+      if (next < this->nodes_[v].succs.size())
+	{
+	  ++work.back().second;
+	  uint32_t w = this->nodes_[v].succs[next];
+	  if (!this->nodes_[w].visited)
+	    {
+	      this->nodes_[w].visited = true;
+	      this->nodes_[w].index = this->nodes_[w].lowlink = this->counter_++;
+	      this->nodes_[w].on_stack = true;
+	      this->stack_.push_back(w);
+	      this->find_succs(w);
+	      work.push_back(std::make_pair(w, 0));
+	    }
+	  else if (this->nodes_[w].on_stack)
+	    this->nodes_[v].lowlink = std::min(this->nodes_[v].lowlink,
+					       this->nodes_[w].index);
+	  continue;
+	}
+
+      work.pop_back();
+      if (!work.empty())
+	{
+	  uint32_t u = work.back().first;
+	  this->nodes_[u].lowlink = std::min(this->nodes_[u].lowlink,
+					     this->nodes_[v].lowlink);
+	}
+
+      if (this->nodes_[v].lowlink == this->nodes_[v].index)
+	{
+	  std::vector<uint32_t> members;
+	  uint32_t w;
+	  do
+	    {
+	      w = this->stack_.back();
+	      this->stack_.pop_back();
+	      this->nodes_[w].on_stack = false;
+	      this->nodes_[w].scc = v;
+	      members.push_back(w);
+	    }
+	  while (w != v);
+	  this->hash_component(members, v);
+	}
+    }
+}
+
+void
+Debug_type_dedup::Hasher::hash_component(const std::vector<uint32_t>& members,
+					 uint32_t scc)
+{
+  bool hashable = members.size() <= max_hashed_type_cycle;
+  for (size_t i = 0; i < members.size() && hashable; ++i)
+    {
+      const Node& node(this->nodes_[members[i]]);
+      if (!node.hashable)
+	hashable = false;
+      for (size_t j = 0; j < node.succs.size() && hashable; ++j)
+	{
+	  const Node& succ(this->nodes_[node.succs[j]]);
+	  if (succ.scc != scc && !succ.hashable)
+	    hashable = false;
+	}
+    }
+
+  if (hashable)
+    {
+      std::string buf;
+      for (size_t i = 0; i < members.size(); ++i)
+	{
+	  uint32_t visits = 0;
+	  buf.clear();
+	  this->serialize(members[i], &buf, &visits);
+	  for (size_t j = 0; j < members.size(); ++j)
+	    this->nodes_[members[j]].visit = no_index;
+	  md5_buffer(buf.data(), buf.size(), this->nodes_[members[i]].digest);
+	}
+    }
+
+  for (size_t i = 0; i < members.size(); ++i)
+    {
+      Node* node = &this->nodes_[members[i]];
+      node->hashable = hashable;
+      std::vector<uint32_t>().swap(node->succs);
+    }
+}
+
+// Append the contents of a type to a buffer for hashing.
+
+class Debug_type_dedup::Hasher::Serialize_visitor
+{
+ public:
+  Serialize_visitor(Hasher* hasher, uint32_t start, uint32_t end,
+		    uint32_t scc, std::string* buf, uint32_t* visits)
+    : hasher_(hasher), start_(start), end_(end), scc_(scc), buf_(buf),
+      visits_(visits)
+  { }
+
+  bool
+  visit(unsigned int attr, unsigned int form, uint64_t value,
+	const unsigned char* data)
+  {
+    // A sibling reference only says where the next DIE is.
+    if (attr == elfcpp::DW_AT_sibling)
+      return true;
+    this->put(attr);
+    this->put(form);
+    const Unit* unit = this->hasher_->unit_;
+    if (is_unit_ref_form(form))
+      {
+	uint32_t t = unit->die_at(value);
+	if (t >= this->start_ && t < this->end_)
+	  {
+	    this->buf_->push_back('I');
+	    this->put(t - this->start_);
+	    return true;
+	  }
+	uint32_t root = this->hasher_->hash_root(t);
+	uint32_t n = this->hasher_->node_of_die_[root];
+	Node* node = &this->hasher_->nodes_[n];
+	if (node->scc != this->scc_)
+	  {
+	    this->buf_->push_back('R');
+	    this->buf_->append(reinterpret_cast<const char*>(node->digest),
+			       sizeof node->digest);
+	  }
+	else if (node->visit != no_index)
+	  {
+	    this->buf_->push_back('V');
+	    this->put(node->visit);
+	  }
+	else
+	  {
+	    this->buf_->push_back('S');
+	    this->hasher_->serialize(n, this->buf_, this->visits_);
+	  }
+	this->put(t - root);
+      }
+    else if ((attr == elfcpp::DW_AT_decl_file
+	      || attr == elfcpp::DW_AT_call_file)
+	     && value != 0)
+      {
+	// File numbers are indexes into the unit's line table.
+	this->buf_->push_back('F');
+	this->buf_->append(reinterpret_cast<const char*>(unit->file_digest(value)),
+			   16);
+      }
+    else if (data != NULL)
+      {
+	this->put(value);
+	this->buf_->append(reinterpret_cast<const char*>(data), value);
+      }
+    else
+      this->put(value);
+    return true;
+  }
+
+ private:
+  void
+  put(uint64_t value)
+  {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i)
+      bytes[i] = (value >> (i * 8)) & 0xff;
+    this->buf_->append(bytes, 8);
+  }
+
+  Hasher* hasher_;
+  uint32_t start_;
+  uint32_t end_;
+  uint32_t scc_;
+  std::string* buf_;
+  uint32_t* visits_;
+};
+
+void
+Debug_type_dedup::Hasher::serialize(uint32_t n, std::string* buf,
+				    uint32_t* visits)
+{
+  this->nodes_[n].visit = (*visits)++;
+  uint32_t start = this->nodes_[n].die;
+  uint32_t end = this->unit_->dies[start].subtree_end;
+  Serialize_visitor visitor(this, start, end, this->nodes_[n].scc, buf,
+			    visits);
+  for (uint32_t i = start; i < end; ++i)
+    {
+      const Die& die(this->unit_->dies[i]);
+      char header[9];
+      uint32_t tag = die.abbrev->tag;
+      uint32_t children = die.subtree_end - i;
+      memcpy(header, &tag, 4);
+      memcpy(header + 4, &children, 4);
+      header[8] = die.abbrev->has_children;
+      buf->append(header, sizeof header);
+      bool ok = this->walk_attributes(i, &visitor);
+      gold_assert(ok);
+    }
+}
+
+void
+Debug_type_dedup::Hasher::hash_roots()
+{
+  std::vector<Root>& roots(this->unit_->roots);
+  for (size_t i = 0; i < roots.size(); ++i)
+    {
+      uint32_t n = this->node_for(roots[i].die);
+      if (!this->nodes_[n].visited)
+	this->find_components(n);
+      const Node& node(this->nodes_[n]);
+      roots[i].hashable = node.hashable;
+      if (node.hashable)
+	memcpy(roots[i].digest, node.digest, sizeof roots[i].digest);
+    }
+}
+
+// Parallel_work which parses the abbreviation tables.
+
+class Debug_type_dedup::Parse_abbrevs_work : public Parallel_work
+{
+ public:
+  Parse_abbrevs_work(const std::vector<Abbrev_table*>& tables,
+		     const unsigned char* abbrev, size_t abbrev_size)
+    : tables_(tables), abbrev_(abbrev), abbrev_size_(abbrev_size)
+  { }
+
+  void
+  run_piece(size_t i);
+
+ private:
+  const std::vector<Abbrev_table*>& tables_;
+  const unsigned char* abbrev_;
+  size_t abbrev_size_;
+};
+
+void
+Debug_type_dedup::Parse_abbrevs_work::run_piece(size_t i)
+{
+  Abbrev_table* table = this->tables_[i];
+  if (table->offset >= this->abbrev_size_)
+    return;
+  const unsigned char* p = this->abbrev_ + table->offset;
+  const unsigned char* end = this->abbrev_ + this->abbrev_size_;
+  for (;;)
+    {
+      const unsigned char* start = p;
+      uint64_t code;
+      if (!read_uleb(&p, end, &code))
+	return;
+      if (code == 0)
+	{
+	  table->end = start - this->abbrev_;
+	  break;
+	}
+      Abbrev abbrev;
+      uint64_t tag;
+      abbrev.code = code;
+      if (code > max_abbrev_code
+	  || !read_uleb(&p, end, &tag)
+	  || p >= end)
+	return;
+      abbrev.tag = tag;
+      abbrev.has_children = *p++ != 0;
+      for (;;)
+	{
+	  uint64_t attr;
+	  uint64_t form;
+	  if (!read_uleb(&p, end, &attr) || !read_uleb(&p, end, &form))
+	    return;
+	  if (attr == 0 && form == 0)
+	    break;
+	  abbrev.attributes.push_back(std::make_pair(attr, form));
+	}
+      table->abbrevs.push_back(abbrev);
+      table->max_code = std::max(table->max_code, code);
+    }
+
+  table->by_code.resize(table->max_code + 1, no_index);
+  for (size_t j = 0; j < table->abbrevs.size(); ++j)
+    table->by_code[table->abbrevs[j].code] = j;
+  table->ok = true;
+}
+
+// Parallel_work which parses the units and hashes their types.
+
+class Debug_type_dedup::Parse_units_work : public Parallel_work
+{
+ public:
+  Parse_units_work(Debug_type_dedup* dedup)
+    : dedup_(dedup)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->dedup_->parse_unit(this->dedup_->units_[i]); }
+
+ private:
+  Debug_type_dedup* dedup_;
+};
+
+// Parallel_work which lays out the new units.
+
+class Debug_type_dedup::Layout_units_work : public Parallel_work
+{
+ public:
+  Layout_units_work(Debug_type_dedup* dedup)
+    : dedup_(dedup)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->dedup_->layout_unit(this->dedup_->units_[i]); }
+
+ private:
+  Debug_type_dedup* dedup_;
+};
+
+// Parallel_work which writes out the new units.
+
+class Debug_type_dedup::Write_units_work : public Parallel_work
+{
+ public:
+  Write_units_work(Debug_type_dedup* dedup)
+    : dedup_(dedup)
+  { }
+
+  void
+  run_piece(size_t i)
+  { this->dedup_->write_unit(this->dedup_->units_[i]); }
+
+ private:
+  Debug_type_dedup* dedup_;
+};
+
+Debug_type_dedup::Debug_type_dedup()
+  : done_(false), failed_(false), type_count_(0), removed_type_count_(0),
+    removed_die_count_(0), input_info_size_(0)
+{
+  for (int i = 0; i < SECTION_KIND_COUNT; ++i)
+    this->sections_[i] = NULL;
+}
+
+Debug_type_dedup::~Debug_type_dedup()
+{
+  this->clear();
+}
+
+// Free the per-unit data.
+
+void
+Debug_type_dedup::clear()
+{
+  for (std::map<uint64_t, Abbrev_table*>::iterator p =
+	 this->abbrev_tables_.begin();
+       p != this->abbrev_tables_.end();
+       ++p)
+    delete p->second;
+  this->abbrev_tables_.clear();
+  for (size_t i = 0; i < this->units_.size(); ++i)
+    delete this->units_[i];
+  this->units_.clear();
+}
+
+bool
+Debug_type_dedup::section_kind(const char* name, Section_kind* kind)
+{
+  static const struct
+  {
+    const char* name;
+    Section_kind kind;
+  } sections[] =
+  {
+    { ".debug_info", DEBUG_INFO },
+    { ".debug_abbrev", DEBUG_ABBREV },
+    { ".debug_line", DEBUG_LINE },
+    { ".debug_loc", DEBUG_LOC },
+    { ".debug_aranges", DEBUG_ARANGES },
+    { ".debug_pubnames", DEBUG_PUBNAMES },
+    { ".debug_pubtypes", DEBUG_PUBTYPES },
+    { ".debug_gnu_pubnames", DEBUG_GNU_PUBNAMES },
+    { ".debug_gnu_pubtypes", DEBUG_GNU_PUBTYPES },
+  };
+  for (size_t i = 0; i < sizeof sections / sizeof sections[0]; ++i)
+    {
+      if (strcmp(name, sections[i].name) == 0)
+	{
+	  *kind = sections[i].kind;
+	  return true;
+	}
+    }
+  return false;
+}
+
+const std::vector<unsigned char>*
+Debug_type_dedup::contents(Section_kind kind)
+{
+  this->run();
+  if (this->failed_ || this->new_contents_[kind].empty())
+    return NULL;
+  return &this->new_contents_[kind];
+}
+
+void
+Debug_type_dedup::failed(const std::string& reason)
+{
+  gold_warning(_("%s; failed to deduplicate debug types"), reason.c_str());
+  this->failed_ = true;
+  for (int i = 0; i < SECTION_KIND_COUNT; ++i)
+    Buffer().swap(this->new_contents_[i]);
+}
+
+const unsigned char*
+Debug_type_dedup::input_contents(Section_kind kind, size_t* size) const
+{
+  Output_dedup_debug_section* os = this->sections_[kind];
+  if (os == NULL)
+    {
+      *size = 0;
+      return NULL;
+    }
+  const unsigned char* contents = os->input_contents();
+  *size = os->input_size();
+  return contents;
+}
+
+// Find the units in .debug_info and their abbreviation tables.  We
+// only handle 32-bit DWARF versions 2 to 4.
+
+bool
+Debug_type_dedup::find_units()
+{
+  size_t info_size;
+  const unsigned char* info = this->input_contents(DEBUG_INFO, &info_size);
+  uint64_t offset = 0;
+  while (offset < info_size)
+    {
+      char buf[100];
+      if (info_size - offset < 11)
+	{
+	  snprintf(buf, sizeof buf,
+		   _("truncated unit at offset %#llx in .debug_info"),
+		   static_cast<unsigned long long>(offset));
+	  this->failed(buf);
+	  return false;
+	}
+      const unsigned char* p = info + offset;
+      uint64_t length = read_from_pointer<32>(p);
+      unsigned int version = read_from_pointer<16>(p + 4);
+      if (length == 0xffffffff)
+	{
+	  this->failed(_("64-bit DWARF in .debug_info is not supported"));
+	  return false;
+	}
+      if (length < 7 || length > info_size - offset - 4)
+	{
+	  snprintf(buf, sizeof buf,
+		   _("bad unit length at offset %#llx in .debug_info"),
+		   static_cast<unsigned long long>(offset));
+	  this->failed(buf);
+	  return false;
+	}
+      if (version < 2 || version > 4)
+	{
+	  snprintf(buf, sizeof buf,
+		   _("unsupported DWARF version %u in .debug_info"),
+		   version);
+	  this->failed(buf);
+	  return false;
+	}
+      Unit* unit = new Unit();
+      unit->offset = offset;
+      unit->size = length + 4;
+      unit->version = version;
+      unit->abbrev_offset = read_from_pointer<32>(p + 6);
+      unit->address_size = p[10];
+      this->units_.push_back(unit);
+      if (unit->address_size != 4 && unit->address_size != 8)
+	{
+	  this->failed(_("unsupported address size in .debug_info"));
+	  return false;
+	}
+      if (this->abbrev_tables_.find(unit->abbrev_offset)
+	  == this->abbrev_tables_.end())
+	this->abbrev_tables_[unit->abbrev_offset] =
+	  new Abbrev_table(unit->abbrev_offset);
+      offset += unit->size;
+    }
+  return true;
+}
+
+// Parse the DIEs in UNIT, and hash the types which we may remove.
+// Errors are recorded in the unit and reported later.
+
+void
+Debug_type_dedup::parse_unit(Unit* unit)
+{
+  size_t info_size;
+  const unsigned char* info = this->input_contents(DEBUG_INFO, &info_size);
+  const unsigned char* start = info + unit->offset;
+  const unsigned char* end = start + unit->size;
+  const unsigned char* p = start + 11;
+  unsigned int ref_addr_size = unit->ref_addr_size();
+
+  // The open DIEs with children.
+  std::vector<Parse_frame> stack;
+
+  uint64_t stmt_list = -1ULL;
+  unsigned int comp_dir_form = 0;
+  uint64_t comp_dir = 0;
+  const unsigned char* comp_dir_string = NULL;
+  std::vector<Expr_ref> refs;
+  bool in_padding = false;
+
+  unit->end_of_dies = unit->size;
+  while (p < end)
+    {
+      const unsigned char* entry = p;
+      uint64_t code;
+      if (!read_uleb(&p, end, &code))
+	{
+	  unit->error = _("bad abbreviation code");
+	  return;
+	}
+      if (code == 0)
+	{
+	  if (stack.empty())
+	    {
+	      if (!in_padding)
+		unit->end_of_dies = entry - start;
+	      in_padding = true;
+	      continue;
+	    }
+	  Die* parent = &unit->dies[stack.back().die];
+	  parent->has_null = true;
+	  parent->subtree_end = unit->dies.size();
+	  stack.pop_back();
+	  continue;
+	}
+      if (in_padding || (stack.empty() && !unit->dies.empty()))
+	{
+	  unit->error = _("DIE outside the unit's DIE");
+	  return;
+	}
+
+      const Abbrev* abbrev = unit->abbrevs->find(code);
+      if (abbrev == NULL)
+	{
+	  unit->error = _("unknown abbreviation code");
+	  return;
+	}
+
+      uint32_t index = unit->dies.size();
+      Die die;
+      die.offset = entry - start;
+      die.subtree_end = index + 1;
+      die.root = no_index;
+      die.abbrev = abbrev;
+      die.has_null = false;
+      die.has_expr_refs = false;
+      bool type_scope = stack.empty() || stack.back().type_scope;
+      if (!stack.empty() && stack.back().root != no_index)
+	die.root = stack.back().root;
+      else if (type_scope && !stack.empty() && is_dedup_type_tag(abbrev->tag))
+	{
+	  die.root = unit->roots.size();
+	  Root root;
+	  root.die = index;
+	  root.hashable = false;
+	  root.removed = false;
+	  root.canonical_unit = no_index;
+	  root.canonical_die = no_index;
+	  unit->roots.push_back(root);
+	}
+
+      for (size_t j = 0; j < abbrev->attributes.size(); ++j)
+	{
+	  unsigned int attr = abbrev->attributes[j].first;
+	  unsigned int form = abbrev->attributes[j].second;
+	  uint64_t value;
+	  const unsigned char* data = NULL;
+	  if (!read_attribute(form, unit->address_size, ref_addr_size, &p, end,
+			      &value, &data))
+	    {
+	      unit->error = _("unsupported attribute form");
+	      return;
+	    }
+
+	  if (index == 0)
+	    {
+	      if (attr == elfcpp::DW_AT_stmt_list
+		  && (form == elfcpp::DW_FORM_sec_offset
+		      || form == elfcpp::DW_FORM_data4))
+		stmt_list = value;
+	      else if (attr == elfcpp::DW_AT_comp_dir)
+		{
+		  comp_dir_form = form;
+		  comp_dir = value;
+		  comp_dir_string = data;
+		}
+	    }
+
+	  if (is_loclist_attribute(attr, form, unit->version))
+	    unit->loc_lists.push_back(std::make_pair(value, index));
+	  else if (form == elfcpp::DW_FORM_exprloc
+		   || (is_block_form(form) && is_expression_attribute(attr)))
+	    {
+	      refs.clear();
+	      if (!find_expr_refs(data, data, data + value,
+				  unit->address_size, ref_addr_size, &refs))
+		{
+		  unit->error = _("unsupported DWARF expression");
+		  return;
+		}
+	      if (!refs.empty())
+		die.has_expr_refs = true;
+	      for (size_t k = 0; k < refs.size(); ++k)
+		if (refs[k].unit_relative)
+		  unit->expr_refs.push_back(std::make_pair(index,
+							   refs[k].value));
+	    }
+	}
+
+      unit->dies.push_back(die);
+      if (abbrev->has_children)
+	{
+	  Parse_frame frame;
+	  frame.die = index;
+	  frame.root = die.root;
+	  frame.type_scope = type_scope && is_type_scope_tag(abbrev->tag);
+	  stack.push_back(frame);
+	}
+    }
+
+  while (!stack.empty())
+    {
+      unit->dies[stack.back().die].subtree_end = unit->dies.size();
+      stack.pop_back();
+    }
+
+  // Find the references to DIEs in location lists.
+  if (!unit->loc_lists.empty())
+    {
+      size_t loc_size;
+      const unsigned char* loc = this->input_contents(DEBUG_LOC, &loc_size);
+      for (size_t i = 0; i < unit->loc_lists.size(); ++i)
+	{
+	  uint64_t offset = unit->loc_lists[i].first;
+	  refs.clear();
+	  if (loc == NULL
+	      || offset >= loc_size
+	      || !find_loclist_refs(loc, loc + offset, loc + loc_size,
+				    unit->address_size, ref_addr_size, &refs))
+	    {
+	      unit->error = _("bad location list");
+	      return;
+	    }
+	  for (size_t k = 0; k < refs.size(); ++k)
+	    if (refs[k].unit_relative)
+	      unit->expr_refs.push_back(std::make_pair(unit->loc_lists[i].second,
+						       refs[k].value));
+	}
+    }
+
+  if (unit->roots.empty())
+    return;
+
+  if (stmt_list != -1ULL)
+    this->read_file_names(unit, stmt_list, comp_dir_form, comp_dir,
+			  comp_dir_string);
+
+  Hasher hasher(unit, info);
+  hasher.hash_roots();
+}
+
+// Read the file names from the header of the line table at offset
+// STMT_LIST in .debug_line, and store a hash of each one in the
+// unit, so that we can compare DW_AT_decl_file attributes from
+// different units.  The compilation directory is used for relative
+// names.  If we can't read the table, we leave the hashes empty, and
+// types using DW_AT_decl_file will not be removed.
+
+void
+Debug_type_dedup::read_file_names(Unit* unit, uint64_t stmt_list,
+				  unsigned int comp_dir_form,
+				  uint64_t comp_dir,
+				  const unsigned char* comp_dir_string)
+{
+  size_t line_size;
+  const unsigned char* line = this->input_contents(DEBUG_LINE, &line_size);
+  if (line == NULL || stmt_list >= line_size || line_size - stmt_list < 10)
+    return;
+  const unsigned char* p = line + stmt_list;
+  uint64_t length = read_from_pointer<32>(p);
+  if (length == 0xffffffff || length > line_size - stmt_list - 4)
+    return;
+  const unsigned char* end = p + 4 + length;
+  unsigned int version = read_from_pointer<16>(p + 4);
+  if (version < 2 || version > 4)
+    return;
+  uint64_t header_length = read_from_pointer<32>(p + 6);
+  p += 10;
+  if (header_length > static_cast<uint64_t>(end - p))
+    return;
+  end = p + header_length;
+  // Skip minimum_instruction_length, maximum_operations_per_instruction
+  // (version 4 only), default_is_stmt, line_base and line_range.
+  p += version >= 4 ? 5 : 4;
+  if (p >= end)
+    return;
+  unsigned int opcode_base = *p++;
+  if (opcode_base == 0 || opcode_base - 1 > end - p)
+    return;
+  p += opcode_base - 1;
+
+  // The key for the compilation directory.
+  std::string comp_dir_key;
+  if (comp_dir_form == elfcpp::DW_FORM_string)
+    {
+      comp_dir_key = "S";
+      comp_dir_key.append(reinterpret_cast<const char*>(comp_dir_string),
+			  comp_dir);
+    }
+  else if (comp_dir_form == elfcpp::DW_FORM_strp)
+    {
+      char buf[30];
+      snprintf(buf, sizeof buf, "P%llx",
+	       static_cast<unsigned long long>(comp_dir));
+      comp_dir_key = buf;
+    }
+
+  std::vector<std::string> dirs;
+  while (p < end && *p != '\0')
+    {
+      const unsigned char* s = p;
+      while (p < end && *p != '\0')
+	++p;
+      if (p >= end)
+	return;
+      std::string dir(reinterpret_cast<const char*>(s), p - s);
+      if (dir[0] == '/')
+	dirs.push_back("A" + dir);
+      else
+	dirs.push_back(comp_dir_key + '\0' + dir);
+      ++p;
+    }
+  if (p >= end)
+    return;
+  ++p;
+
+  // File number zero is not used before DWARF 5.
+  std::vector<unsigned char> digests(16, 0);
+  while (p < end && *p != '\0')
+    {
+      const unsigned char* s = p;
+      while (p < end && *p != '\0')
+	++p;
+      if (p >= end)
+	return;
+      std::string name(reinterpret_cast<const char*>(s), p - s);
+      ++p;
+      uint64_t dir;
+      uint64_t ignore;
+      if (!read_uleb(&p, end, &dir)
+	  || !read_uleb(&p, end, &ignore)
+	  || !read_uleb(&p, end, &ignore))
+	return;
+
+      std::string key;
+      if (name[0] == '/')
+	key = "A" + name;
+      else if (dir == 0)
+	key = comp_dir_key + '\0' + name;
+      else if (dir <= dirs.size())
+	key = dirs[dir - 1] + '\0' + name;
+      else
+	return;
+      unsigned char digest[16];
+      md5_buffer(key.data(), key.size(), digest);
+      digests.insert(digests.end(), digest, digest + 16);
+    }
+  unit->file_digests.swap(digests);
+}
+
+// Go through the types in order, and keep the first copy of each
+// one.  A later copy with the same hash in a different unit is
+// removed.  Then put back any copies which are referred to from an
+// expression by a unit relative offset, which can not refer to
+// another unit.
+
+void
+Debug_type_dedup::choose_canonical_types()
+{
+  typedef Unordered_map<std::string, std::pair<uint32_t, uint32_t> >
+    Canonical_types;
+  Canonical_types canonical;
+  for (size_t u = 0; u < this->units_.size(); ++u)
+    {
+      Unit* unit = this->units_[u];
+      this->type_count_ += unit->roots.size();
+      for (size_t r = 0; r < unit->roots.size(); ++r)
+	{
+	  Root* root = &unit->roots[r];
+	  if (!root->hashable)
+	    continue;
+	  std::string key(reinterpret_cast<const char*>(root->digest),
+			  sizeof root->digest);
+	  std::pair<Canonical_types::iterator, bool> ins =
+	    canonical.insert(std::make_pair(key, std::make_pair(u, root->die)));
+	  if (ins.second || ins.first->second.first == u)
+	    continue;
+	  root->removed = true;
+	  root->canonical_unit = ins.first->second.first;
+	  root->canonical_die = ins.first->second.second;
+	}
+    }
+
+  bool changed = true;
+  while (changed)
+    {
+      changed = false;
+      for (size_t u = 0; u < this->units_.size(); ++u)
+	{
+	  Unit* unit = this->units_[u];
+	  for (size_t i = 0; i < unit->expr_refs.size(); ++i)
+	    {
+	      if (unit->is_removed(unit->expr_refs[i].first))
+		continue;
+	      uint32_t t = unit->die_at(unit->expr_refs[i].second);
+	      if (t != no_index && unit->is_removed(t))
+		{
+		  unit->roots[unit->dies[t].root].removed = false;
+		  changed = true;
+		}
+	    }
+	}
+    }
+
+  for (size_t u = 0; u < this->units_.size(); ++u)
+    {
+      const Unit* unit = this->units_[u];
+      for (size_t r = 0; r < unit->roots.size(); ++r)
+	{
+	  const Root& root(unit->roots[r]);
+	  if (root.removed)
+	    {
+	      ++this->removed_type_count_;
+	      this->removed_die_count_ += (unit->dies[root.die].subtree_end
+					   - root.die);
+	    }
+	}
+    }
+}
+
+// Decide which references in DIE I of UNIT we change to
+// DW_FORM_ref_addr, because they refer to a DIE being removed.
+// Return the abbreviation code to use for the DIE, and set *SIZE to
+// the new size of the DIE.  This is called for the same DIE by both
+// layout_unit and write_unit.
+
+uint64_t
+Debug_type_dedup::die_layout(Unit* unit, uint32_t i, bool add_variants,
+			     uint64_t* size)
+{
+  size_t info_size;
+  const unsigned char* info = this->input_contents(DEBUG_INFO, &info_size);
+  const Die& die(unit->dies[i]);
+  const unsigned char* p = info + unit->offset + die.offset;
+  const unsigned char* end = info + unit->offset + unit->size;
+  uint64_t code = 0;
+  read_uleb(&p, end, &code);
+  const unsigned char* attrs = p;
+  unsigned int ref_addr_size = unit->ref_addr_size();
+  uint64_t grow = 0;
+  std::vector<uint32_t> changed;
+  const Abbrev* abbrev = die.abbrev;
+  for (size_t j = 0; j < abbrev->attributes.size(); ++j)
+    {
+      unsigned int attr = abbrev->attributes[j].first;
+      unsigned int form = abbrev->attributes[j].second;
+      const unsigned char* start = p;
+      uint64_t value;
+      const unsigned char* data;
+      read_attribute(form, unit->address_size, ref_addr_size, &p, end,
+		     &value, &data);
+      if (is_unit_ref_form(form))
+	{
+	  uint32_t t = unit->die_at(value);
+	  if (t == no_index)
+	    {
+	      unit->error = _("reference to an offset which is not a DIE");
+	      *size = 0;
+	      return code;
+	    }
+	  if (attr != elfcpp::DW_AT_sibling && unit->is_removed(t))
+	    {
+	      changed.push_back(j);
+	      grow += ref_addr_size - (p - start);
+	    }
+	}
+    }
+
+  if (!changed.empty())
+    {
+      std::pair<uint64_t, std::vector<uint32_t> > key(code, changed);
+      std::map<std::pair<uint64_t, std::vector<uint32_t> >,
+	       uint64_t>::const_iterator q = unit->variant_codes.find(key);
+      if (q != unit->variant_codes.end())
+	code = q->second;
+      else
+	{
+	  gold_assert(add_variants);
+	  unit->variants.push_back(std::make_pair(abbrev, changed));
+	  uint64_t new_code = unit->abbrevs->max_code + unit->variants.size();
+	  unit->variant_codes[key] = new_code;
+	  code = new_code;
+	}
+    }
+
+  *size = get_length_as_unsigned_LEB_128(code) + (p - attrs) + grow;
+  return code;
+}
+
+// Compute the new offset of each DIE in UNIT, and its new size.
+
+void
+Debug_type_dedup::layout_unit(Unit* unit)
+{
+  uint32_t count = unit->dies.size();
+  unit->new_offsets.resize(count);
+  std::vector<uint32_t> stack;
+  uint64_t offset = 11;
+  uint32_t i = 0;
+  while (i < count)
+    {
+      while (!stack.empty() && unit->dies[stack.back()].subtree_end <= i)
+	{
+	  offset += unit->dies[stack.back()].has_null ? 1 : 0;
+	  stack.pop_back();
+	}
+      const Die& die(unit->dies[i]);
+      if (unit->is_removed(i))
+	{
+	  for (uint32_t j = i; j < die.subtree_end; ++j)
+	    unit->new_offsets[j] = offset;
+	  i = die.subtree_end;
+	  continue;
+	}
+      if (offset > 0xffffffff)
+	{
+	  unit->error = _("unit too large");
+	  return;
+	}
+      unit->new_offsets[i] = offset;
+      uint64_t size;
+      this->die_layout(unit, i, true, &size);
+      if (!unit->error.empty())
+	return;
+      offset += size;
+      if (die.abbrev->has_children)
+	stack.push_back(i);
+      ++i;
+    }
+  while (!stack.empty())
+    {
+      offset += unit->dies[stack.back()].has_null ? 1 : 0;
+      stack.pop_back();
+    }
+  offset += unit->size - unit->end_of_dies;
+  unit->new_size = offset;
+
+  if (unit->variants.empty())
+    return;
+
+  // Copy the old abbreviation table and add the new abbreviations.
+  size_t abbrev_size;
+  const unsigned char* abbrev = this->input_contents(DEBUG_ABBREV,
+						     &abbrev_size);
+  Buffer* table = &unit->new_abbrev_table;
+  table->assign(abbrev + unit->abbrevs->offset, abbrev + unit->abbrevs->end);
+  for (size_t v = 0; v < unit->variants.size(); ++v)
+    {
+      const Abbrev* a = unit->variants[v].first;
+      const std::vector<uint32_t>& changed(unit->variants[v].second);
+      write_unsigned_LEB_128(table, unit->abbrevs->max_code + v + 1);
+      write_unsigned_LEB_128(table, a->tag);
+      table->push_back(a->has_children ? 1 : 0);
+      size_t c = 0;
+      for (size_t j = 0; j < a->attributes.size(); ++j)
+	{
+	  unsigned int form = a->attributes[j].second;
+	  if (c < changed.size() && changed[c] == j)
+	    {
+	      form = elfcpp::DW_FORM_ref_addr;
+	      ++c;
+	    }
+	  write_unsigned_LEB_128(table, a->attributes[j].first);
+	  write_unsigned_LEB_128(table, form);
+	}
+      table->push_back(0);
+      table->push_back(0);
+    }
+  table->push_back(0);
+}
+
+// Write out the new contents of UNIT.
+
+void
+Debug_type_dedup::write_unit(Unit* unit)
+{
+  size_t info_size;
+  const unsigned char* info = this->input_contents(DEBUG_INFO, &info_size);
+  const unsigned char* start = info + unit->offset;
+  const unsigned char* end = start + unit->size;
+  unsigned char* out = &this->new_contents_[DEBUG_INFO][unit->new_offset];
+  unsigned int ref_addr_size = unit->ref_addr_size();
+
+  write_sized(out, 4, unit->new_size - 4);
+  write_sized(out + 4, 2, unit->version);
+  write_sized(out + 6, 4, unit->new_abbrev_offset);
+  out[10] = unit->address_size;
+
+  uint32_t count = unit->dies.size();
+  std::vector<uint32_t> stack;
+  std::vector<Expr_ref> refs;
+  std::vector<uint64_t> mapped;
+  std::vector<unsigned char> code_bytes;
+  uint64_t offset = 11;
+  uint32_t i = 0;
+  while (i < count)
+    {
+      while (!stack.empty() && unit->dies[stack.back()].subtree_end <= i)
+	{
+	  if (unit->dies[stack.back()].has_null)
+	    out[offset++] = 0;
+	  stack.pop_back();
+	}
+      const Die& die(unit->dies[i]);
+      if (unit->is_removed(i))
+	{
+	  i = die.subtree_end;
+	  continue;
+	}
+      gold_assert(offset == unit->new_offsets[i]);
+
+      uint64_t size;
+      uint64_t code = this->die_layout(unit, i, false, &size);
+      unsigned char* die_out = out + offset;
+      code_bytes.clear();
+      write_unsigned_LEB_128(&code_bytes, code);
+      memcpy(die_out, &code_bytes[0], code_bytes.size());
+      unsigned char* q = die_out + code_bytes.size();
+
+      const unsigned char* p = start + die.offset;
+      uint64_t old_code;
+      read_uleb(&p, end, &old_code);
+      const Abbrev* abbrev = die.abbrev;
+      for (size_t j = 0; j < abbrev->attributes.size(); ++j)
+	{
+	  unsigned int attr = abbrev->attributes[j].first;
+	  unsigned int form = abbrev->attributes[j].second;
+	  const unsigned char* value_start = p;
+	  uint64_t value;
+	  const unsigned char* data = NULL;
+	  read_attribute(form, unit->address_size, ref_addr_size, &p, end,
+			 &value, &data);
+	  size_t len = p - value_start;
+
+	  if (is_unit_ref_form(form))
+	    {
+	      uint32_t t = unit->die_at(value);
+	      if (attr != elfcpp::DW_AT_sibling && unit->is_removed(t))
+		{
+		  uint64_t target;
+		  this->map_offset(unit->offset + value, true, &target);
+		  if (!write_sized(q, ref_addr_size, target))
+		    unit->error = _("reference does not fit");
+		  q += ref_addr_size;
+		  continue;
+		}
+	      bool fits;
+	      if (form == elfcpp::DW_FORM_ref_udata)
+		fits = write_padded_uleb(q, len, unit->new_offsets[t]);
+	      else
+		fits = write_sized(q, len, unit->new_offsets[t]);
+	      if (!fits)
+		unit->error = _("reference does not fit");
+	    }
+	  else if (form == elfcpp::DW_FORM_ref_addr)
+	    {
+	      uint64_t target;
+	      if (!this->map_offset(value, true, &target)
+		  || !write_sized(q, len, target))
+		unit->error = _("bad DW_FORM_ref_addr reference");
+	    }
+	  else
+	    {
+	      memcpy(q, value_start, len);
+	      if (die.has_expr_refs
+		  && (form == elfcpp::DW_FORM_exprloc
+		      || (is_block_form(form) && is_expression_attribute(attr))))
+		{
+		  refs.clear();
+		  find_expr_refs(data, data, data + value, unit->address_size,
+				 ref_addr_size, &refs);
+		  if (!this->map_expr_refs(unit, refs, &mapped)
+		      || !patch_expr_refs(q + (data - value_start), refs,
+					  mapped))
+		    unit->error = _("bad reference in DWARF expression");
+		}
+	    }
+	  q += len;
+	}
+      gold_assert(static_cast<uint64_t>(q - die_out) == size);
+      offset += size;
+      if (die.abbrev->has_children)
+	stack.push_back(i);
+      ++i;
+    }
+  while (!stack.empty())
+    {
+      if (unit->dies[stack.back()].has_null)
+	out[offset++] = 0;
+      stack.pop_back();
+    }
+  memset(out + offset, 0, unit->size - unit->end_of_dies);
+  offset += unit->size - unit->end_of_dies;
+  gold_assert(offset == unit->new_size);
+}
+
+// Set *MAPPED to the new values of the references to DIEs REFS found
+// in an expression in UNIT.
+
+bool
+Debug_type_dedup::map_expr_refs(const Unit* unit,
+				const std::vector<Expr_ref>& refs,
+				std::vector<uint64_t>* mapped) const
+{
+  mapped->clear();
+  for (size_t i = 0; i < refs.size(); ++i)
+    {
+      uint64_t value;
+      if (refs[i].unit_relative)
+	{
+	  uint32_t t = unit->die_at(refs[i].value);
+	  if (t == no_index || unit->is_removed(t))
+	    return false;
+	  value = unit->new_offsets[t];
+	}
+      else if (!this->map_offset(refs[i].value, true, &value))
+	return false;
+      mapped->push_back(value);
+    }
+  return true;
+}
+
+const Debug_type_dedup::Unit*
+Debug_type_dedup::find_unit(uint64_t offset) const
+{
+  size_t lo = 0;
+  size_t hi = this->units_.size();
+  while (lo < hi)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+      const Unit* unit = this->units_[mid];
+      if (offset < unit->offset)
+	hi = mid;
+      else if (offset >= unit->offset + unit->size)
+	lo = mid + 1;
+      else
+	return unit;
+    }
+  return NULL;
+}
+
+bool
+Debug_type_dedup::map_offset(uint64_t offset, bool follow_removed,
+			     uint64_t* new_offset) const
+{
+  const Unit* unit = this->find_unit(offset);
+  if (unit == NULL)
+    return false;
+  if (offset == unit->offset)
+    {
+      *new_offset = unit->new_offset;
+      return true;
+    }
+  uint32_t i = unit->die_at(offset - unit->offset);
+  if (i == no_index)
+    return false;
+  if (follow_removed && unit->is_removed(i))
+    {
+      const Root& root(unit->roots[unit->dies[i].root]);
+      const Unit* canonical = this->units_[root.canonical_unit];
+      uint32_t j = root.canonical_die + (i - root.die);
+      *new_offset = canonical->new_offset + canonical->new_offsets[j];
+    }
+  else
+    *new_offset = unit->new_offset + unit->new_offsets[i];
+  return true;
+}
+
+// Rewrite the references to DIEs in the location lists.  The
+// expressions keep their size, so only the operands change.
+
+bool
+Debug_type_dedup::rewrite_loc()
+{
+  size_t loc_size;
+  const unsigned char* loc = this->input_contents(DEBUG_LOC, &loc_size);
+  if (loc == NULL || loc_size == 0)
+    return true;
+  Buffer* out = &this->new_contents_[DEBUG_LOC];
+  out->assign(loc, loc + loc_size);
+
+  std::set<uint64_t> done;
+  std::vector<Expr_ref> refs;
+  std::vector<uint64_t> mapped;
+  for (size_t u = 0; u < this->units_.size(); ++u)
+    {
+      const Unit* unit = this->units_[u];
+      for (size_t i = 0; i < unit->loc_lists.size(); ++i)
+	{
+	  uint64_t offset = unit->loc_lists[i].first;
+	  if (unit->is_removed(unit->loc_lists[i].second)
+	      || !done.insert(offset).second)
+	    continue;
+	  refs.clear();
+	  find_loclist_refs(loc, loc + offset, loc + loc_size,
+			    unit->address_size, unit->ref_addr_size(), &refs);
+	  if (!this->map_expr_refs(unit, refs, &mapped)
+	      || !patch_expr_refs(&(*out)[0], refs, mapped))
+	    return false;
+	}
+    }
+  return true;
+}
+
+// Rewrite the offsets of the units in .debug_aranges.
+
+bool
+Debug_type_dedup::rewrite_aranges()
+{
+  size_t aranges_size;
+  const unsigned char* aranges = this->input_contents(DEBUG_ARANGES,
+						      &aranges_size);
+  if (aranges == NULL || aranges_size == 0)
+    return true;
+  Buffer* out = &this->new_contents_[DEBUG_ARANGES];
+  out->assign(aranges, aranges + aranges_size);
+
+  size_t offset = 0;
+  while (offset < aranges_size)
+    {
+      if (aranges_size - offset < 10)
+	return false;
+      uint64_t length = read_from_pointer<32>(aranges + offset);
+      if (length == 0xffffffff || length > aranges_size - offset - 4)
+	return false;
+      uint64_t info_offset = read_from_pointer<32>(aranges + offset + 6);
+      const Unit* unit = this->find_unit(info_offset);
+      if (unit == NULL || unit->offset != info_offset)
+	return false;
+      write_sized(&(*out)[offset + 6], 4, unit->new_offset);
+      offset += length + 4;
+    }
+  return true;
+}
+
+// Rewrite .debug_pubnames or a similar section.  We drop the entries
+// for DIEs which we removed; the copy we kept has its own entry.
+
+bool
+Debug_type_dedup::rewrite_pubnames(Section_kind kind)
+{
+  size_t size;
+  const unsigned char* contents = this->input_contents(kind, &size);
+  if (contents == NULL || size == 0)
+    return true;
+  bool gnu = kind == DEBUG_GNU_PUBNAMES || kind == DEBUG_GNU_PUBTYPES;
+  Buffer* out = &this->new_contents_[kind];
+
+  size_t offset = 0;
+  while (offset < size)
+    {
+      if (size - offset < 14)
+	return false;
+      const unsigned char* p = contents + offset;
+      uint64_t length = read_from_pointer<32>(p);
+      if (length == 0xffffffff || length < 10 || length > size - offset - 4)
+	return false;
+      const unsigned char* end = p + 4 + length;
+      unsigned int version = read_from_pointer<16>(p + 4);
+      uint64_t info_offset = read_from_pointer<32>(p + 6);
+      const Unit* unit = this->find_unit(info_offset);
+      if (unit == NULL || unit->offset != info_offset)
+	return false;
+
+      size_t set_start = out->size();
+      out->resize(set_start + 14);
+      write_sized(&(*out)[set_start + 4], 2, version);
+      write_sized(&(*out)[set_start + 6], 4, unit->new_offset);
+      write_sized(&(*out)[set_start + 10], 4, unit->new_size);
+
+      p += 14;
+      for (;;)
+	{
+	  if (end - p < 4)
+	    return false;
+	  uint64_t die_offset = read_from_pointer<32>(p);
+	  p += 4;
+	  if (die_offset == 0)
+	    break;
+	  const unsigned char* entry = p;
+	  if (gnu)
+	    ++p;
+	  while (p < end && *p != '\0')
+	    ++p;
+	  if (p >= end)
+	    return false;
+	  ++p;
+	  uint32_t i = unit->die_at(die_offset);
+	  if (i == no_index)
+	    return false;
+	  if (unit->is_removed(i))
+	    continue;
+	  insert_into_vector<32>(out, unit->new_offsets[i]);
+	  out->insert(out->end(), entry, p);
+	}
+      insert_into_vector<32>(out, 0);
+      write_sized(&(*out)[set_start], 4, out->size() - set_start - 4);
+      offset += length + 4;
+    }
+  return true;
+}
+
+// Do the work.
+
+void
+Debug_type_dedup::run()
+{
+  if (this->done_)
+    return;
+  this->done_ = true;
+
+  size_t info_size;
+  size_t abbrev_size;
+  const unsigned char* info = this->input_contents(DEBUG_INFO, &info_size);
+  const unsigned char* abbrev = this->input_contents(DEBUG_ABBREV,
+						     &abbrev_size);
+  this->input_info_size_ = info_size;
+
+  // Collect the input contents of the other sections now, since they
+  // are read by several threads below.
+  for (int i = 0; i < SECTION_KIND_COUNT; ++i)
+    if (this->sections_[i] != NULL)
+      this->sections_[i]->input_contents();
+
+  if (info == NULL || abbrev == NULL || info_size == 0)
+    {
+      this->failed_ = true;
+      return;
+    }
+
+  if (!this->find_units())
+    {
+      this->clear();
+      return;
+    }
+
+  std::vector<Abbrev_table*> tables;
+  for (std::map<uint64_t, Abbrev_table*>::const_iterator p =
+	 this->abbrev_tables_.begin();
+       p != this->abbrev_tables_.end();
+       ++p)
+    tables.push_back(p->second);
+  Parse_abbrevs_work parse_abbrevs(tables, abbrev, abbrev_size);
+  run_parallel_work(&parse_abbrevs, tables.size());
+  for (size_t i = 0; i < tables.size(); ++i)
+    {
+      if (!tables[i]->ok)
+	{
+	  this->failed(_("bad abbreviation table in .debug_abbrev"));
+	  this->clear();
+	  return;
+	}
+    }
+  for (size_t i = 0; i < this->units_.size(); ++i)
+    this->units_[i]->abbrevs = this->abbrev_tables_[this->units_[i]->abbrev_offset];
+
+  Parse_units_work parse_units(this);
+  run_parallel_work(&parse_units, this->units_.size());
+  if (!this->check_units())
+    return;
+
+  this->choose_canonical_types();
+  if (this->removed_type_count_ == 0)
+    {
+      // Nothing to do; write out the sections unchanged.
+      this->failed_ = true;
+      this->clear();
+      return;
+    }
+
+  Layout_units_work layout_units(this);
+  run_parallel_work(&layout_units, this->units_.size());
+  if (!this->check_units())
+    return;
+
+  // Assign the new offsets of the units.  Units which need new
+  // abbreviations share a table if they need the same one.
+  Buffer* new_abbrev = &this->new_contents_[DEBUG_ABBREV];
+  new_abbrev->assign(abbrev, abbrev + abbrev_size);
+  std::map<Buffer, uint64_t> new_tables;
+  uint64_t offset = 0;
+  for (size_t i = 0; i < this->units_.size(); ++i)
+    {
+      Unit* unit = this->units_[i];
+      unit->new_offset = offset;
+      offset += unit->new_size;
+      if (unit->new_abbrev_table.empty())
+	unit->new_abbrev_offset = unit->abbrev_offset;
+      else
+	{
+	  std::pair<std::map<Buffer, uint64_t>::iterator, bool> ins =
+	    new_tables.insert(std::make_pair(unit->new_abbrev_table,
+					     new_abbrev->size()));
+	  if (ins.second)
+	    new_abbrev->insert(new_abbrev->end(),
+			       unit->new_abbrev_table.begin(),
+			       unit->new_abbrev_table.end());
+	  unit->new_abbrev_offset = ins.first->second;
+	  Buffer().swap(unit->new_abbrev_table);
+	}
+    }
+  if (offset > 0xffffffff || new_abbrev->size() > 0xffffffff)
+    {
+      this->failed(_(".debug_info too large"));
+      this->clear();
+      return;
+    }
+
+  this->new_contents_[DEBUG_INFO].resize(offset);
+  Write_units_work write_units(this);
+  run_parallel_work(&write_units, this->units_.size());
+  if (!this->check_units())
+    return;
+
+  if (!this->rewrite_loc())
+    this->failed(_("bad location list in .debug_loc"));
+  else if (!this->rewrite_aranges())
+    this->failed(_("bad .debug_aranges section"));
+  else
+    {
+      static const Section_kind pubnames[] =
+      {
+	DEBUG_PUBNAMES, DEBUG_PUBTYPES, DEBUG_GNU_PUBNAMES, DEBUG_GNU_PUBTYPES
+      };
+      for (size_t i = 0; i < sizeof pubnames / sizeof pubnames[0]; ++i)
+	{
+	  if (!this->rewrite_pubnames(pubnames[i]))
+	    {
+	      this->failed(std::string(_("bad section "))
+			   + this->sections_[pubnames[i]]->name());
+	      break;
+	    }
+	}
+    }
+
+  this->clear();
+}
+
+// Report the first error recorded in a unit, if any.
+
+bool
+Debug_type_dedup::check_units()
+{
+  for (size_t i = 0; i < this->units_.size(); ++i)
+    {
+      const Unit* unit = this->units_[i];
+      if (!unit->error.empty())
+	{
+	  char buf[50];
+	  snprintf(buf, sizeof buf, _(" in unit at offset %#llx in .debug_info"),
+		   static_cast<unsigned long long>(unit->offset));
+	  this->failed(unit->error + buf);
+	  this->clear();
+	  return false;
+	}
+    }
+  return true;
+}
+
+// Print statistics for --stats.
+
+void
+Debug_type_dedup::print_stats() const
+{
+  fprintf(stderr, _("%s: debug types: %llu\n"), program_name,
+	  static_cast<unsigned long long>(this->type_count_));
+  if (this->failed_)
+    return;
+  fprintf(stderr, _("%s: debug types removed: %llu (%llu DIEs)\n"),
+	  program_name,
+	  static_cast<unsigned long long>(this->removed_type_count_),
+	  static_cast<unsigned long long>(this->removed_die_count_));
+  fprintf(stderr, _("%s: .debug_info size: %llu (was %llu)\n"),
+	  program_name,
+	  static_cast<unsigned long long>(
+	    this->new_contents_[DEBUG_INFO].size()),
+	  static_cast<unsigned long long>(this->input_info_size_));
+}
+
+// Output_dedup_debug_section methods.
+
+const unsigned char*
+Output_dedup_debug_section::input_contents()
+{
+  if (!this->buffer_written_)
+    {
+      // At this point the contents of all regular input sections have
+      // been copied into the postprocessing buffer, and relocations
+      // have been applied.  Copy in anything else.
+      this->input_size_ = this->postprocessing_buffer_size();
+      this->write_to_postprocessing_buffer();
+      this->buffer_written_ = true;
+    }
+  return this->postprocessing_buffer();
+}
+
+void
+Output_dedup_debug_section::set_final_data_size()
+{
+  this->input_contents();
+  this->contents_ = this->dedup_->contents(this->kind_);
+  if (this->contents_ != NULL)
+    this->set_data_size(this->contents_->size());
+  else
+    this->set_data_size(this->input_size_);
+}
+
+void
+Output_dedup_debug_section::do_write(Output_file* of)
+{
+  off_t offset = this->offset();
+  off_t data_size = this->data_size();
+  unsigned char* view = of->get_output_view(offset, data_size);
+  if (this->contents_ != NULL)
+    memcpy(view, &this->contents_->front(), data_size);
+  else
+    memcpy(view, this->postprocessing_buffer(), data_size);
+  of->write_output_view(offset, data_size, view);
+}
+
 } // End namespace gold.
@@ -26,11 +26,18 @@
 // classes remove all debug information entries from the .debug_info section
 // except for those describing compilation units as these DIEs contain
 // references to the debug line information needed by most parsers.
+//
+// With --dedup-debug-types we instead keep all the debug information,
+// but emit only one copy of each type described in more than one
+// compilation unit.  The other copies are removed from .debug_info,
+// and references to them are turned into DW_FORM_ref_addr references
+// to the copy that we keep.
 
 #ifndef GOLD_REDUCED_DEBUG_OUTPUT_H
 #define GOLD_REDUCED_DEBUG_OUTPUT_H
 
 #include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -135,6 +142,222 @@ class Output_reduced_debug_info_section : public Output_section
   bool failed_;
 };
 
+class Output_dedup_debug_section;
+struct Expr_ref;
+
+// This class removes duplicate type DIEs from .debug_info.  It works
+// on the final contents of the debug sections, after relocations
+// have been applied, and rewrites .debug_info and the sections which
+// refer to offsets in it.  Each of those sections is an
+// Output_dedup_debug_section which asks this class for its new
+// contents.
+
+class Debug_type_dedup
+{
+ public:
+  // The debug sections which we read or rewrite.
+  enum Section_kind
+  {
+    DEBUG_INFO,
+    DEBUG_ABBREV,
+    DEBUG_LINE,
+    DEBUG_LOC,
+    DEBUG_ARANGES,
+    DEBUG_PUBNAMES,
+    DEBUG_PUBTYPES,
+    DEBUG_GNU_PUBNAMES,
+    DEBUG_GNU_PUBTYPES,
+    SECTION_KIND_COUNT
+  };
+
+  Debug_type_dedup();
+
+  ~Debug_type_dedup();
+
+  // If NAME is the name of a section handled by this class, set
+  // *KIND and return true.
+  static bool
+  section_kind(const char* name, Section_kind* kind);
+
+  // Record the output section for KIND.
+  void
+  set_section(Section_kind kind, Output_dedup_debug_section* os)
+  { this->sections_[kind] = os; }
+
+  // Return the new contents of the section for KIND, or NULL if the
+  // section should be written out unchanged.
+  const std::vector<unsigned char>*
+  contents(Section_kind kind);
+
+  // Print statistics for --stats.
+  void
+  print_stats() const;
+
+ private:
+  struct Abbrev;
+  struct Abbrev_table;
+  struct Die;
+  struct Root;
+  struct Unit;
+  struct Parse_frame;
+  class Hasher;
+  class Parse_abbrevs_work;
+  class Parse_units_work;
+  class Layout_units_work;
+  class Write_units_work;
+
+  typedef std::vector<unsigned char> Buffer;
+
+  // Do the work, the first time any section asks for its contents.
+  void
+  run();
+
+  // Issue a warning and fall back to writing out the sections
+  // unchanged.
+  void
+  failed(const std::string& reason);
+
+  // If any unit recorded an error, report it and return false.
+  bool
+  check_units();
+
+  // Free the units and abbreviation tables.
+  void
+  clear();
+
+  // Return the contents of the section for KIND, with relocations
+  // applied, and set *SIZE.  Return NULL if there is no such section.
+  const unsigned char*
+  input_contents(Section_kind kind, size_t* size) const;
+
+  // Split .debug_info into units.
+  bool
+  find_units();
+
+  // Parse the DIEs of a unit and hash its types.  This runs in
+  // parallel for different units.
+  void
+  parse_unit(Unit*);
+
+  // Parse the line table header of a unit to find its file names.
+  void
+  read_file_names(Unit*, uint64_t stmt_list, unsigned int comp_dir_form,
+		  uint64_t comp_dir, const unsigned char* comp_dir_string);
+
+  // Pick the copy of each type to keep.
+  void
+  choose_canonical_types();
+
+  // Return the abbreviation code and new size of a DIE.
+  uint64_t
+  die_layout(Unit*, uint32_t die, bool add_variants, uint64_t* size);
+
+  // Lay out the new contents of a unit.  This runs in parallel.
+  void
+  layout_unit(Unit*);
+
+  // Write out the new contents of a unit.  This runs in parallel.
+  void
+  write_unit(Unit*);
+
+  // Rewrite the sections which refer to .debug_info.
+  bool
+  rewrite_loc();
+
+  bool
+  rewrite_aranges();
+
+  bool
+  rewrite_pubnames(Section_kind);
+
+  // Map the references to DIEs found in an expression in a unit.
+  bool
+  map_expr_refs(const Unit*, const std::vector<Expr_ref>& refs,
+		std::vector<uint64_t>* mapped) const;
+
+  // Map an offset in the input .debug_info to the output.  If
+  // FOLLOW_REMOVED is true and OFFSET is a DIE which we removed,
+  // return the offset of the copy which we kept.  Return false if
+  // OFFSET is not the start of a unit or a DIE.
+  bool
+  map_offset(uint64_t offset, bool follow_removed, uint64_t* new_offset) const;
+
+  // Find the unit containing OFFSET in the input .debug_info.
+  const Unit*
+  find_unit(uint64_t offset) const;
+
+  // The output sections, indexed by Section_kind.
+  Output_dedup_debug_section* sections_[SECTION_KIND_COUNT];
+  // Whether run has been called.
+  bool done_;
+  // Whether we failed, in which case all the sections are written
+  // out unchanged.
+  bool failed_;
+  // The abbreviation tables, indexed by offset in .debug_abbrev.
+  std::map<uint64_t, Abbrev_table*> abbrev_tables_;
+  // The units in .debug_info, in order.
+  std::vector<Unit*> units_;
+  // The new section contents, indexed by Section_kind.  Empty
+  // sections are written out unchanged.
+  Buffer new_contents_[SECTION_KIND_COUNT];
+  // Statistics.
+  size_t type_count_;
+  size_t removed_type_count_;
+  size_t removed_die_count_;
+  size_t input_info_size_;
+};
+
+// An output section for --dedup-debug-types.  This collects the
+// contents of its input sections in the postprocessing buffer, and
+// writes out whatever Debug_type_dedup gives back.
+
+class Output_dedup_debug_section : public Output_section
+{
+ public:
+  Output_dedup_debug_section(const char* name, elfcpp::Elf_Word type,
+			     elfcpp::Elf_Xword flags,
+			     Debug_type_dedup* dedup,
+			     Debug_type_dedup::Section_kind kind)
+    : Output_section(name, type, flags), dedup_(dedup), kind_(kind),
+      contents_(NULL), input_size_(0), buffer_written_(false)
+  {
+    this->set_requires_postprocessing();
+    dedup->set_section(kind, this);
+  }
+
+  // Return the contents of the input sections, with relocations
+  // applied.  This may only be called once all the input sections
+  // have been relocated.
+  const unsigned char*
+  input_contents();
+
+  // Return the size of the input contents.
+  size_t
+  input_size() const
+  { return this->input_size_; }
+
+ protected:
+  // Set the final data size.
+  void
+  set_final_data_size();
+
+  // Write out the new contents.
+  void
+  do_write(Output_file*);
+
+ private:
+  // The object which computes the new contents.
+  Debug_type_dedup* dedup_;
+  // Which section this is.
+  Debug_type_dedup::Section_kind kind_;
+  // The new contents, or NULL to write out the input contents.
+  const std::vector<unsigned char>* contents_;
+  // The size of the input contents.
+  size_t input_size_;
+  // Whether the postprocessing buffer is complete.
+  bool buffer_written_;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_REDUCED_DEBUG_OUTPUT_H)
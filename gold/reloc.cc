@@ -48,6 +48,8 @@ namespace gold
 Task_token*
 Read_relocs::is_runnable()
 {
+  if (this->symtab_blocker_ != NULL && this->symtab_blocker_->is_blocked())
+    return this->symtab_blocker_;
   return this->object_->is_locked() ? this->object_->token() : NULL;
 }
 
@@ -59,6 +61,8 @@ Read_relocs::locks(Task_locker* tl)
   Task_token* token = this->object_->token();
   if (token != NULL)
     tl->add(this, token);
+  if (this->prescan_blocker_ != NULL)
+    tl->add(this, this->prescan_blocker_);
 }
 
 // Read the relocations and then start a Scan_relocs_task.
@@ -71,6 +75,12 @@ Read_relocs::run(Workqueue* workqueue)
   this->object_->set_relocs_data(rd);
   this->object_->release();
 
+  // The Scan_relocs tasks have to run one at a time, since they
+  // change the symbol table.  Weed out the relocations they would
+  // ignore now, while we can still run in parallel.
+  if (this->prescan_blocker_ != NULL)
+    this->object_->prescan_relocs(this->symtab_, rd);
+
   // If garbage collection or identical comdat folding is desired, we  
   // process the relocs first before scanning them.  Scanning of relocs is
   // done only after garbage or identical sections is identified.
@@ -234,9 +244,10 @@ Relocate_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Relocate_task::run(Workqueue*)
+Relocate_task::run(Workqueue* workqueue)
 {
   this->object_->relocate(this->symtab_, this->layout_, this->of_);
+  this->layout_->build_id_writer_done(workqueue, this->object_);
 
   // This is normally the last thing we will do with an object, so
   // uncache all views.
@@ -459,12 +470,21 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	  // only scan allocated sections.  We may see a non-allocated
 	  // section here if we are emitting relocs.
 	  if (p->is_data_section_allocated)
-	    target->scan_relocs(symtab, layout, this, p->data_shndx,
-				p->sh_type, p->contents->data(),
-				p->reloc_count, p->output_section,
-				p->needs_special_offset_handling,
-				this->local_symbol_count_,
-				local_symbols);
+	    {
+	      const unsigned char* prelocs = p->contents->data();
+	      size_t reloc_count = p->reloc_count;
+	      if (p->scan_contents != NULL)
+		{
+		  prelocs = p->scan_contents;
+		  reloc_count = p->scan_reloc_count;
+		}
+	      target->scan_relocs(symtab, layout, this, p->data_shndx,
+				  p->sh_type, prelocs, reloc_count,
+				  p->output_section,
+				  p->needs_special_offset_handling,
+				  this->local_symbol_count_,
+				  local_symbols);
+	    }
 	  if (parameters->options().emit_relocs())
 	    this->emit_relocs_scan(symtab, layout, local_symbols, p);
 	  if (layout->incremental_inputs() != NULL)
@@ -488,6 +508,8 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 
       delete p->contents;
       p->contents = NULL;
+      delete[] p->scan_contents;
+      p->scan_contents = NULL;
     }
 
   // For incremental links, finalize the allocation of relocations.
@@ -501,6 +523,48 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
     }
 }
 
+// Drop the relocs which do_scan_relocs would pass to the target
+// only to have them ignored.  This runs in parallel with the
+// Read_relocs tasks for other objects, before any Scan_relocs task.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_prescan_relocs(Symbol_table* symtab,
+						       Read_relocs_data* rd)
+{
+  if (parameters->options().relocatable())
+    return;
+
+  Sized_target<size, big_endian>* target =
+    parameters->sized_target<size, big_endian>();
+
+  const unsigned char* local_symbols;
+  if (rd->local_symbols == NULL)
+    local_symbols = NULL;
+  else
+    local_symbols = rd->local_symbols->data();
+
+  for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
+       p != rd->relocs.end();
+       ++p)
+    {
+      if (!p->is_data_section_allocated)
+	continue;
+      size_t kept_count;
+      unsigned char* kept = target->prescan_relocs(symtab, this, p->sh_type,
+						   p->contents->data(),
+						   p->reloc_count,
+						   this->local_symbol_count_,
+						   local_symbols,
+						   &kept_count);
+      if (kept != NULL)
+	{
+	  p->scan_contents = kept;
+	  p->scan_reloc_count = kept_count;
+	}
+    }
+}
+
 // Scan the input relocations for --emit-relocs.
 
 template<int size, bool big_endian>
@@ -1651,6 +1715,13 @@ Sized_relobj_file<32, false>::do_scan_relocs(Symbol_table* symtab,
 					     Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+void
+Sized_relobj_file<32, false>::do_prescan_relocs(Symbol_table* symtab,
+						Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_32_BIG
 template
 void
@@ -1659,6 +1730,13 @@ Sized_relobj_file<32, true>::do_scan_relocs(Symbol_table* symtab,
 					    Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_BIG
+template
+void
+Sized_relobj_file<32, true>::do_prescan_relocs(Symbol_table* symtab,
+					       Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_64_LITTLE
 template
 void
@@ -1667,6 +1745,13 @@ Sized_relobj_file<64, false>::do_scan_relocs(Symbol_table* symtab,
 					     Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_LITTLE
+template
+void
+Sized_relobj_file<64, false>::do_prescan_relocs(Symbol_table* symtab,
+						Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_64_BIG
 template
 void
@@ -1675,6 +1760,13 @@ Sized_relobj_file<64, true>::do_scan_relocs(Symbol_table* symtab,
 					    Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_BIG
+template
+void
+Sized_relobj_file<64, true>::do_prescan_relocs(Symbol_table* symtab,
+					       Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 void
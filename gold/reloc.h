@@ -64,11 +64,16 @@ class Read_relocs : public Task
  public:
   //   THIS_BLOCKER and NEXT_BLOCKER are passed along to a Scan_relocs
   // or Gc_process_relocs task, so that they run in a deterministic
-  // order.
+  // order.  If PRESCAN_BLOCKER is not NULL, this task also prescans
+  // the relocations, and unblocks PRESCAN_BLOCKER when done;
+  // SYMTAB_BLOCKER, if not NULL, keeps the prescan from running while
+  // something else is still changing the symbol table.
   Read_relocs(Symbol_table* symtab, Layout* layout, Relobj* object,
-	      Task_token* this_blocker, Task_token* next_blocker)
+	      Task_token* this_blocker, Task_token* next_blocker,
+	      Task_token* symtab_blocker, Task_token* prescan_blocker)
     : symtab_(symtab), layout_(layout), object_(object),
-      this_blocker_(this_blocker), next_blocker_(next_blocker)
+      this_blocker_(this_blocker), next_blocker_(next_blocker),
+      symtab_blocker_(symtab_blocker), prescan_blocker_(prescan_blocker)
   { }
 
   // The standard Task methods.
@@ -91,6 +96,8 @@ class Read_relocs : public Task
   Relobj* object_;
   Task_token* this_blocker_;
   Task_token* next_blocker_;
+  Task_token* symtab_blocker_;
+  Task_token* prescan_blocker_;
 };
 
 // Process the relocs to figure out which sections are garbage.
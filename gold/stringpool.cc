@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <vector>
 
+#include "gold-threads.h"
 #include "output.h"
 #include "parameters.h"
 #include "stringpool.h"
@@ -237,10 +238,12 @@ Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
 
 template<typename Stringpool_char>
 const Stringpool_char*
-Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
-						      size_t length,
-						      bool copy,
-						      Key* pkey)
+Stringpool_template<Stringpool_char>::add_with_length_and_hash(
+    const Stringpool_char* s,
+    size_t length,
+    size_t hash_code,
+    bool copy,
+    Key* pkey)
 {
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
@@ -252,7 +255,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      std::pair<Hashkey, Hashval> element(Hashkey(s, length, hash_code), k);
 
       Insert_type ins = this->string_set_.insert(element);
 
@@ -279,7 +282,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     {
@@ -408,7 +411,10 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
            ++p)
         v.push_back(Stringpool_sort_info(p));
 
-      std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
+      // No two strings in the pool compare as equal, so the sorted
+      // order, and hence the string table, does not depend on how
+      // the sort is divided among threads.
+      parallel_sort(&v, Stringpool_sort_comparison());
 
       section_offset_type last_offset = -1;
       for (typename std::vector<Stringpool_sort_info>::iterator last = v.end(),
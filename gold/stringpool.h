@@ -227,7 +227,26 @@ class Stringpool_template
   // Add string S of length LEN characters to the pool.  If COPY is
   // true, S need not be null terminated.
   const Stringpool_char*
-  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
+  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey)
+  {
+    return this->add_with_length_and_hash(s, len, string_hash(s, len),
+					  copy, pkey);
+  }
+
+  // Add string S of length LEN characters to the pool, where HASH_CODE
+  // is the value returned by hash_string for S.  This permits the
+  // caller to compute the hash code ahead of time, possibly in a
+  // different thread.
+  const Stringpool_char*
+  add_with_length_and_hash(const Stringpool_char* s, size_t len,
+			   size_t hash_code, bool copy, Key* pkey);
+
+  // Return the hash code which the pool uses for string S of length
+  // LEN characters.  This does not look at the pool, so it may be
+  // called by any thread at any time.
+  static size_t
+  hash_string(const Stringpool_char* s, size_t len)
+  { return string_hash(s, len); }
 
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
@@ -353,6 +372,10 @@ class Stringpool_template
     Hashkey(const Stringpool_char* s, size_t len)
       : string(s), length(len), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, size_t hash)
+      : string(s), length(len), hash_code(hash)
+    { }
   };
 
   // Hash function.  This is trivial, since we have already computed
@@ -1143,6 +1143,64 @@ Symbol_table::add_from_object(Object* object,
   return ret;
 }
 
+// Split and hash the names of the external symbols in a relocatable
+// object.  This is called while reading the symbols, possibly in
+// parallel with other objects, and must not touch the symbol table.
+// The results must match what add_from_relobj would compute.
+
+template<int size, bool big_endian>
+void
+Symbol_table::prepare_relobj_symbols(const unsigned char* syms,
+				     size_t count,
+				     const char* sym_names,
+				     size_t sym_name_size,
+				     Prepared_symbol_names* prepared)
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  prepared->resize(count);
+
+  const unsigned char* p = syms;
+  for (size_t i = 0; i < count; ++i, p += sym_size)
+    {
+      Prepared_symbol_name* pn = &(*prepared)[i];
+
+      elfcpp::Sym<size, big_endian> sym(p);
+      unsigned int st_name = sym.get_st_name();
+      if (st_name >= sym_name_size)
+	{
+	  // add_from_relobj will report the error.
+	  memset(pn, 0, sizeof *pn);
+	  continue;
+	}
+
+      const char* name = sym_names + st_name;
+      const char* ver = strchr(name, '@');
+      pn->is_default_version = false;
+      if (ver == NULL)
+	{
+	  pn->namelen = strlen(name);
+	  pn->ver_offset = 0;
+	  pn->verlen = 0;
+	  pn->ver_hash = 0;
+	}
+      else
+	{
+	  pn->namelen = ver - name;
+	  ++ver;
+	  if (*ver == '@')
+	    {
+	      pn->is_default_version = true;
+	      ++ver;
+	    }
+	  pn->ver_offset = ver - name;
+	  pn->verlen = strlen(ver);
+	  pn->ver_hash = Stringpool::hash_string(ver, pn->verlen);
+	}
+      pn->name_hash = Stringpool::hash_string(name, pn->namelen);
+    }
+}
+
 // Add all the symbols in a relocatable object to the hash table.
 
 template<int size, bool big_endian>
@@ -1154,6 +1212,7 @@ Symbol_table::add_from_relobj(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Prepared_symbol_names* prepared,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
@@ -1165,6 +1224,8 @@ Symbol_table::add_from_relobj(
 
   const bool just_symbols = relobj->just_symbols();
 
+  gold_assert(prepared == NULL || prepared->size() == count);
+
   const unsigned char* p = syms;
   for (size_t i = 0; i < count; ++i, p += sym_size)
     {
@@ -1212,8 +1273,15 @@ Symbol_table::add_from_relobj(
 
       // In an object file, an '@' in the name separates the symbol
       // name from the version name.  If there are two '@' characters,
-      // this is the default version.
-      const char* ver = strchr(name, '@');
+      // this is the default version.  If the names were prepared
+      // while reading the symbols, we already know where the '@' is.
+      const Prepared_symbol_name* pn =
+	prepared == NULL ? NULL : &(*prepared)[i];
+      const char* ver;
+      if (pn == NULL)
+	ver = strchr(name, '@');
+      else
+	ver = pn->ver_offset == 0 ? NULL : name + pn->namelen;
       Stringpool::Key ver_key = 0;
       int namelen = 0;
       // IS_DEFAULT_VERSION: is the version default?
@@ -1233,20 +1301,33 @@ Symbol_table::add_from_relobj(
         {
           // The symbol name is of the form foo@VERSION or foo@@VERSION
           namelen = ver - name;
-          ++ver;
-	  if (*ver == '@')
+	  if (pn != NULL)
+	    {
+	      is_default_version = pn->is_default_version;
+	      ver = this->namepool_.add_with_length_and_hash(name
+							     + pn->ver_offset,
+							     pn->verlen,
+							     pn->ver_hash,
+							     true,
+							     &ver_key);
+	    }
+	  else
 	    {
-	      is_default_version = true;
 	      ++ver;
+	      if (*ver == '@')
+		{
+		  is_default_version = true;
+		  ++ver;
+		}
+	      ver = this->namepool_.add(ver, true, &ver_key);
 	    }
-	  ver = this->namepool_.add(ver, true, &ver_key);
         }
       // We don't want to assign a version to an undefined symbol,
       // even if it is listed in the version script.  FIXME: What
       // about a common symbol?
       else
 	{
-	  namelen = strlen(name);
+	  namelen = pn != NULL ? pn->namelen : strlen(name);
 	  if (!this->version_script_.empty()
 	      && st_shndx != elfcpp::SHN_UNDEF)
 	    {
@@ -1318,8 +1399,13 @@ Symbol_table::add_from_relobj(
         }
 
       Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      if (pn != NULL)
+	name = this->namepool_.add_with_length_and_hash(name, namelen,
+							pn->name_hash, true,
+							&name_key);
+      else
+	name = this->namepool_.add_with_length(name, namelen, true,
+					       &name_key);
 
       Sized_symbol<size>* res;
       res = this->add_from_object(relobj, name, name_key, ver, ver_key,
@@ -3397,31 +3483,120 @@ struct Odr_violation_compare
 };
 
 // Returns all of the lines attached to LOC, not just the one the
-// instruction actually came from.
-std::vector<std::string>
-Symbol_table::linenos_from_loc(const Task* task,
-                               const Symbol_location& loc)
-{
-  // We need to lock the object in order to read it.  This
-  // means that we have to run in a singleton Task.  If we
-  // want to run this in a general Task for better
-  // performance, we will need one Task for object, plus
-  // appropriate locking to ensure that we don't conflict with
-  // other uses of the object.  Also note, one_addr2line is not
-  // currently thread-safe.
-  Task_lock_obj<Object> tl(task, loc.object);
-
+// instruction actually came from.  This helps the ODR checker avoid
+// false positives.  LINEINFO holds the line information for the
+// object of LOC, which must be locked.
+static std::vector<std::string>
+linenos_from_loc(Dwarf_line_info* lineinfo, const Symbol_location& loc)
+{
   std::vector<std::string> result;
   Symbol_location code_loc = loc;
   parameters->target().function_location(&code_loc);
-  // 16 is the size of the object-cache that one_addr2line should use.
-  std::string canonical_result = Dwarf_line_info::one_addr2line(
-      code_loc.object, code_loc.shndx, code_loc.offset, 16, &result);
+  gold_assert(code_loc.object == loc.object);
+  std::string canonical_result = lineinfo->addr2line(code_loc.shndx,
+						     code_loc.offset,
+						     &result);
   if (!canonical_result.empty())
     result.push_back(canonical_result);
   return result;
 }
 
+// The ODR locations in one input file, each with a place to store its
+// line numbers.
+
+typedef std::vector<std::pair<Symbol_location, std::vector<std::string>*> >
+  Odr_file_locations;
+
+// Sort Odr_file_locations so that all the locations in one object
+// are together.
+
+struct Odr_location_object_compare
+{
+  bool
+  operator()(const Odr_file_locations::value_type& l1,
+	     const Odr_file_locations::value_type& l2) const
+  { return l1.first.object < l2.first.object; }
+};
+
+// Find the line numbers of the ODR locations, one input file per
+// piece.  Archive members share a file, so they are done together,
+// which lets us lock each object in turn.  We read the line
+// information for each object just once, which builds an index from
+// offsets to lines that we can then search for each location.
+
+class Odr_lineno_work : public Parallel_work
+{
+ public:
+  Odr_lineno_work(const Task* task, std::vector<Odr_file_locations>* files)
+    : task_(task), files_(files)
+  { }
+
+  void
+  run_piece(size_t i);
+
+ private:
+  const Task* task_;
+  std::vector<Odr_file_locations>* files_;
+};
+
+void
+Odr_lineno_work::run_piece(size_t i)
+{
+  Odr_file_locations& locs((*this->files_)[i]);
+  std::stable_sort(locs.begin(), locs.end(), Odr_location_object_compare());
+
+  Odr_file_locations::const_iterator p = locs.begin();
+  while (p != locs.end())
+    {
+      Object* object = p->first.object;
+      Task_lock_obj<Object> tl(this->task_, object);
+      Dwarf_line_info* lineinfo = Dwarf_line_info::make(object, -1U);
+      for (; p != locs.end() && p->first.object == object; ++p)
+	*p->second = linenos_from_loc(lineinfo, p->first);
+      delete lineinfo;
+    }
+}
+
+// Fill in LINENOS with the line numbers for every location in
+// candidate_odr_violations_.  The objects are read in parallel when
+// using threads.  TASK is a singleton Task, so nothing else is using
+// the objects.
+
+void
+Symbol_table::find_odr_linenos(const Task* task, Odr_linenos* linenos) const
+{
+  // Create all the entries first, so that the pieces only fill in
+  // existing entries.
+  std::vector<Odr_file_locations> files;
+  Unordered_map<const Input_file*, size_t> file_index;
+  for (Odr_map::const_iterator it = candidate_odr_violations_.begin();
+       it != candidate_odr_violations_.end();
+       ++it)
+    {
+      for (Unordered_set<Symbol_location, Symbol_location_hash>::const_iterator
+	     locs = it->second.begin();
+	   locs != it->second.end();
+	   ++locs)
+	{
+	  std::pair<Odr_linenos::iterator, bool> ins =
+	    linenos->insert(std::make_pair(*locs, std::vector<std::string>()));
+	  if (!ins.second)
+	    continue;
+
+	  const Input_file* input_file = locs->object->input_file();
+	  std::pair<Unordered_map<const Input_file*, size_t>::iterator, bool>
+	    fins = file_index.insert(std::make_pair(input_file, files.size()));
+	  if (fins.second)
+	    files.push_back(Odr_file_locations());
+	  files[fins.first->second].push_back(std::make_pair(*locs,
+							     &ins.first->second));
+	}
+    }
+
+  Odr_lineno_work work(task, &files);
+  run_parallel_work(&work, files.size());
+}
+
 // OutputIterator that records if it was ever assigned to.  This
 // allows it to be used with std::set_intersection() to check for
 // intersection rather than computing the intersection.
@@ -3459,6 +3634,12 @@ void
 Symbol_table::detect_odr_violations(const Task* task,
 				    const char* output_file_name) const
 {
+  if (candidate_odr_violations_.empty())
+    return;
+
+  Odr_linenos linenos_by_loc;
+  this->find_odr_linenos(task, &linenos_by_loc);
+
   for (Odr_map::const_iterator it = candidate_odr_violations_.begin();
        it != candidate_odr_violations_.end();
        ++it)
@@ -3481,7 +3662,7 @@ Symbol_table::detect_odr_violations(const Task* task,
           // false negatives that appear or disappear depending on the
           // link order, but it won't cause false positives.
           first_object_name = locs->object->name();
-          first_object_linenos = this->linenos_from_loc(task, *locs);
+          first_object_linenos = linenos_by_loc[*locs];
         }
       if (first_object_linenos.empty())
 	continue;
@@ -3493,8 +3674,7 @@ Symbol_table::detect_odr_violations(const Task* task,
 
       for (; locs != locs_end; ++locs)
         {
-          std::vector<std::string> linenos =
-              this->linenos_from_loc(task, *locs);
+          std::vector<std::string> linenos = linenos_by_loc[*locs];
           // linenos will be empty if we couldn't parse the debug info.
           if (linenos.empty())
             continue;
@@ -3535,8 +3715,6 @@ Symbol_table::detect_odr_violations(const Task* task,
             }
         }
     }
-  // We only call one_addr2line() in this function, so we can clear its cache.
-  Dwarf_line_info::clear_addr2line_cache();
 }
 
 // Warnings functions.
@@ -3618,10 +3796,22 @@ Symbol_table::add_from_relobj<32, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Prepared_symbol_names* prepared,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+void
+Symbol_table::prepare_relobj_symbols<32, false>(
+    const unsigned char* syms,
+    size_t count,
+    const char* sym_names,
+    size_t sym_name_size,
+    Prepared_symbol_names* prepared);
+#endif
+
 #ifdef HAVE_TARGET_32_BIG
 template
 void
@@ -3632,10 +3822,22 @@ Symbol_table::add_from_relobj<32, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Prepared_symbol_names* prepared,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
 #endif
 
+#ifdef HAVE_TARGET_32_BIG
+template
+void
+Symbol_table::prepare_relobj_symbols<32, true>(
+    const unsigned char* syms,
+    size_t count,
+    const char* sym_names,
+    size_t sym_name_size,
+    Prepared_symbol_names* prepared);
+#endif
+
 #ifdef HAVE_TARGET_64_LITTLE
 template
 void
@@ -3646,10 +3848,22 @@ Symbol_table::add_from_relobj<64, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Prepared_symbol_names* prepared,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
 #endif
 
+#ifdef HAVE_TARGET_64_LITTLE
+template
+void
+Symbol_table::prepare_relobj_symbols<64, false>(
+    const unsigned char* syms,
+    size_t count,
+    const char* sym_names,
+    size_t sym_name_size,
+    Prepared_symbol_names* prepared);
+#endif
+
 #ifdef HAVE_TARGET_64_BIG
 template
 void
@@ -3660,10 +3874,22 @@ Symbol_table::add_from_relobj<64, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Prepared_symbol_names* prepared,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
 #endif
 
+#ifdef HAVE_TARGET_64_BIG
+template
+void
+Symbol_table::prepare_relobj_symbols<64, true>(
+    const unsigned char* syms,
+    size_t count,
+    const char* sym_names,
+    size_t sym_name_size,
+    Prepared_symbol_names* prepared);
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 Symbol*
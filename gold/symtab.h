@@ -1415,18 +1415,32 @@ class Symbol_table
   inline void
   gc_mark_dyn_syms(Symbol* sym);
 
+  // Split the names of COUNT external symbols from a relocatable
+  // object into name and version, and compute their hash codes,
+  // storing the results in PREPARED for use by add_from_relobj.  SYMS
+  // is the symbols, SYM_NAMES is their names, SYM_NAME_SIZE is the
+  // size of SYM_NAMES.  This does not look at the symbol table, so it
+  // may be called for several objects at once.
+  template<int size, bool big_endian>
+  static void
+  prepare_relobj_symbols(const unsigned char* syms, size_t count,
+			 const char* sym_names, size_t sym_name_size,
+			 Prepared_symbol_names* prepared);
+
   // Add COUNT external symbols from the relocatable object RELOBJ to
   // the symbol table.  SYMS is the symbols, SYMNDX_OFFSET is the
   // offset in the symbol table of the first symbol, SYM_NAMES is
-  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  This sets
-  // SYMPOINTERS to point to the symbols in the symbol table.  It sets
-  // *DEFINED to the number of defined symbols.
+  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  PREPARED,
+  // if not NULL, is the result of prepare_relobj_symbols for these
+  // symbols.  This sets SYMPOINTERS to point to the symbols in the
+  // symbol table.  It sets *DEFINED to the number of defined symbols.
   template<int size, bool big_endian>
   void
   add_from_relobj(Sized_relobj_file<size, big_endian>* relobj,
 		  const unsigned char* syms, size_t count,
 		  size_t symndx_offset, const char* sym_names,
 		  size_t sym_name_size,
+		  const Prepared_symbol_names* prepared,
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
@@ -1708,6 +1722,11 @@ class Symbol_table
                         Unordered_set<Symbol_location, Symbol_location_hash> >
   Odr_map;
 
+  // The line numbers found for each location in the Odr_map.
+  typedef Unordered_map<Symbol_location, std::vector<std::string>,
+			Symbol_location_hash>
+  Odr_linenos;
+
   // Make FROM a forwarder symbol to TO.
   void
   make_forwarder(Symbol* from, Symbol* to);
@@ -1857,11 +1876,9 @@ class Symbol_table
   do_allocate_commons_list(Layout*, Commons_section_type, Commons_type*,
 			   Mapfile*, Sort_commons_order);
 
-  // Returns all of the lines attached to LOC, not just the one the
-  // instruction actually came from.  This helps the ODR checker avoid
-  // false positives.
-  static std::vector<std::string>
-  linenos_from_loc(const Task* task, const Symbol_location& loc);
+  // Find the line numbers for all the locations in the Odr_map.
+  void
+  find_odr_linenos(const Task* task, Odr_linenos* linenos) const;
 
   // Implement detect_odr_violations.
   template<int size, bool big_endian>
@@ -373,6 +373,11 @@ class Target
      return this->do_may_relax();
   }
 
+  // Return true if the target implements Sized_target::prescan_relocs.
+  bool
+  can_prescan_relocs() const
+  { return this->do_can_prescan_relocs(); }
+
   // Perform a relaxation pass.  Return true if layout may be changed.
   bool
   relax(int pass, const Input_objects* input_objects, Symbol_table* symtab,
@@ -722,6 +727,11 @@ class Target
   do_may_relax() const
   { return parameters->options().relax(); }
 
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_can_prescan_relocs() const
+  { return false; }
+
   // Virtual function which may be overridden by the child class.
   virtual bool
   do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*)
@@ -889,6 +899,22 @@ class Sized_target : public Target
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols) = 0;
 
+  // Prescan the relocs for a section before scan_relocs sees them,
+  // and drop the ones which scan_relocs would ignore.  This is called
+  // in parallel for different objects once all symbols have been
+  // resolved, so it may look at the symbol table but must not change
+  // it.  The parameters are like scan_relocs, less LAYOUT,
+  // DATA_SHNDX, OUTPUT_SECTION and NEEDS_SPECIAL_OFFSET_HANDLING.
+  // Return a newly allocated array holding the relocs which
+  // scan_relocs must still look at, in their original order, and set
+  // the last parameter to their number.  Return NULL to keep all the
+  // relocs.
+  virtual unsigned char*
+  prescan_relocs(Symbol_table*, Sized_relobj_file<size, big_endian>*,
+		 unsigned int, const unsigned char*, size_t, size_t,
+		 const unsigned char*, size_t*)
+  { return NULL; }
+
   // Relocate section data.  SH_TYPE is the type of the relocation
   // section, SHT_REL or SHT_RELA.  PRELOCS points to the relocation
   // information.  RELOC_COUNT is the number of relocs.
@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# dwp_test_threads.sh -- Test the dwp tool with threads.
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# dwp_test_threads.dwp is built from the same inputs as
+# dwp_test_1.dwp, but with --thread-count 2.  The output must not
+# depend on the number of threads.
+
+if ! cmp -s dwp_test_1.dwp dwp_test_threads.dwp; then
+    echo "dwp_test_threads.dwp differs from dwp_test_1.dwp"
+    exit 1
+fi
+
+# dwp_test_threads.err is the output of a run in which one of the
+# input files is missing.  The error must be reported for that file.
+
+if ! grep -q "fatal error: dwp_test_missing.dwo: can't open" \
+     dwp_test_threads.err; then
+    echo "Did not find expected error:"
+    echo "   fatal error: dwp_test_missing.dwo: can't open"
+    echo ""
+    echo "Actual error output below:"
+    cat dwp_test_threads.err
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# mmap_output_windows_test.sh -- test --mmap-output-windows.
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# With --mmap-output-windows, gold maps each part of the output file
+# separately while writing it.  The output must be the same as when
+# the whole file is mapped, and must run.
+
+if ! cmp -s mmap_output_windows_test_1 mmap_output_windows_test_2
+then
+    echo "mmap_output_windows_test_1 and mmap_output_windows_test_2 differ"
+    exit 1
+fi
+
+if ! ./mmap_output_windows_test_2
+then
+    echo "mmap_output_windows_test_2 failed"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,72 @@
+#!/bin/sh
+
+# trace_file_test.sh -- test --trace-file.
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The trace is a JSON object in the Chrome trace event format, with
+# one event per line.  Check the structure of each line, and if
+# python is available, check that the whole file parses as JSON.
+
+file=trace_file_test.json
+
+fail()
+{
+    echo "$1"
+    echo ""
+    echo "Actual output below:"
+    cat "$file"
+    exit 1
+}
+
+if test "`sed -n '1p' $file`" != '{"traceEvents":['; then
+    fail "Bad first line in $file"
+fi
+if test "`sed -n '$p' $file`" != '],"displayTimeUnit":"ms"}'; then
+    fail "Bad last line in $file"
+fi
+
+# Every event is an object with a name.  Every event but the last is
+# followed by a comma.
+events=`sed -e '1d' -e '$d' $file`
+if echo "$events" | grep -v -q -E '^\{"name":"([^"\\]|\\.)*",.*\},?$'; then
+    fail "Bad event in $file"
+fi
+if echo "$events" | sed -e '$d' | grep -v -q ',$'; then
+    fail "Missing comma in $file"
+fi
+if echo "$events" | sed -n -e '$p' | grep -q ',$'; then
+    fail "Extra comma in $file"
+fi
+
+# The tasks which every link runs must be there.
+for task in "Task_function Layout_task_runner" "Write_sections_task"; do
+    if ! grep -q "\"name\":\"$task\"" $file; then
+	fail "Did not find $task in $file"
+    fi
+done
+
+if python3 -c '' > /dev/null 2>&1; then
+    if ! python3 -m json.tool $file > /dev/null; then
+	fail "$file is not valid JSON"
+    fi
+fi
+
+exit 0
@@ -22,6 +22,19 @@
 
 #include "gold.h"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <unistd.h>
+
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+
+#include "libiberty.h"
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -114,6 +127,287 @@ class Workqueue_threader_single : public Workqueue_threader
   { return false; }
 };
 
+// A Task which helps run the pieces of a Parallel_work.  It never
+// has to wait, and it does nothing if all the pieces have already
+// been started by the time it runs.
+
+class Parallel_work_task : public Task
+{
+ public:
+  Parallel_work_task(Parallel_work_group* group)
+    : group_(group)
+  { }
+
+  ~Parallel_work_task()
+  { this->group_->release(); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->group_->run_pieces(); }
+
+  std::string
+  get_name() const
+  { return "Parallel_work_task"; }
+
+ private:
+  Parallel_work_group* group_;
+};
+
+// Class Workqueue_trace records when each Task runs, and on which
+// thread, for --trace-file.  All the methods are called with the
+// Workqueue lock held, since another thread may add an entry to
+// threads_ at any time.
+
+class Workqueue_trace
+{
+ public:
+  Workqueue_trace(const char* filename)
+    : filename_(filename), start_time_(now()), threads_(), waiting_()
+  { }
+
+  ~Workqueue_trace();
+
+  // Note that T is waiting for a Task_token.
+  void
+  wait_task(Task* t);
+
+  // Note that T is no longer waiting for a Task_token, because
+  // RELEASER released it.
+  void
+  release_task(Task* t, Task* releaser);
+
+  // Note that THREAD_NUMBER is about to run T.  Return the index to
+  // pass to finish_task.
+  size_t
+  start_task(int thread_number, Task* t);
+
+  // Note that THREAD_NUMBER finished running the Task which was given
+  // INDEX by start_task at time END.
+  void
+  finish_task(int thread_number, size_t index, long long end);
+
+  // Note that THREAD_NUMBER waited for a Task to run from START.
+  void
+  idle(int thread_number, long long start);
+
+  // Return the current time in microseconds.
+  static long long
+  now();
+
+  // Write out the trace.
+  void
+  write();
+
+ private:
+  // An event in the trace.  Idle time is recorded as an event with
+  // an empty name.
+  struct Event
+  {
+    Event()
+      : name(), start(0), end(0), wait_start(-1), blocked_by()
+    { }
+
+    std::string name;
+    long long start;
+    long long end;
+    // When the Task started waiting for a Task_token, or -1.
+    long long wait_start;
+    // The names of the Tasks which released a Task_token which this
+    // Task was waiting for.
+    std::vector<std::string> blocked_by;
+  };
+
+  typedef std::vector<Event> Events;
+  typedef std::map<const Task*, Event> Waiting;
+
+  // Return the events for THREAD_NUMBER.
+  Events*
+  thread_events(int thread_number);
+
+  // Write S to F as a JSON string.
+  static void
+  write_string(FILE* f, const std::string& s);
+
+  // The file to write.
+  const char* filename_;
+  // The time when we started.
+  long long start_time_;
+  // The events run by each thread, indexed by thread number.  Each
+  // thread only adds events to its own entry.
+  std::vector<Events*> threads_;
+  // Information about the Tasks which are waiting for a Task_token.
+  Waiting waiting_;
+};
+
+Workqueue_trace::~Workqueue_trace()
+{
+  for (std::vector<Events*>::iterator p = this->threads_.begin();
+       p != this->threads_.end();
+       ++p)
+    delete *p;
+}
+
+long long
+Workqueue_trace::now()
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+  ::gettimeofday(&tv, NULL);
+  return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#else
+  return get_run_time();
+#endif
+}
+
+Workqueue_trace::Events*
+Workqueue_trace::thread_events(int thread_number)
+{
+  while (this->threads_.size() <= static_cast<size_t>(thread_number))
+    this->threads_.push_back(new Events());
+  return this->threads_[thread_number];
+}
+
+void
+Workqueue_trace::wait_task(Task* t)
+{
+  Event& e(this->waiting_[t]);
+  if (e.wait_start < 0)
+    e.wait_start = now();
+}
+
+void
+Workqueue_trace::release_task(Task* t, Task* releaser)
+{
+  Event& e(this->waiting_[t]);
+  const std::string& name(releaser->name());
+  if (std::find(e.blocked_by.begin(), e.blocked_by.end(), name)
+      == e.blocked_by.end())
+    e.blocked_by.push_back(name);
+}
+
+size_t
+Workqueue_trace::start_task(int thread_number, Task* t)
+{
+  Events* events = this->thread_events(thread_number);
+  Waiting::iterator p = this->waiting_.find(t);
+  if (p == this->waiting_.end())
+    events->push_back(Event());
+  else
+    {
+      events->push_back(p->second);
+      this->waiting_.erase(p);
+    }
+  Event& e(events->back());
+  e.name = t->name();
+  e.start = now();
+  return events->size() - 1;
+}
+
+void
+Workqueue_trace::finish_task(int thread_number, size_t index, long long end)
+{
+  // The Events for this thread were created by start_task.
+  (*this->threads_[thread_number])[index].end = end;
+}
+
+void
+Workqueue_trace::idle(int thread_number, long long start)
+{
+  Events* events = this->thread_events(thread_number);
+  events->push_back(Event());
+  events->back().start = start;
+  events->back().end = now();
+}
+
+// Write S as a JSON string.
+
+void
+Workqueue_trace::write_string(FILE* f, const std::string& s)
+{
+  putc('"', f);
+  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+      unsigned char c = *p;
+      if (c == '"' || c == '\\')
+	fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+// Write the trace in the Chrome trace event format.  Each Task is a
+// complete event on the thread which ran it, with the time it spent
+// waiting for a Task_token and the Tasks which released the
+// Task_tokens in its arguments.  The time that each thread spent
+// waiting for a Task to run is shown as "idle" events.
+
+void
+Workqueue_trace::write()
+{
+  FILE* f = ::fopen(this->filename_, "w");
+  if (f == NULL)
+    {
+      gold_error(_("cannot open trace file %s: %s"), this->filename_,
+		 strerror(errno));
+      return;
+    }
+
+  long pid = static_cast<long>(::getpid());
+  fprintf(f, "{\"traceEvents\":[\n");
+  bool first = true;
+  for (size_t i = 0; i < this->threads_.size(); ++i)
+    {
+      fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+	      "\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+	      first ? "" : ",\n", pid, static_cast<unsigned int>(i),
+	      static_cast<unsigned int>(i));
+      first = false;
+
+      const Events* events = this->threads_[i];
+      for (Events::const_iterator p = events->begin();
+	   p != events->end();
+	   ++p)
+	{
+	  fprintf(f, ",\n{\"name\":");
+	  write_string(f, p->name.empty() ? std::string("idle") : p->name);
+	  fprintf(f, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+		  "\"pid\":%ld,\"tid\":%u",
+		  p->name.empty() ? "idle" : "task",
+		  p->start - this->start_time_, p->end - p->start,
+		  pid, static_cast<unsigned int>(i));
+	  if (p->wait_start >= 0)
+	    {
+	      fprintf(f, ",\"args\":{\"waited_us\":%lld,\"blocked_by\":[",
+		      p->start - p->wait_start);
+	      for (size_t j = 0; j < p->blocked_by.size(); ++j)
+		{
+		  if (j > 0)
+		    putc(',', f);
+		  write_string(f, p->blocked_by[j]);
+		}
+	      fprintf(f, "]}");
+	    }
+	  putc('}', f);
+	}
+    }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (::fclose(f) != 0)
+    gold_error(_("cannot write trace file %s: %s"), this->filename_,
+	       strerror(errno));
+}
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
@@ -122,19 +416,51 @@ Workqueue::Workqueue(const General_options& options)
     tasks_(),
     running_(0),
     waiting_(0),
+    thread_queues_(),
+    thread_queued_(0),
+    thread_pushes_(0),
+    idle_(0),
     condvar_(this->lock_),
+    tasks_run_(0),
+    tasks_stolen_(0),
+    idle_waits_(0),
+    trace_(NULL),
     threader_(NULL)
 {
+  if (options.trace_file() != NULL)
+    this->trace_ = new Workqueue_trace(options.trace_file());
+
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
   threads = false;
 #endif
+
+  // Create one run queue for each thread that we expect to start.
+  // The queues are never added to later, so that threads may look
+  // at the other queues without holding the Workqueue lock.
+  int queue_count = 1;
+  if (threads)
+    {
+      queue_count = std::max(options.thread_count_initial(),
+			     std::max(options.thread_count_middle(),
+				      options.thread_count_final()));
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+      if (queue_count == 0)
+	queue_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+      if (queue_count < 1)
+	queue_count = 1;
+    }
+  for (int i = 0; i < queue_count; ++i)
+    this->thread_queues_.push_back(new Thread_queue());
+
   if (!threads)
     this->threader_ = new Workqueue_threader_single(this);
   else
     {
 #ifdef ENABLE_THREADS
       this->threader_ = new Workqueue_threader_threadpool(this);
+      set_parallel_work_helpers(this);
 #else
       gold_unreachable();
 #endif
@@ -143,6 +469,13 @@ Workqueue::Workqueue(const General_options& options)
 
 Workqueue::~Workqueue()
 {
+  set_parallel_work_helpers(NULL);
+  for (std::vector<Thread_queue*>::iterator p = this->thread_queues_.begin();
+       p != this->thread_queues_.end();
+       ++p)
+    delete *p;
+  if (this->trace_ != NULL)
+    delete this->trace_;
 }
 
 // Add a task to the end of a specific queue, or put it on the list
@@ -161,6 +494,8 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
       else
 	token->add_waiting(t);
       ++this->waiting_;
+      if (this->trace_ != NULL)
+	this->trace_->wait_task(t);
     }
   else
     {
@@ -169,7 +504,7 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
       else
 	queue->push_back(t);
       // Tell any waiting thread that there is work to do.
-      this->condvar_.signal();
+      this->signal_idle_thread();
     }
 }
 
@@ -224,19 +559,98 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
 
       token->add_waiting(t);
       ++this->waiting_;
+      if (this->trace_ != NULL)
+	this->trace_->wait_task(t);
     }
 
   // We couldn't find any runnable task.
   return NULL;
 }
 
-// Find a runnable task.  Return NULL if none could be found.  The
-// workqueue lock must be held when this is called.
+// Find a runnable task on the thread run queue Q, looking at the
+// tasks to execute soon if FIRST is true.  Return NULL if none could
+// be found.  The workqueue lock must be held when this is called.
+
+Task*
+Workqueue::find_runnable_in_thread_queue(Thread_queue* q, bool first)
+{
+  while (true)
+    {
+      Task* t;
+      {
+	Hold_lock hl(q->lock);
+	t = first ? q->first_tasks.pop_front() : q->tasks.pop_front();
+      }
+      if (t == NULL)
+	return NULL;
+      t = this->check_runnable(t);
+      if (t != NULL)
+	return t;
+    }
+}
+
+// T has been taken off a thread run queue.  If it can run now,
+// return it.  Otherwise add it to the list for the Token it is
+// waiting for, and return NULL.  The workqueue lock must be held when
+// this is called.
+
+Task*
+Workqueue::check_runnable(Task* t)
+{
+  --this->thread_queued_;
+
+  Task_token* token = t->is_runnable();
+  if (token == NULL)
+    return t;
+
+  token->add_waiting(t);
+  ++this->waiting_;
+  if (this->trace_ != NULL)
+    this->trace_->wait_task(t);
+  return NULL;
+}
+
+// Take a task off the queue of some thread other than THREAD_NUMBER.
+// We look at the other queues in a fixed order starting with the
+// next one, so that the threads do not all descend on the same
+// victim.  This is called without holding the workqueue lock, so the
+// caller must still check whether the task can run.  Return NULL if
+// we did not find any task.
+
+Task*
+Workqueue::steal_task(int thread_number)
+{
+  size_t count = this->thread_queues_.size();
+  size_t own = static_cast<size_t>(thread_number) % count;
+  for (size_t i = 1; i < count; ++i)
+    {
+      Thread_queue* q = this->thread_queues_[(own + i) % count];
+      Hold_lock hl(q->lock);
+      Task* t = q->first_tasks.pop_front();
+      if (t == NULL)
+	t = q->tasks.pop_front();
+      if (t != NULL)
+	return t;
+    }
+  return NULL;
+}
+
+// Find a runnable task.  Return NULL if none could be found.  We
+// look first at the tasks which this thread queued itself, and then
+// at the shared queues.  This does not look at the queues of the
+// other threads.  The workqueue lock must be held when this is
+// called.
 
 Task*
-Workqueue::find_runnable()
+Workqueue::find_runnable(int thread_number)
 {
-  Task* t = this->find_runnable_in_list(&this->first_tasks_);
+  Thread_queue* q = this->thread_queue(thread_number);
+
+  Task* t = this->find_runnable_in_thread_queue(q, true);
+  if (t == NULL)
+    t = this->find_runnable_in_list(&this->first_tasks_);
+  if (t == NULL)
+    t = this->find_runnable_in_thread_queue(q, false);
   if (t == NULL)
     t = this->find_runnable_in_list(&this->tasks_);
   return t;
@@ -244,18 +658,45 @@ Workqueue::find_runnable()
 
 // Find a runnable a task, and wait until we find one.  Return NULL if
 // we should exit.  The workqueue lock must be held when this is
-// called.
+// called.  It is released while we look for a task to steal from
+// another thread.
 
 Task*
 Workqueue::find_runnable_or_wait(int thread_number)
 {
-  Task* t = this->find_runnable();
+  Task* t = this->find_runnable(thread_number);
 
   while (t == NULL)
     {
-      if (this->running_ == 0
-	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+      if (this->thread_queued_ > 0 && this->thread_queues_.size() > 1)
+	{
+	  unsigned int pushes = this->thread_pushes_;
+
+	  this->lock_.release();
+	  Task* stolen = this->steal_task(thread_number);
+	  this->lock_.acquire();
+
+	  if (stolen != NULL)
+	    {
+	      gold_debug(DEBUG_TASK, "%3d stealing  task %s",
+			 thread_number, stolen->name().c_str());
+	      ++this->tasks_stolen_;
+	      t = this->check_runnable(stolen);
+	      if (t == NULL)
+		t = this->find_runnable(thread_number);
+	      continue;
+	    }
+
+	  // If another thread queued a task while we were looking,
+	  // look again rather than going to sleep.
+	  if (this->thread_pushes_ != pushes)
+	    {
+	      t = this->find_runnable(thread_number);
+	      continue;
+	    }
+	}
+
+      if (this->running_ == 0 && !this->have_queued_tasks())
 	{
 	  // Kick all the threads to make them exit.
 	  this->condvar_.broadcast();
@@ -269,11 +710,19 @@ Workqueue::find_runnable_or_wait(int thread_number)
 
       gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
 
+      ++this->idle_;
+      ++this->idle_waits_;
+      long long idle_start = 0;
+      if (this->trace_ != NULL)
+	idle_start = Workqueue_trace::now();
       this->condvar_.wait();
+      --this->idle_;
+      if (this->trace_ != NULL)
+	this->trace_->idle(thread_number, idle_start);
 
       gold_debug(DEBUG_TASK, "%3d awake", thread_number);
 
-      t = this->find_runnable();
+      t = this->find_runnable(thread_number);
     }
 
   return t;
@@ -290,6 +739,7 @@ Workqueue::find_and_run_task(int thread_number)
 {
   Task* t;
   Task_locker tl;
+  size_t trace_index = 0;
 
   {
     Hold_lock hl(this->lock_);
@@ -305,6 +755,9 @@ Workqueue::find_and_run_task(int thread_number)
     t->locks(&tl);
 
     ++this->running_;
+    ++this->tasks_run_;
+    if (this->trace_ != NULL)
+      trace_index = this->trace_->start_task(thread_number, t);
   }
 
   while (t != NULL)
@@ -318,6 +771,11 @@ Workqueue::find_and_run_task(int thread_number)
 
       t->run(this);
 
+      // Take the time now, but record it below with the lock held.
+      long long trace_end = 0;
+      if (this->trace_ != NULL)
+	trace_end = Workqueue_trace::now();
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -337,12 +795,15 @@ Workqueue::find_and_run_task(int thread_number)
 
 	--this->running_;
 
+	if (this->trace_ != NULL)
+	  this->trace_->finish_task(thread_number, trace_index, trace_end);
+
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
-	next = this->release_locks(t, &tl);
+	next = this->release_locks(t, &tl, thread_number);
 
 	if (next == NULL)
-	  next = this->find_runnable();
+	  next = this->find_runnable(thread_number);
 
 	// If we have another Task to run, get the Locks.  This must
 	// be called while we are still holding the Workqueue lock.
@@ -352,6 +813,9 @@ Workqueue::find_and_run_task(int thread_number)
 	    next->locks(&tl);
 
 	    ++this->running_;
+	    ++this->tasks_run_;
+	    if (this->trace_ != NULL)
+	      trace_index = this->trace_->start_task(thread_number, next);
 	  }
       }
 
@@ -370,8 +834,9 @@ Workqueue::find_and_run_task(int thread_number)
 // 1) If T is not runnable, queue it on the appropriate token.
 
 // 2) Otherwise, T is runnable.  If *PRET is not NULL, then we have
-// already decided which Task to run next.  Add T to the list of
-// runnable tasks, and signal another thread.
+// already decided which Task to run next.  Add T to the run queue of
+// thread THREAD_NUMBER, and signal another thread, which may steal
+// it.
 
 // 3) Otherwise, *PRET is NULL.  If IS_BLOCKER is false, then T was
 // waiting on a write lock.  We can grab that lock now, so we run T
@@ -394,7 +859,8 @@ Workqueue::find_and_run_task(int thread_number)
 // Return true if we set *PRET to T, false otherwise.
 
 bool
-Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
+Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret,
+			   int thread_number)
 {
   Task_token* token = t->is_runnable();
 
@@ -402,6 +868,8 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     {
       token->add_waiting(t);
       ++this->waiting_;
+      if (this->trace_ != NULL)
+	this->trace_->wait_task(t);
       return false;
     }
 
@@ -414,7 +882,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     should_return = true;
   else if (t->should_run_soon())
     should_return = true;
-  else if (!this->first_tasks_.empty() || !this->tasks_.empty())
+  else if (this->have_queued_tasks())
     should_queue = true;
   else
     should_return = true;
@@ -427,11 +895,17 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     }
   else if (should_queue)
     {
-      if (t->should_run_soon())
-	this->first_tasks_.push_back(t);
-      else
-	this->tasks_.push_back(t);
-      this->condvar_.signal();
+      Thread_queue* q = this->thread_queue(thread_number);
+      {
+	Hold_lock hl(q->lock);
+	if (t->should_run_soon())
+	  q->first_tasks.push_back(t);
+	else
+	  q->tasks.push_back(t);
+      }
+      ++this->thread_queued_;
+      ++this->thread_pushes_;
+      this->signal_idle_thread();
       return false;
     }
 
@@ -440,11 +914,11 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
 
 // Release the locks associated with a Task.  Return the first
 // runnable Task that we find.  If we find more runnable tasks, add
-// them to the run queue and signal any other threads.  This must be
-// called with the Workqueue lock held.
+// them to the run queue of THREAD_NUMBER and signal any other
+// threads.  This must be called with the Workqueue lock held.
 
 Task*
-Workqueue::release_locks(Task* t, Task_locker* tl)
+Workqueue::release_locks(Task* t, Task_locker* tl, int thread_number)
 {
   Task* ret = NULL;
   for (Task_locker::iterator p = tl->begin(); p != tl->end(); ++p)
@@ -456,11 +930,13 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	    {
 	      // The token has been unblocked.  Every waiting Task may
 	      // now be runnable.
-	      Task* t;
-	      while ((t = token->remove_first_waiting()) != NULL)
+	      Task* w;
+	      while ((w = token->remove_first_waiting()) != NULL)
 		{
 		  --this->waiting_;
-		  this->return_or_queue(t, true, &ret);
+		  if (this->trace_ != NULL)
+		    this->trace_->release_task(w, t);
+		  this->return_or_queue(w, true, &ret, thread_number);
 		}
 	    }
 	}
@@ -473,11 +949,13 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	  // move all the Tasks to the runnable queue, to avoid a
 	  // potential deadlock if the locking status changes before
 	  // we run the next thread.
-	  Task* t;
-	  while ((t = token->remove_first_waiting()) != NULL)
+	  Task* w;
+	  while ((w = token->remove_first_waiting()) != NULL)
 	    {
 	      --this->waiting_;
-	      if (this->return_or_queue(t, false, &ret))
+	      if (this->trace_ != NULL)
+		this->trace_->release_task(w, t);
+	      if (this->return_or_queue(w, false, &ret, thread_number))
 		break;
 	    }
 	}
@@ -503,12 +981,33 @@ void
 Workqueue::set_thread_count(int threads)
 {
   Hold_lock hl(this->lock_);
-
   this->threader_->set_thread_count(threads);
   // Wake up all the threads, since something has changed.
   this->condvar_.broadcast();
 }
 
+// Queue up to COUNT Tasks to help run the pieces of GROUP.  We put
+// them at the front of the queue, since the Task which called
+// run_parallel_work is waiting for them.  If we are not called from a
+// running Task, no thread may be processing the queue, so we don't
+// queue anything and leave the caller to run all the pieces itself.
+
+void
+Workqueue::add_helpers(Parallel_work_group* group, int count)
+{
+  Hold_lock hl(this->lock_);
+  if (this->running_ == 0)
+    return;
+  for (int i = 0; i < count; ++i)
+    {
+      group->add_ref();
+      Task* t = new Parallel_work_task(group);
+      t->set_should_run_soon();
+      this->first_tasks_.push_front(t);
+      this->signal_idle_thread();
+    }
+}
+
 // Add a new blocker to an existing Task_token.
 
 void
@@ -518,4 +1017,28 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Write the trace of the tasks which were run, for --trace-file.
+
+void
+Workqueue::write_trace()
+{
+  if (this->trace_ == NULL)
+    return;
+  Hold_lock hl(this->lock_);
+  this->trace_->write();
+}
+
+// Print statistics to stderr.  This is used for --stats.
+
+void
+Workqueue::print_stats() const
+{
+  fprintf(stderr, _("%s: workqueue tasks run: %u\n"),
+	  program_name, this->tasks_run_);
+  fprintf(stderr, _("%s: workqueue tasks stolen: %u\n"),
+	  program_name, this->tasks_stolen_);
+  fprintf(stderr, _("%s: workqueue idle waits: %u\n"),
+	  program_name, this->idle_waits_);
+}
+
 } // End namespace gold.
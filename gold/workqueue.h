@@ -28,6 +28,7 @@
 #define GOLD_WORKQUEUE_H
 
 #include <string>
+#include <vector>
 
 #include "gold-threads.h"
 #include "token.h"
@@ -37,6 +38,7 @@ namespace gold
 
 class General_options;
 class Workqueue;
+class Workqueue_trace;
 
 // The superclass for tasks to be placed on the workqueue.  Each
 // specific task class will inherit from this one.
@@ -195,7 +197,7 @@ class Task_function : public Task
 
 class Workqueue_threader;
 
-class Workqueue
+class Workqueue : public Parallel_work_helpers
 {
  public:
   Workqueue(const General_options&);
@@ -233,6 +235,22 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Queue Tasks to help run the pieces of a Parallel_work, for
+  // run_parallel_work.  This does nothing unless it is called from a
+  // running Task.
+  void
+  add_helpers(Parallel_work_group* group, int count);
+
+  // Print statistics about the workqueue to stderr.  This is used
+  // for --stats.
+  void
+  print_stats() const;
+
+  // Write the trace of the tasks which were run to the file named by
+  // --trace-file.  This does nothing if we are not tracing.
+  void
+  write_trace();
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
@@ -242,29 +260,85 @@ class Workqueue
   void
   add_to_queue(Task_list* queue, Task* t, bool front);
 
+  // The run queue of a single thread.  A thread pushes the Tasks
+  // which it makes runnable onto its own queue, and looks there
+  // first for work.  A thread which has nothing else to do steals
+  // Tasks from the queues of the other threads.  Each queue has its
+  // own lock, so that a thread looking for work to steal does not
+  // hold up the other threads.  The number of queues is fixed when
+  // the Workqueue is created; if there are more threads than queues,
+  // some threads share a queue.
+  struct Thread_queue
+  {
+    // Lock controlling the lists.  The Workqueue lock may be held
+    // when this is acquired, but not the other way around.
+    Lock lock;
+    // Tasks to execute soon.
+    Task_list first_tasks;
+    // Tasks to execute after the ones in first_tasks.
+    Task_list tasks;
+  };
+
+  // Return the run queue of THREAD_NUMBER.
+  Thread_queue*
+  thread_queue(int thread_number) const
+  {
+    return this->thread_queues_[static_cast<size_t>(thread_number)
+				% this->thread_queues_.size()];
+  }
+
   // Find a runnable task, or wait for one.
   Task*
   find_runnable_or_wait(int thread_number);
 
   // Find a runnable task.
   Task*
-  find_runnable();
+  find_runnable(int thread_number);
 
   // Find a runnable task in a list.
   Task*
   find_runnable_in_list(Task_list*);
 
+  // Find a runnable task on a thread run queue.
+  Task*
+  find_runnable_in_thread_queue(Thread_queue*, bool first);
+
+  // Return a Task taken from a thread run queue if it may run now.
+  Task*
+  check_runnable(Task*);
+
+  // Take a task from the queue of another thread.
+  Task*
+  steal_task(int thread_number);
+
   // Find an run a task.
   bool
   find_and_run_task(int);
 
   // Release the locks for a Task.  Return the next Task to run.
   Task*
-  release_locks(Task*, Task_locker*);
+  release_locks(Task*, Task_locker*, int thread_number);
 
   // Store T into *PRET, or queue it as appropriate.
   bool
-  return_or_queue(Task* t, bool is_blocker, Task** pret);
+  return_or_queue(Task* t, bool is_blocker, Task** pret, int thread_number);
+
+  // Return whether there are any queued tasks.
+  bool
+  have_queued_tasks() const
+  {
+    return (!this->first_tasks_.empty()
+	    || !this->tasks_.empty()
+	    || this->thread_queued_ > 0);
+  }
+
+  // Wake up a thread waiting for work, if there is one.
+  void
+  signal_idle_thread()
+  {
+    if (this->idle_ > 0)
+      this->condvar_.signal();
+  }
 
   // Return whether to cancel this thread.
   bool
@@ -281,10 +355,36 @@ class Workqueue
   int running_;
   // Number of tasks waiting for a lock to release.
   int waiting_;
+  // The per-thread run queues.  This is not changed after the
+  // Workqueue is created, so it may be read without holding any lock.
+  std::vector<Thread_queue*> thread_queues_;
+  // Number of tasks on the per-thread run queues.  A Task taken off
+  // one of those queues is still counted here until the thread which
+  // took it has started it or has made it wait for a Task_token, so
+  // that no thread decides that there is nothing left to do in the
+  // meantime.
+  int thread_queued_;
+  // Number of Tasks ever pushed onto the per-thread run queues.  A
+  // thread which looks for a Task to steal without holding the
+  // Workqueue lock uses this to see whether it missed one.
+  unsigned int thread_pushes_;
+  // Number of threads waiting on condvar_.
+  int idle_;
   // Condition variable associated with lock_.  This is signalled when
   // there may be a new Task to execute.
   Condvar condvar_;
 
+  // Statistics, for --stats.
+  // Number of tasks run.
+  unsigned int tasks_run_;
+  // Number of tasks taken from the queue of another thread.
+  unsigned int tasks_stolen_;
+  // Number of times a thread waited for a task to become runnable.
+  unsigned int idle_waits_;
+  // The trace of the tasks run, for --trace-file.  This is NULL if
+  // we are not tracing.
+  Workqueue_trace* trace_;
+
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
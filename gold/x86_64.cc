@@ -486,6 +486,17 @@ class Target_x86_64 : public Sized_target<size, false>
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols);
 
+  // Drop the relocations which scan_relocs would ignore.
+  unsigned char*
+  prescan_relocs(Symbol_table* symtab,
+		 Sized_relobj_file<size, false>* object,
+		 unsigned int sh_type,
+		 const unsigned char* prelocs,
+		 size_t reloc_count,
+		 size_t local_symbol_count,
+		 const unsigned char* plocal_symbols,
+		 size_t* kept_count);
+
   // Finalize the sections.
   void
   do_finalize_sections(Layout*, const Input_objects*, Symbol_table*);
@@ -595,6 +606,12 @@ class Target_x86_64 : public Sized_target<size, false>
   do_can_check_for_function_pointers() const
   { return !parameters->options().pie(); }
 
+  // We can drop the relocations which need no GOT or PLT entry or
+  // dynamic relocation before scanning them.
+  bool
+  do_can_prescan_relocs() const
+  { return true; }
+
   // Return the base for a DW_EH_PE_datarel encoding.
   uint64_t
   do_ehframe_datarel_base() const;
@@ -744,6 +761,9 @@ class Target_x86_64 : public Sized_target<size, false>
     static inline int
     get_reference_flags(unsigned int r_type);
 
+    static inline bool
+    reloc_is_nop_for_local_def(unsigned int r_type);
+
     inline void
     local(Symbol_table* symtab, Layout* layout, Target_x86_64* target,
 	  Sized_relobj_file<size, false>* object,
@@ -2309,6 +2329,43 @@ Target_x86_64<size>::Scan::get_reference_flags(unsigned int r_type)
     }
 }
 
+// Return true if scanning a relocation of type R_TYPE does nothing
+// when the symbol is defined in this link unit, is not preemptible,
+// and is not a STT_GNU_IFUNC symbol.  In that case the relocation
+// needs no GOT or PLT entry and no dynamic relocation.
+
+template<int size>
+inline bool
+Target_x86_64<size>::Scan::reloc_is_nop_for_local_def(unsigned int r_type)
+{
+  switch (r_type)
+    {
+    case elfcpp::R_X86_64_NONE:
+    case elfcpp::R_X86_64_GNU_VTINHERIT:
+    case elfcpp::R_X86_64_GNU_VTENTRY:
+    case elfcpp::R_X86_64_PC64:
+    case elfcpp::R_X86_64_PC32:
+    case elfcpp::R_X86_64_PC32_BND:
+    case elfcpp::R_X86_64_PC16:
+    case elfcpp::R_X86_64_PC8:
+    case elfcpp::R_X86_64_PLT32:
+    case elfcpp::R_X86_64_PLT32_BND:
+      return true;
+
+    case elfcpp::R_X86_64_64:
+    case elfcpp::R_X86_64_32:
+    case elfcpp::R_X86_64_32S:
+    case elfcpp::R_X86_64_16:
+    case elfcpp::R_X86_64_8:
+      // These need a dynamic relocation in position-independent
+      // output.
+      return !parameters->options().output_is_position_independent();
+
+    default:
+      return false;
+    }
+}
+
 // Report an unsupported relocation against a local symbol.
 
 template<int size>
@@ -3337,6 +3394,83 @@ Target_x86_64<size>::scan_relocs(Symbol_table* symtab,
     plocal_symbols);
 }
 
+// Prescan relocations for a section.  This runs in parallel for
+// different objects, ahead of the Scan_relocs tasks which must run
+// one at a time.  Copy out the relocations which may still need a GOT
+// or PLT entry or a dynamic relocation, dropping the ones for which
+// Scan::local or Scan::global would do nothing.  Those are most of
+// them: calls and PC-relative references to symbols defined in the
+// output file.  The relocations which are kept are passed on in their
+// original order, so scanning allocates the GOT, PLT and dynamic
+// relocations exactly as it would if it saw all of them.
+
+template<int size>
+unsigned char*
+Target_x86_64<size>::prescan_relocs(Symbol_table* symtab,
+				    Sized_relobj_file<size, false>* object,
+				    unsigned int sh_type,
+				    const unsigned char* prelocs,
+				    size_t reloc_count,
+				    size_t local_symbol_count,
+				    const unsigned char* plocal_symbols,
+				    size_t* kept_count)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, false>
+      Classify_reloc;
+  typedef typename Classify_reloc::Reltype Reltype;
+  const int reloc_size = Classify_reloc::reloc_size;
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  // scan_relocs reports an error for these.
+  if (sh_type == elfcpp::SHT_REL)
+    return NULL;
+
+  unsigned char* kept = new unsigned char[reloc_count * reloc_size];
+  unsigned char* pkept = kept;
+  for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
+    {
+      Reltype reloc(prelocs);
+      unsigned int r_sym = Classify_reloc::get_r_sym(&reloc);
+      unsigned int r_type = Classify_reloc::get_r_type(&reloc);
+
+      bool keep = true;
+      if (Scan::reloc_is_nop_for_local_def(r_type))
+	{
+	  if (r_sym < local_symbol_count)
+	    {
+	      if (plocal_symbols != NULL)
+		{
+		  elfcpp::Sym<size, false> lsym(plocal_symbols
+						+ r_sym * sym_size);
+		  keep = lsym.get_st_type() == elfcpp::STT_GNU_IFUNC;
+		}
+	    }
+	  else
+	    {
+	      Symbol* gsym = object->global_symbol(r_sym);
+	      if (gsym != NULL)
+		{
+		  if (gsym->is_forwarder())
+		    gsym = symtab->resolve_forwards(gsym);
+		  keep = (gsym->type() == elfcpp::STT_GNU_IFUNC
+			  || !gsym->is_defined()
+			  || gsym->is_from_dynobj()
+			  || gsym->is_preemptible());
+		}
+	    }
+	}
+
+      if (keep)
+	{
+	  memcpy(pkept, prelocs, reloc_size);
+	  pkept += reloc_size;
+	}
+    }
+
+  *kept_count = (pkept - kept) / reloc_size;
+  return kept;
+}
+
 // Finalize the sections.
 
 template<int size>